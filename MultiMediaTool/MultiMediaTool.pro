@@ -16,6 +16,8 @@ CONFIG += c++11
 SOURCES += \
     src/base/dragdrophandler.cpp \
     src/base/ipcmgrbase.cpp \
+    src/base/jobscheduler.cpp \
+    src/base/mediascanner.cpp \
     src/gui/application.cpp \
     src/gui/basewindow.cpp \
     src/gui/input/easyoilpainting.cpp \
@@ -51,6 +53,8 @@ SOURCES += \
 HEADERS += \
     src/base/dragdrophandler.h \
     src/base/ipcmgrbase.h \
+    src/base/jobscheduler.h \
+    src/base/mediascanner.h \
     src/gui/application.h \
     src/gui/basewindow.h \
     src/gui/input/easyoilpainting.h \
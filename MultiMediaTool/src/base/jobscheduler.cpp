@@ -0,0 +1,107 @@
+#include "src/base/jobscheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QPointer>
+
+namespace {
+
+// 一次提交的上下文，由作业结束后投递到GUI线程的收尾函数释放
+struct PendingJob {
+    std::function<int()> work;
+    std::function<void(int, bool)> done;
+    QPointer<QObject> context;
+    int priority = JobScheduler::Batch;
+    int result = -1;
+};
+
+// 排队超过该时长时打印调度器状态，便于观察是否超订
+const int64_t kLogWaitMs = 200;
+
+int runJob(void *user)
+{
+    PendingJob *job = static_cast<PendingJob *>(user);
+    job->result = job->work ? job->work() : -1;
+    return job->result;
+}
+
+// 在作业线程中调用，只在最终状态时投递收尾
+void onJobProgress(int jobId, const AvJobProgress *progress, void *user)
+{
+    if (progress->state != AvJobSucceeded && progress->state != AvJobFailed
+        && progress->state != AvJobCancelled) {
+        return;
+    }
+    PendingJob *job = static_cast<PendingJob *>(user);
+    bool cancelled = progress->state == AvJobCancelled;
+    int64_t waitMs = progress->wait_ms;
+    QMetaObject::invokeMethod(JobScheduler::instance(), [jobId, job, cancelled, waitMs]() {
+        if (waitMs >= kLogWaitMs) {
+            AvSchedulerStats stats = JobScheduler::instance()->stats();
+            qDebug() << "[JobScheduler] 作业" << jobId << "优先级" << job->priority << "排队" << waitMs << "ms,"
+                     << "线程" << stats.threads_in_use << "/" << stats.thread_limit
+                     << "排队中 交互" << stats.queued_interactive << "批处理" << stats.queued_batch
+                     << "平均等待" << stats.avg_wait_ms << "ms 最长" << stats.max_wait_ms << "ms";
+        }
+        if (job->context && job->done) {
+            job->done(job->result, cancelled);
+        }
+        AvJob_Release(jobId);
+        delete job;
+    }, Qt::QueuedConnection);
+}
+
+} // namespace
+
+JobScheduler *JobScheduler::instance()
+{
+    static JobScheduler *scheduler = new JobScheduler(qApp);
+    return scheduler;
+}
+
+JobScheduler::JobScheduler(QObject *parent)
+    : QObject(parent)
+{
+    // 退出前取消全部作业并join调度器的工作线程，避免DLL卸载时仍有线程在跑
+    connect(qApp, &QCoreApplication::aboutToQuit, this, []() {
+        AvJob_Shutdown(true);
+    });
+}
+
+int JobScheduler::submit(Priority priority, int threads, std::function<int()> work,
+                         QObject *context, std::function<void(int, bool)> done)
+{
+    PendingJob *job = new PendingJob;
+    job->work = std::move(work);
+    job->done = std::move(done);
+    job->context = context;
+    job->priority = priority;
+
+    int id = AvJob_SubmitTask(runJob, job, priority, threads, onJobProgress, job);
+    if (id < 0) {
+        qDebug() << "[JobScheduler] 提交作业失败";
+        delete job;
+    }
+    return id;
+}
+
+void JobScheduler::cancel(int id)
+{
+    if (id >= 0) {
+        AvJob_Cancel(id);
+    }
+}
+
+void JobScheduler::wait(int id)
+{
+    if (id >= 0) {
+        AvJob_Wait(id);
+    }
+}
+
+AvSchedulerStats JobScheduler::stats() const
+{
+    AvSchedulerStats stats = {};
+    AvJob_GetSchedulerStats(&stats);
+    return stats;
+}
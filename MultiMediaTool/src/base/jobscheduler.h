@@ -0,0 +1,45 @@
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <QObject>
+#include <functional>
+
+#include "OpenCVFFMpegTools.h"
+
+// 界面侧的作业入口，封装OpenCVTools里进程内唯一的调度器（AvJob_SubmitTask）
+// 特效、图片滤镜、格式转换、缩略图探测等耗时操作都经这里派发，
+// 由调度器按各作业声明的线程数把总线程数限制在CPU核数以内，交互作业优先。
+// formatChange不链接OpenCVTools，它的AVProcessor调用也从这里以任务形式提交
+// 程序退出（aboutToQuit）时取消全部作业并等待工作线程结束
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Interactive = AvJobInteractive, // 预览、缩略图、单张图片
+        Batch = AvJobBatch              // 视频特效、转码、转换
+    };
+
+    static JobScheduler *instance();
+
+    // 提交作业，立即返回作业id（失败返回-1）
+    // work在调度线程中执行，返回0表示成功；threads为work自身会用到的线程数，0表示全部核
+    // done在GUI线程调用：result为work的返回值（未执行时为-1），cancelled表示作业被取消；
+    // context被销毁后不再调用done
+    int submit(Priority priority, int threads, std::function<int()> work,
+               QObject *context, std::function<void(int result, bool cancelled)> done);
+
+    // 取消作业：排队中的不再执行，运行中的在下一次检查取消时停止
+    void cancel(int id);
+    // 阻塞到作业结束（只用于退出前收尾，done仍会异步投递）
+    void wait(int id);
+
+    // 调度器当前的线程占用、队列深度和排队时间
+    AvSchedulerStats stats() const;
+
+private:
+    explicit JobScheduler(QObject *parent = nullptr);
+};
+
+#endif // JOBSCHEDULER_H
@@ -0,0 +1,232 @@
+#include "src/base/mediascanner.h"
+#include "src/base/jobscheduler.h"
+#include "src/utils/encodinghelper.h"
+#include "OpenCVFFMpegTools.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <memory>
+
+MediaScanner *MediaScanner::instance()
+{
+    static MediaScanner *scanner = new MediaScanner(qApp);
+    return scanner;
+}
+
+MediaScanner::MediaScanner(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+    qRegisterMetaType<MediaInfo>("MediaInfo");
+
+    m_worker = AvWorker_Create();
+    if (!m_worker) {
+        qDebug() << "[MediaScanner] AvWorker_Create failed!";
+    }
+    // DLL内的元数据索引与本缓存放在同一目录，其它页面/工具查时长也会命中
+    QDir().mkpath(QFileInfo(cachePath()).absolutePath());
+    MediaIndex_Open(QString2GBK(QFileInfo(cachePath()).absolutePath() + "/media_index.bin").constData());
+    loadCache();
+}
+
+MediaScanner::~MediaScanner()
+{
+    QList<int> jobs = m_jobs;
+    cancel();
+    for (int id : jobs) {
+        JobScheduler::instance()->wait(id);
+    }
+    if (m_dirty) {
+        saveCache();
+    }
+    if (m_worker) {
+        AvWorker_Destroy(m_worker);
+        m_worker = nullptr;
+    }
+}
+
+QString MediaScanner::cachePath() const
+{
+    return QCoreApplication::applicationDirPath() + "/cache/media_cache.json";
+}
+
+int MediaScanner::scan(const QFileInfoList &files)
+{
+    int generation = m_generation.fetchAndAddOrdered(1) + 1;
+    // 上一次扫描还没开始的探测不再需要
+    for (int id : m_jobs) {
+        JobScheduler::instance()->cancel(id);
+    }
+    m_pending = 0;
+
+    QList<QFileInfo> misses;
+    for (const QFileInfo &fileInfo : files) {
+        MediaInfo info;
+        if (lookup(fileInfo, info)) {
+            emit fileScanned(info);
+        } else {
+            misses.append(fileInfo);
+        }
+    }
+
+    if (misses.isEmpty()) {
+        emit scanFinished(generation);
+        return generation;
+    }
+
+    m_pending = misses.size();
+    qDebug() << "[MediaScanner] 扫描" << files.size() << "个文件，需探测" << misses.size() << "个";
+    for (const QFileInfo &fileInfo : misses) {
+        // 缩略图直接影响界面，按交互作业派发，排在视频批处理之前
+        std::shared_ptr<MediaInfo> info = std::make_shared<MediaInfo>();
+        std::shared_ptr<int> jobId = std::make_shared<int>(-1);
+        int id = JobScheduler::instance()->submit(JobScheduler::Interactive, 1, [this, fileInfo, generation, info]() -> int {
+            // 已被新的扫描取代，直接跳过
+            if (m_generation.loadAcquire() != generation) {
+                return -1;
+            }
+            *info = probe(fileInfo);
+            return 0;
+        }, this, [this, generation, info, jobId](int result, bool cancelled) {
+            // 收尾投递到GUI线程，此时submit早已返回，jobId已填好
+            m_jobs.removeOne(*jobId);
+            if (result == 0 && !cancelled) {
+                onProbed(generation, *info);
+            }
+        });
+        if (id >= 0) {
+            *jobId = id;
+            m_jobs.append(id);
+        }
+    }
+    return generation;
+}
+
+void MediaScanner::cancel()
+{
+    m_generation.fetchAndAddOrdered(1);
+    for (int id : m_jobs) {
+        JobScheduler::instance()->cancel(id); // 丢弃尚未开始的探测
+    }
+    m_pending = 0;
+}
+
+bool MediaScanner::lookup(const QFileInfo &fileInfo, MediaInfo &info) const
+{
+    auto it = m_cache.constFind(fileInfo.absoluteFilePath());
+    if (it == m_cache.constEnd()) {
+        return false;
+    }
+    if (it->size != fileInfo.size() || it->mtime != fileInfo.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+    info = *it;
+    info.fromCache = true;
+    return true;
+}
+
+MediaInfo MediaScanner::probe(const QFileInfo &fileInfo) const
+{
+    MediaInfo info;
+    info.path = fileInfo.absoluteFilePath();
+    info.size = fileInfo.size();
+    info.mtime = fileInfo.lastModified().toMSecsSinceEpoch();
+    if (!m_worker) {
+        return info;
+    }
+
+    QByteArray gbkPath = QString2GBK(info.path);
+    info.duration = AvWorker_getDuration(m_worker, gbkPath.constData());
+
+    // 缩略图同样经索引获取（120x80 JPEG）
+    unsigned char *data = nullptr;
+    int size = 0;
+    if (MediaIndex_GetThumbnail(gbkPath.constData(), &data, &size)) {
+        info.thumbJpeg = QByteArray(reinterpret_cast<const char *>(data), size);
+        AvWorker_FreeBuffer(data);
+        info.thumbnail = QImage::fromData(info.thumbJpeg, "JPG");
+    }
+    return info;
+}
+
+void MediaScanner::onProbed(int generation, const MediaInfo &info)
+{
+    // 失败的结果也缓存，损坏的文件不必每次刷新都重试
+    m_cache.insert(info.path, info);
+    m_dirty = true;
+
+    if (generation != m_generation.loadAcquire()) {
+        return;
+    }
+    emit fileScanned(info);
+
+    if (--m_pending <= 0) {
+        saveCache();
+        emit scanFinished(generation);
+    }
+}
+
+void MediaScanner::loadCache()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonArray entries = QJsonDocument::fromJson(file.readAll()).array();
+    for (const QJsonValue &value : entries) {
+        QJsonObject obj = value.toObject();
+        MediaInfo info;
+        info.path = obj.value("path").toString();
+        info.size = static_cast<qint64>(obj.value("size").toDouble());
+        info.mtime = static_cast<qint64>(obj.value("mtime").toDouble());
+        info.duration = obj.value("duration").toDouble(-1.0);
+        info.thumbJpeg = QByteArray::fromBase64(obj.value("thumb").toString().toLatin1());
+        if (!info.thumbJpeg.isEmpty()) {
+            info.thumbnail = QImage::fromData(info.thumbJpeg, "JPG");
+        }
+        if (!info.path.isEmpty()) {
+            m_cache.insert(info.path, info);
+        }
+    }
+    qDebug() << "[MediaScanner] 载入缓存" << m_cache.size() << "条";
+}
+
+void MediaScanner::saveCache()
+{
+    QDir().mkpath(QFileInfo(cachePath()).absolutePath());
+
+    QJsonArray entries;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        // 已删除的文件不再保留
+        if (!QFileInfo::exists(it->path)) {
+            continue;
+        }
+        QJsonObject obj;
+        obj.insert("path", it->path);
+        obj.insert("size", static_cast<double>(it->size));
+        obj.insert("mtime", static_cast<double>(it->mtime));
+        obj.insert("duration", it->duration);
+        obj.insert("thumb", QString::fromLatin1(it->thumbJpeg.toBase64()));
+        entries.append(obj);
+    }
+
+    // QSaveFile先写临时文件再替换，中途退出不会留下半个缓存
+    QSaveFile file(cachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "[MediaScanner] 写缓存失败:" << cachePath();
+        return;
+    }
+    file.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+    if (file.commit()) {
+        m_dirty = false;
+    }
+    MediaIndex_Flush();
+}
@@ -0,0 +1,77 @@
+#ifndef MEDIASCANNER_H
+#define MEDIASCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QImage>
+#include <QByteArray>
+#include <QFileInfoList>
+#include <QList>
+#include <QAtomicInt>
+#include <QMetaType>
+
+// 单个媒体文件的探测结果
+struct MediaInfo {
+    QString path;
+    qint64 size = 0;        // 文件大小（字节）
+    qint64 mtime = 0;       // 修改时间（毫秒时间戳）
+    double duration = -1.0; // 时长（秒），探测失败为-1
+    QByteArray thumbJpeg;   // 缩略图JPEG数据，写入缓存文件
+    QImage thumbnail;       // 由thumbJpeg解出的缩略图，为空表示没有
+    bool fromCache = false;
+};
+Q_DECLARE_METATYPE(MediaInfo)
+
+// 媒体库后台扫描器
+// 每个文件作为一个单线程交互作业交给JobScheduler并行探测时长和缩略图，每探测完一个文件发一次fileScanned；
+// 结果按 (路径, 大小, 修改时间) 缓存到磁盘，文件未变时不再重新探测。
+// videoPage和concat共用同一个实例，缓存也共享
+class MediaScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MediaScanner *instance();
+    ~MediaScanner();
+
+    // 开始扫描，会作废上一次尚未完成的扫描
+    // 缓存命中的文件立即同步发出fileScanned，其余提交给调度器
+    // 返回值：本次扫描的序号，与scanFinished的参数对应
+    int scan(const QFileInfoList &files);
+
+    // 作废当前扫描（排队中的探测不再执行，已在执行的会跑完，但结果被丢弃）
+    void cancel();
+
+    // 查询缓存，文件大小/修改时间不一致视为未命中
+    bool lookup(const QFileInfo &fileInfo, MediaInfo &info) const;
+
+    // 缩略图的最大尺寸（与MediaIndex生成的缩略图一致）
+    static const int kThumbWidth = 120;
+    static const int kThumbHeight = 80;
+
+signals:
+    void fileScanned(const MediaInfo &info);
+    void scanFinished(int generation);
+
+private:
+    explicit MediaScanner(QObject *parent = nullptr);
+
+    // 在工作线程中执行
+    MediaInfo probe(const QFileInfo &fileInfo) const;
+    // 回到GUI线程处理一个探测结果
+    void onProbed(int generation, const MediaInfo &info);
+
+    void loadCache();
+    void saveCache();
+    QString cachePath() const;
+
+    QList<int> m_jobs;                 // 尚未结束的探测作业，仅在GUI线程访问
+    void *m_worker = nullptr;          // AvWorker无成员状态，多个线程可共用
+    QHash<QString, MediaInfo> m_cache; // 仅在GUI线程访问
+    QAtomicInt m_generation;
+    int m_pending = 0;
+    bool m_dirty = false;
+};
+
+#endif // MEDIASCANNER_H
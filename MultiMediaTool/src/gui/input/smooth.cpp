@@ -18,5 +18,6 @@ param smooth::getParams() const
 {
     param p;
     memset(&p, 0, sizeof(p));
+    p.iparam1 = ui->checkBox_fast->isChecked() ? 1 : 0; // 1为快速模式
     return p;
 }
@@ -10,6 +10,7 @@
 #include <QFileDialog>
 #include <QCoreApplication>
 #include <QDebug>
+#include <vector>
 
 // GBKתUTF8(ȷĿиúʵ)
 std::string gbk_to_utf8(const std::string& gbk_str);
@@ -18,7 +19,8 @@ concat::concat(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::concat),
     m_worker(nullptr),
-    m_progressWidget(nullptr)
+    m_progressWidget(nullptr),
+    m_jobId(-1)
 {
     ui->setupUi(this);
 
@@ -31,8 +33,17 @@ concat::concat(QWidget *parent) :
     m_progressBar = new QProgressBar();
     m_progressBar->setRange(0, 0); // ޽
     
+    m_cancelButton = new QPushButton(QString::fromUtf8(gbk_to_utf8("ȡ").c_str()));
+    connect(m_cancelButton, &QPushButton::clicked, this, &concat::onCancelJob);
+
     progressLayout->addWidget(m_progressLabel);
     progressLayout->addWidget(m_progressBar);
+    progressLayout->addWidget(m_cancelButton);
+
+    // ϲ/ָ/СDLLҵִ߳У涨ʱѯ
+    m_jobTimer = new QTimer(this);
+    m_jobTimer->setInterval(200);
+    connect(m_jobTimer, &QTimer::timeout, this, &concat::onJobTimer);
     progressLayout->setContentsMargins(10, 5, 10, 5);
     
     ui->verticalLayout->insertWidget(2, m_progressWidget);
@@ -53,6 +64,9 @@ concat::concat(QWidget *parent) :
         qDebug() << "AvWorker_Create failed!";
     }
 
+    // ̨ɨ赽ʱл
+    connect(MediaScanner::instance(), &MediaScanner::fileScanned, this, &concat::onMediaScanned);
+
     loadVideoFiles();
 
     //connect(ui->btn_Refresh, &QPushButton::clicked, this, &concat::on_btn_Refresh_clicked);
@@ -64,6 +78,12 @@ concat::concat(QWidget *parent) :
 
 concat::~concat()
 {
+    if (m_jobId >= 0) {
+        AvJob_Cancel(m_jobId);
+        AvJob_Wait(m_jobId);
+        AvJob_Release(m_jobId);
+        m_jobId = -1;
+    }
     if (m_worker) {
         AvWorker_Destroy(m_worker);
         m_worker = nullptr;
@@ -104,6 +124,7 @@ void concat::loadVideoFiles()
     ui->tableWidget->setRowCount(fileList.size());
 
     int validFileIndex = 0;
+    QFileInfoList scanList;
     for (int i = 0; i < fileList.size(); ++i) {
         QFileInfo fileInfo = fileList.at(i);
         
@@ -114,17 +135,16 @@ void concat::loadVideoFiles()
             
             if (validSuffixes.contains(suffix)) {
                 m_videoFiles.append(fileInfo.absoluteFilePath());
+                scanList.append(fileInfo);
 
                 QTableWidgetItem* checkItem = new QTableWidgetItem();
                 checkItem->setCheckState(Qt::Unchecked);
                 ui->tableWidget->setItem(validFileIndex, 0, checkItem);
 
-                // ʾļʹС
-                QString fileName = fileInfo.fileName();
-                QString fileSize = QString::number(fileInfo.size() / (1024.0 * 1024.0), 'f', 2) + " MB";
-                QString displayText = fileName + " (" + fileSize + ")";
-                
-                ui->tableWidget->setItem(validFileIndex, 1, new QTableWidgetItem(displayText));
+                // ʾļʹСʱɺ̨ɨ
+                MediaInfo mediaInfo;
+                double duration = MediaScanner::instance()->lookup(fileInfo, mediaInfo) ? mediaInfo.duration : -1.0;
+                ui->tableWidget->setItem(validFileIndex, 1, new QTableWidgetItem(displayText(fileInfo, duration)));
                 ui->tableWidget->setItem(validFileIndex, 2, new QTableWidgetItem(fileInfo.absoluteFilePath()));
                 
                 validFileIndex++;
@@ -144,6 +164,33 @@ void concat::loadVideoFiles()
     }
 
     updateButtonStates();
+
+    // ֻ̽⻺ûеļ
+    MediaScanner::instance()->scan(scanList);
+}
+
+QString concat::displayText(const QFileInfo& fileInfo, double duration)
+{
+    QString fileSize = QString::number(fileInfo.size() / (1024.0 * 1024.0), 'f', 2) + " MB";
+    QString text = fileInfo.fileName() + " (" + fileSize;
+    if (duration >= 0) {
+        int seconds = static_cast<int>(duration);
+        text += QString(", %1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+    return text + ")";
+}
+
+void concat::onMediaScanned(const MediaInfo& info)
+{
+    int row = m_videoFiles.indexOf(info.path);
+    if (row < 0 || row >= ui->tableWidget->rowCount()) {
+        return;
+    }
+    QTableWidgetItem* item = ui->tableWidget->item(row, 1);
+    if (item) {
+        // ֻᴥitemChangedֻ0УӰ카ѡ߼
+        item->setText(displayText(QFileInfo(info.path), info.duration));
+    }
 }
 
 QStringList concat::getSelectedVideos()
@@ -163,7 +210,7 @@ void concat::updateButtonStates()
     QStringList selected = getSelectedVideos();
     int count = selected.size();
 
-    ui->btn_Merge->setEnabled(count == 2);
+    ui->btn_Merge->setEnabled(count >= 2);
     ui->btn_Split->setEnabled(count == 1);
     ui->btn_Resize->setEnabled(count == 1);
 }
@@ -176,15 +223,6 @@ void concat::on_btn_Refresh_clicked()
 void concat::on_tableWidget_itemChanged(QTableWidgetItem *item)
 {
     if (item->column() == 0) {
-        QStringList selected = getSelectedVideos();
-        if (selected.size() > 2) {
-            item->setCheckState(Qt::Unchecked);
-            // ޸ʾʾϢ
-            QMessageBox::warning(this,
-                QString::fromUtf8(gbk_to_utf8("ʾ").c_str()),
-                QString::fromUtf8(gbk_to_utf8("ֻѡ2Ƶ").c_str()));
-            return;
-        }
         updateButtonStates();
     }
 }
@@ -192,10 +230,10 @@ void concat::on_tableWidget_itemChanged(QTableWidgetItem *item)
 void concat::on_btn_Merge_clicked()
 {
     QStringList selected = getSelectedVideos();
-    if (selected.size() != 2) {
+    if (selected.size() < 2) {
         QMessageBox::warning(this,
             QString::fromUtf8(gbk_to_utf8("ʾ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("ѡ2Ƶкϲ").c_str()));
+            QString::fromUtf8(gbk_to_utf8("ѡ2Ƶкϲ").c_str()));
         return;
     }
 
@@ -214,26 +252,24 @@ void concat::on_btn_Merge_clicked()
         return;
     }
 
-    showProgress(QString::fromUtf8(gbk_to_utf8("ںϲƵ...").c_str()));
-
-    bool result = AvWorker_SpliceAV(m_worker,
-                                     selected.at(0).toUtf8().constData(),
-                                     selected.at(1).toUtf8().constData(),
-                                     outputFile.toUtf8().constData(),
-                                     false);
-
-    hideProgress();
-
-    if (result) {
-        QMessageBox::information(this,
-            QString::fromUtf8(gbk_to_utf8("ɹ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("Ƶϲɹ").c_str()));
-        loadVideoFiles(); // ˢļб
-    } else {
-        QMessageBox::critical(this,
-            QString::fromUtf8(gbk_to_utf8("ʧ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("Ƶϲʧܣ").c_str()));
+    // ѡļڱеƴӣ빴ѡȺ޹أ
+    std::vector<QByteArray> paths;
+    std::vector<const char*> urls;
+    for (const QString& file : selected) {
+        paths.push_back(file.toUtf8());
+    }
+    for (const QByteArray& path : paths) {
+        urls.push_back(path.constData());
     }
+
+    int jobId = AvJob_SubmitSpliceMulti(urls.data(),
+                                        static_cast<int>(urls.size()),
+                                        outputFile.toUtf8().constData(),
+                                        nullptr, nullptr);
+    startJob(jobId,
+        QString::fromUtf8(gbk_to_utf8("ںϲƵ...").c_str()),
+        QString::fromUtf8(gbk_to_utf8("Ƶϲɹ").c_str()),
+        QString::fromUtf8(gbk_to_utf8("Ƶϲʧܣ").c_str()));
 }
 
 void concat::on_btn_Split_clicked()
@@ -272,26 +308,16 @@ void concat::on_btn_Split_clicked()
         return;
     }
 
-    showProgress(QString::fromUtf8(gbk_to_utf8("ڷָƵ...").c_str()));
-
-    bool result = AvWorker_split_video(m_worker,
-                                       selected.at(0).toUtf8().constData(),
+    // ܼУ֡ȷֻرGOPʣಿ
+    int jobId = AvJob_SubmitSplitSmart(selected.at(0).toUtf8().constData(),
                                        outputFile.toUtf8().constData(),
                                        startTime,
-                                       duration);
-
-    hideProgress();
-
-    if (result) {
-        QMessageBox::information(this,
-            QString::fromUtf8(gbk_to_utf8("ɹ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("Ƶָɹ").c_str()));
-        loadVideoFiles(); // ˢļб
-    } else {
-        QMessageBox::critical(this,
-            QString::fromUtf8(gbk_to_utf8("ʧ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("Ƶָʧܣ").c_str()));
-    }
+                                       duration,
+                                       nullptr, nullptr);
+    startJob(jobId,
+        QString::fromUtf8(gbk_to_utf8("ڷָƵ...").c_str()),
+        QString::fromUtf8(gbk_to_utf8("Ƶָɹ").c_str()),
+        QString::fromUtf8(gbk_to_utf8("Ƶָʧܣ").c_str()));
 }
 
 void concat::on_btn_Resize_clicked()
@@ -330,25 +356,78 @@ void concat::on_btn_Resize_clicked()
         return;
     }
 
-    showProgress(QString::fromUtf8(gbk_to_utf8("ڵƵС...").c_str()));
+    int jobId = AvJob_SubmitResize(selected.at(0).toUtf8().constData(),
+                                   outputFile.toUtf8().constData(),
+                                   width,
+                                   height,
+                                   ResizePresetBalanced,
+                                   nullptr, nullptr);
+    startJob(jobId,
+        QString::fromUtf8(gbk_to_utf8("ڵƵС...").c_str()),
+        QString::fromUtf8(gbk_to_utf8("ƵСɹ").c_str()),
+        QString::fromUtf8(gbk_to_utf8("ƵСʧܣ").c_str()));
+}
 
-    bool result = AvWorker_resize_video(m_worker,
-                                        selected.at(0).toUtf8().constData(),
-                                        outputFile.toUtf8().constData(),
-                                        width,
-                                        height);
+void concat::startJob(int jobId, const QString& title, const QString& okText, const QString& failText)
+{
+    if (jobId < 0) {
+        QMessageBox::critical(this, QString::fromUtf8(gbk_to_utf8("ʧ").c_str()), failText);
+        return;
+    }
+    m_jobId = jobId;
+    m_jobTitle = title;
+    m_jobOkText = okText;
+    m_jobFailText = failText;
+    m_progressBar->setRange(0, 0);
+    m_cancelButton->setEnabled(true);
+    showProgress(title);
+    m_jobTimer->start();
+}
+
+void concat::onJobTimer()
+{
+    AvJobProgress progress;
+    if (m_jobId < 0 || !AvJob_GetProgress(m_jobId, &progress)) {
+        m_jobTimer->stop();
+        hideProgress();
+        return;
+    }
 
+    if (progress.state == AvJobQueued || progress.state == AvJobRunning) {
+        if (progress.duration_ms > 0) {
+            int permille = static_cast<int>(qBound<int64_t>(0, progress.pts_ms * 1000 / progress.duration_ms, 1000));
+            m_progressBar->setRange(0, 1000);
+            m_progressBar->setValue(permille);
+            m_progressLabel->setText(QString("%1 %2%").arg(m_jobTitle).arg(permille / 10.0, 0, 'f', 1));
+        }
+        return;
+    }
+
+    // ҵ
+    m_jobTimer->stop();
+    AvJob_Release(m_jobId);
+    m_jobId = -1;
     hideProgress();
 
-    if (result) {
+    if (progress.state == AvJobSucceeded) {
         QMessageBox::information(this,
-            QString::fromUtf8(gbk_to_utf8("ɹ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("ƵСɹ").c_str()));
+            QString::fromUtf8(gbk_to_utf8("ɹ").c_str()), m_jobOkText);
         loadVideoFiles(); // ˢļб
+    } else if (progress.state == AvJobCancelled) {
+        QMessageBox::information(this,
+            QString::fromUtf8(gbk_to_utf8("ʾ").c_str()),
+            QString::fromUtf8(gbk_to_utf8("ȡ").c_str()));
     } else {
         QMessageBox::critical(this,
-            QString::fromUtf8(gbk_to_utf8("ʧ").c_str()),
-            QString::fromUtf8(gbk_to_utf8("ƵСʧܣ").c_str()));
+            QString::fromUtf8(gbk_to_utf8("ʧ").c_str()), m_jobFailText);
+    }
+}
+
+void concat::onCancelJob()
+{
+    if (m_jobId >= 0) {
+        AvJob_Cancel(m_jobId);
+        m_cancelButton->setEnabled(false);
     }
 }
 
@@ -9,7 +9,11 @@
 #include <QDebug>
 #include <QProgressBar>
 #include <QLabel>
+#include <QPushButton>
+#include <QTimer>
 #include <QHBoxLayout>
+#include <QFileInfo>
+#include "src/base/mediascanner.h"
 
 namespace Ui {
 class concat;
@@ -29,14 +33,20 @@ private slots:
     void on_btn_Split_clicked();
     void on_btn_Resize_clicked();
     void on_tableWidget_itemChanged(QTableWidgetItem *item);
+    void onMediaScanned(const MediaInfo& info);
+    void onJobTimer();
+    void onCancelJob();
 
 private:
     void loadVideoFiles();
+    static QString displayText(const QFileInfo& fileInfo, double duration);
     void updateButtonStates();
     QString getVideoDir();
     QStringList getSelectedVideos();
     void showProgress(const QString& title);
     void hideProgress();
+    // 后台作业：提交后轮询进度，结束时提示okText/failText
+    void startJob(int jobId, const QString& title, const QString& okText, const QString& failText);
     bool validateVideoFile(const QString& filePath);
 
     Ui::concat *ui;
@@ -45,6 +55,12 @@ private:
     QWidget* m_progressWidget;
     QProgressBar* m_progressBar;
     QLabel* m_progressLabel;
+    QPushButton* m_cancelButton;
+    QTimer* m_jobTimer;
+    int m_jobId;
+    QString m_jobTitle;
+    QString m_jobOkText;
+    QString m_jobFailText;
 };
 
 #endif // CONCAT_H
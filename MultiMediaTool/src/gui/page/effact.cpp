@@ -4,7 +4,7 @@
 #include <QFileDialog>
 #include <QDir>
 #include <QDebug>
-#include <QtConcurrent>
+#include "src/base/jobscheduler.h"
 #include <QMessageBox>
 #include <cstring>
 
@@ -228,20 +228,32 @@ void effact::on_ok_clicked()
         break;
     }
 
-    int processRet = VideoTrans_Process(trans, effectType, mParam);
-    if (processRet != 0) {
-        qDebug() << "Ƶʧܣ:" << processRet;
-        QMessageBox::critical(this, gbk_to_utf8("ʧ").c_str(),
-                              QString(gbk_to_utf8(": %1").c_str()).arg(processRet));
-        VideoTrans_Destroy(trans);
-        trans = nullptr;
-    } else {
-        qDebug() << "Ƶɣ";
-        QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), gbk_to_utf8("Ƶɣ").c_str());
-        VideoTrans_Destroy(trans);
-        trans = nullptr;
+    // ߳ˮߴΪҵ߳ȡֵ߳
+    void *videoTrans = trans;
+    trans = nullptr;
+    func effect = effectType;
+    int jobId = JobScheduler::instance()->submit(JobScheduler::Batch, 0, [videoTrans, effect, mParam]() -> int {
+        return VideoTrans_ProcessParallel(videoTrans, effect, mParam, 0);
+    }, this, [this, videoTrans](int processRet, bool cancelled) {
+        if (processRet != 0 || cancelled) {
+            qDebug() << "Ƶʧܣ:" << processRet;
+            QMessageBox::critical(this, gbk_to_utf8("ʧ").c_str(),
+                                  QString(gbk_to_utf8(": %1").c_str()).arg(processRet));
+        } else {
+            qDebug() << "Ƶɣ";
+            QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), gbk_to_utf8("Ƶɣ").c_str());
+        }
+        VideoTrans_Destroy(videoTrans);
+        finishProcessing();
+    });
+    if (jobId < 0) {
+        VideoTrans_Destroy(videoTrans);
+        finishProcessing();
     }
+}
 
+void effact::finishProcessing()
+{
     ui->ok->setEnabled(true);
     this->setEnabled(true);
 
@@ -302,32 +314,37 @@ void effact::on_exportFile_clicked()
         return;
     }
 
-    // ߳гʼת,UI߳
-    QFuture<int> future = QtConcurrent::run([this, utf8Input, utf8Output]() -> int {
-        return VideoTrans_Initialize(trans, utf8Input.c_str(), utf8Output.c_str());
-    });
-
-    // ȴʼ
-    int initRet = future.result();
-
-    if (initRet != 0) {
-        qDebug() << "ʼʧܣ:" << initRet;
-        if (initRet == -4) {
-            qDebug() << "ʾҪƵĿ߲ȡʧܿɳֶûƵ";
+    // ʼֻ̽ļͷΪҵɷUI߳
+    void *videoTrans = trans;
+    ui->exportFile->setEnabled(false);
+    int jobId = JobScheduler::instance()->submit(JobScheduler::Interactive, 1, [videoTrans, utf8Input, utf8Output]() -> int {
+        return VideoTrans_Initialize(videoTrans, utf8Input.c_str(), utf8Output.c_str());
+    }, this, [this](int initRet, bool cancelled) {
+        ui->exportFile->setEnabled(true);
+        if (initRet != 0 || cancelled) {
+            qDebug() << "ʼʧܣ:" << initRet;
+            if (initRet == -4) {
+                qDebug() << "ʾҪƵĿ߲ȡʧܿɳֶûƵ";
+            }
+            VideoTrans_Destroy(trans);
+            trans = nullptr;
+        } else {
+            qDebug() << "ʼɹ";
+        }
+        // ðťʾļ
+        QFileInfo fileInfo(outFile);
+        QString shortFileName = fileInfo.fileName();
+        if (shortFileName.length() > 20) {
+            shortFileName = shortFileName.left(17) + "...";
         }
+        ui->exportFile->setText(shortFileName);
+        s = finished;
+    });
+    if (jobId < 0) {
+        ui->exportFile->setEnabled(true);
         VideoTrans_Destroy(trans);
         trans = nullptr;
-    } else {
-        qDebug() << "ʼɹ";
-    }
-    // ðťʾļ
-    QFileInfo fileInfo(outFile);
-    QString shortFileName = fileInfo.fileName();
-    if (shortFileName.length() > 20) {
-        shortFileName = shortFileName.left(17) + "...";
     }
-    ui->exportFile->setText(shortFileName);
-    s = finished;
 }
 
 void effact::on_btnImport_clicked()
@@ -381,27 +398,9 @@ void effact::on_pushButton_clicked()
         return;
     }
 
-    QFutureWatcher<int>* watcher = new QFutureWatcher<int>(this);
-
-    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher, outPath, srcFormat, dstFormat, processor_copy]() {
-        int result = watcher->result();
-
-        // ȷ첽ɺͷԴ
-        AVProcessor_Destroy(processor_copy);
-        this->setEnabled(true);
-        if (result == 0) {
-            QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), QString(gbk_to_utf8("תɹ%1").c_str()).arg(outPath));
-        } else {
-            QString errorMsg = QString("תʧܣ: %1").arg(result);
-            QMessageBox::critical(this, "תʧ", errorMsg);
-        }
-
-        ui->pushButton->setEnabled(true);
-        watcher->deleteLater();
-    });
-
-    // ʹµĴʵ첽ת
-    QFuture<int> future = QtConcurrent::run([processor_copy, input, output, dstFormat]() -> int {
+    // ʽתΪҵɷתװǵ߳IOתGIFҪ+ɫδ
+    int threads = dstFormat == "gif" ? 2 : 1;
+    int jobId = JobScheduler::instance()->submit(JobScheduler::Batch, threads, [processor_copy, input, output, dstFormat]() -> int {
         try {
             if (dstFormat == "gif") {
                 AVConfig config;
@@ -415,9 +414,24 @@ void effact::on_pushButton_clicked()
             qDebug() << "תз쳣";
             return -999;
         }
-    });
+    }, this, [this, outPath, processor_copy](int result, bool cancelled) {
+        // ȷ첽ɺͷԴ
+        AVProcessor_Destroy(processor_copy);
+        this->setEnabled(true);
+        if (result == 0 && !cancelled) {
+            QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), QString(gbk_to_utf8("תɹ%1").c_str()).arg(outPath));
+        } else {
+            QString errorMsg = QString("תʧܣ: %1").arg(result);
+            QMessageBox::critical(this, "תʧ", errorMsg);
+        }
 
-    watcher->setFuture(future);
+        ui->pushButton->setEnabled(true);
+    });
+    if (jobId < 0) {
+        AVProcessor_Destroy(processor_copy);
+        this->setEnabled(true);
+        ui->pushButton->setEnabled(true);
+    }
 }
 
 void effact::updataParamUi()
@@ -71,6 +71,8 @@ private:
     void handleDroppedFiles(const QList<QString> &filePaths);
     void setupInputWidgets();
     void updateParameterWidget();
+    // 特效处理作业结束后恢复界面状态
+    void finishProcessing();
 private:
     // Input控件实例
     glass *m_glassWidget = nullptr;
@@ -6,13 +6,50 @@
 #include <QDir>
 #include <QDebug>
 #include <QMessageBox>
-#include <QtConcurrent>
+#include "src/base/jobscheduler.h"
 #include <QApplication>
 #include <QCheckBox>
 #include <QToolButton>
 #include <QSpinBox>
 #include <QFileInfo>
 #include <QPixmap>
+#include <QImageReader>
+#include <memory>
+
+// ͼƬ鴦Լ8000x8000
+static const qint64 kTiledPixels = 64LL * 1000 * 1000;
+
+// ҵִ߳Уֻʹò
+static bool processImage(void *cvTranslator, int effect, const std::string &utf8InputStr,
+                         const std::string &utf8OutputStr, const param &mParam)
+{
+    const char* inputPath = utf8InputStr.c_str();
+    const char* outputPath = utf8OutputStr.c_str();
+    switch (effect) {
+        case grayImage:
+            return CvTranslator_GrayImage_File(cvTranslator, inputPath, outputPath);
+        case addTextWatermark:
+            return CvTranslator_AddTextWatermark_File(cvTranslator, inputPath, outputPath, mParam.arr);
+        case customOilPaintApprox:
+            return CvTranslator_OilPainting_File(cvTranslator, inputPath, outputPath, mParam.iparam1, (int)mParam.dparam1);
+        case applyOilPainting:
+            return CvTranslator_OilPainting_File(cvTranslator, inputPath, outputPath, mParam.iparam1, (int)mParam.dparam1);
+        case applyMosaic:
+            return CvTranslator_Mosaic_File(cvTranslator, inputPath, outputPath, mParam.iparam1, mParam.iparam2, mParam.iparam3, mParam.iparam4, mParam.iparam5);
+        case FrostedGlass:
+            return CvTranslator_FrostedGlass_File(cvTranslator, inputPath, outputPath);
+        case simpleSkinSmoothing:
+            return CvTranslator_SkinSmoothing_File(cvTranslator, inputPath, outputPath);
+        case Whitening:
+            return CvTranslator_Whitening_File(cvTranslator, inputPath, outputPath);
+        case Whitening2:
+            return CvTranslator_Whitening2_File(cvTranslator, inputPath, outputPath);
+        case invertImage:
+            return CvTranslator_Invert_File(cvTranslator, inputPath, outputPath);
+        default:
+            return false;
+    }
+}
 
 picture::picture(QWidget *parent) :
     QWidget(parent),
@@ -241,14 +278,14 @@ bool picture::isValidImageFile(const QString& filePath)
 
     // ļ׺
     QString suffix = fileInfo.suffix().toLower();
-    QStringList validExtensions = {"png", "jpg", "jpeg", "bmp", "gif", "tiff", "webp"};
+    QStringList validExtensions = {"png", "jpg", "jpeg", "bmp", "gif", "tiff", "webp", "ppm", "pgm"};
     if (!validExtensions.contains(suffix)) {
         return false;
     }
 
-    // ͼƬ֤ļЧ
-    QPixmap pixmap(filePath);
-    return !pixmap.isNull();
+    // ֻļͷ֤Чԣɨͼ
+    QImageReader reader(filePath);
+    return reader.canRead() && reader.size().isValid();
 }
 
 // 쳣루on_ok_clicked/on_addFile_clicked/on_exportFile_clicked/showLoading/hideLoading
@@ -291,9 +328,11 @@ void picture::on_ok_clicked()
         return;
     }
 
-    // ûδԤ·򵯳Ի
-    if (outFile.isEmpty()) {
-        outFile = QFileDialog::getSaveFileName(this, gbk_to_utf8("ѡļ").c_str(), QDir::currentPath()+"/document", gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp)").c_str());
+    // ûδԤ·򵯳Ի򣨶ѡʱΪĿ¼
+    if (outFile.isEmpty() && m_batchFiles.size() > 1) {
+        outFile = QFileDialog::getExistingDirectory(this, gbk_to_utf8("ѡĿ¼").c_str(), QDir::currentPath()+"/document");
+    } else if (outFile.isEmpty()) {
+        outFile = QFileDialog::getSaveFileName(this, gbk_to_utf8("ѡļ").c_str(), QDir::currentPath()+"/document", gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp *.ppm *.pgm)").c_str());
     }
 
     if (outFile.isEmpty()) {
@@ -372,54 +411,127 @@ void picture::on_ok_clicked()
         break;
     }
 
-    QFuture<bool> future = QtConcurrent::run([this, utf8InputStr, utf8OutputStr, mParam]() -> bool {
-        const char* inputPath = utf8InputStr.c_str();
-        const char* outputPath = utf8OutputStr.c_str();
-        switch (effectType) {
-            case grayImage:
-                return CvTranslator_GrayImage_File(translator, inputPath, outputPath);
-            case addTextWatermark:
-                return CvTranslator_AddTextWatermark_File(translator, inputPath, outputPath, mParam.arr);
-            case customOilPaintApprox:
-                return CvTranslator_OilPainting_File(translator, inputPath, outputPath, mParam.iparam1, (int)mParam.dparam1);
-            case applyOilPainting:
-                return CvTranslator_OilPainting_File(translator, inputPath, outputPath, mParam.iparam1, (int)mParam.dparam1);
-            case applyMosaic:
-                return CvTranslator_Mosaic_File(translator, inputPath, outputPath, mParam.iparam1, mParam.iparam2, mParam.iparam3, mParam.iparam4, mParam.iparam5);
-            case FrostedGlass:
-                return CvTranslator_FrostedGlass_File(translator, inputPath, outputPath);
-            case simpleSkinSmoothing:
-                return CvTranslator_SkinSmoothing_File(translator, inputPath, outputPath);
-            case Whitening:
-                return CvTranslator_Whitening_File(translator, inputPath, outputPath);
-            case Whitening2:
-                return CvTranslator_Whitening2_File(translator, inputPath, outputPath);
-            case invertImage:
-                return CvTranslator_Invert_File(translator, inputPath, outputPath);
-            default:
-                return false;
+    if (m_batchFiles.size() > 1) {
+        runBatch(mParam);
+        return;
+    }
+
+    // ͼƬڽҵɵɷ̨Ƶˣ
+    // ͼɨΪֿ鴦ͼЧڲͼűڴ
+    void *cvTranslator = translator;
+    int effect = effectType;
+    QSize imageSize = QImageReader(file).size();
+    bool tiled = imageSize.isValid() && qint64(imageSize.width()) * imageSize.height() > kTiledPixels;
+    if (tiled) {
+        qDebug() << "ͼƬ鴦:" << imageSize;
+    }
+    int jobId = JobScheduler::instance()->submit(tiled ? JobScheduler::Batch : JobScheduler::Interactive, tiled ? 0 : 1,
+                                                 [cvTranslator, effect, utf8InputStr, utf8OutputStr, mParam, tiled]() -> int {
+        if (tiled) {
+            std::shared_ptr<void> chain(EffectChain_Create(), EffectChain_Destroy);
+            EffectChain_Add(chain.get(), effect, mParam);
+            return CvTranslator_ProcessTiled(utf8InputStr.c_str(), utf8OutputStr.c_str(), chain.get(), 0, 0);
+        }
+        return processImage(cvTranslator, effect, utf8InputStr, utf8OutputStr, mParam) ? 0 : -1;
+    }, this, [this](int result, bool cancelled) {
+        hideLoading();
+        isProcessing = false;
+        ui->addFile->setEnabled(true);
+        ui->exportFile->setEnabled(true);
+        ui->ok->setEnabled(true);
+
+        if (result == 0 && !cancelled) {
+            QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), gbk_to_utf8("ͼƬɣ").c_str());
+        } else {
+            QMessageBox::critical(this, gbk_to_utf8("").c_str(), gbk_to_utf8("ͼƬʧ").c_str());
         }
     });
+    if (jobId < 0) {
+        hideLoading();
+        isProcessing = false;
+        ui->addFile->setEnabled(true);
+        ui->exportFile->setEnabled(true);
+        ui->ok->setEnabled(true);
+        QMessageBox::critical(this, gbk_to_utf8("").c_str(), gbk_to_utf8("ͼƬʧ").c_str());
+    }
+}
+
+// дļ߳еãֻ¼ʧܵļ
+static void onBatchFile(int index, const char *inputPath, const char *outputPath, int status, void *user)
+{
+    Q_UNUSED(outputPath);
+    Q_UNUSED(user);
+    if (status != CvBatchOk) {
+        qDebug() << "ʧ:" << index << QString::fromUtf8(inputPath) << "status:" << status;
+    }
+}
 
-    // ȴ
-    bool success = future.result();
+void picture::runBatch(const param &mParam)
+{
+    // ͬĿ¼ʱȽ
+    QDir().mkpath(outFile);
 
-    hideLoading();
-    isProcessing = false;
-    ui->addFile->setEnabled(true);
-    ui->exportFile->setEnabled(true);
-    ui->ok->setEnabled(true);
+    std::shared_ptr<void> chain(EffectChain_Create(), EffectChain_Destroy);
+    EffectChain_Add(chain.get(), effectType, mParam);
 
-    if (success) {
-        QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), gbk_to_utf8("ͼƬɣ").c_str());
-    } else {
+    std::vector<std::string> inputs;
+    for (const QString &path : m_batchFiles) {
+        inputs.push_back(QDir::toNativeSeparators(path).toUtf8().toStdString());
+    }
+    std::string outputDir = QDir::toNativeSeparators(outFile).toUtf8().toStdString();
+    std::shared_ptr<CvBatchStats> stats = std::make_shared<CvBatchStats>();
+    memset(stats.get(), 0, sizeof(CvBatchStats));
+
+    // Ϊҵ߳ɵ䣬дļ봦DLLص
+    int jobId = JobScheduler::instance()->submit(JobScheduler::Batch, 0, [chain, inputs, outputDir, stats]() -> int {
+        std::vector<const char *> paths;
+        for (const std::string &path : inputs) {
+            paths.push_back(path.c_str());
+        }
+        return CvTranslator_ProcessBatch(paths.data(), static_cast<int>(paths.size()), outputDir.c_str(),
+                                         chain.get(), 0, 0, onBatchFile, nullptr, stats.get());
+    }, this, [this, stats](int result, bool cancelled) {
+        hideLoading();
+        isProcessing = false;
+        ui->addFile->setEnabled(true);
+        ui->exportFile->setEnabled(true);
+        ui->ok->setEnabled(true);
+
+        qDebug() << ": " << stats->total << "ɹ" << stats->succeeded << "ʧ" << stats->failed
+                 << "ʱ" << stats->seconds << "s," << stats->images_per_sec << "/";
+        QString summary = QString(gbk_to_utf8("%1ţɹ%2ţʧ%3ţ%4/").c_str())
+                              .arg(stats->total).arg(stats->succeeded).arg(stats->failed)
+                              .arg(stats->images_per_sec, 0, 'f', 1);
+        if (result == 0 && !cancelled) {
+            QMessageBox::information(this, gbk_to_utf8("ɹ").c_str(), summary);
+        } else {
+            QMessageBox::warning(this, gbk_to_utf8("δȫ").c_str(), summary);
+        }
+    });
+    if (jobId < 0) {
+        hideLoading();
+        isProcessing = false;
+        ui->addFile->setEnabled(true);
+        ui->exportFile->setEnabled(true);
+        ui->ok->setEnabled(true);
         QMessageBox::critical(this, gbk_to_utf8("").c_str(), gbk_to_utf8("ͼƬʧ").c_str());
     }
 }
 
 void picture::on_addFile_clicked()
 {
-    QString selectedFile = QFileDialog::getOpenFileName(this, gbk_to_utf8("ѡͼƬļ").c_str(), QDir::currentPath()+"/document", gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp);;ļ (*.*)").c_str());
+    // ɶѡѡжʱΪĿ¼
+    QStringList selectedFiles = QFileDialog::getOpenFileNames(this, gbk_to_utf8("ѡͼƬļ").c_str(), QDir::currentPath()+"/document", gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp *.ppm *.pgm);;ļ (*.*)").c_str());
+    if (selectedFiles.size() > 1) {
+        m_batchFiles = selectedFiles;
+        file = selectedFiles.first();
+        outFile.clear();
+        ui->addFile->setText(QString(gbk_to_utf8("ѡ%1ļ").c_str()).arg(selectedFiles.size()));
+        ui->exportFile->setText(gbk_to_utf8("Ŀ¼").c_str());
+        return;
+    }
+    m_batchFiles.clear();
+    QString selectedFile = selectedFiles.isEmpty() ? QString() : selectedFiles.first();
     if (!selectedFile.isEmpty()) {
         // ֤ļǷΪЧͼƬ
         if (!isValidImageFile(selectedFile)) {
@@ -449,7 +561,15 @@ void picture::on_addFile_clicked()
 
 void picture::on_exportFile_clicked()
 {
-    QString selectedOutFile = QFileDialog::getSaveFileName(this, gbk_to_utf8("ѡļ").c_str(), outFile.isEmpty() ? QDir::currentPath()+"/document" : outFile, gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp)").c_str());
+    if (m_batchFiles.size() > 1) {
+        QString dir = QFileDialog::getExistingDirectory(this, gbk_to_utf8("ѡĿ¼").c_str(), outFile.isEmpty() ? QDir::currentPath()+"/document" : outFile);
+        if (!dir.isEmpty()) {
+            outFile = dir;
+            ui->exportFile->setText(gbk_to_utf8(":").c_str() + QFileInfo(dir).fileName());
+        }
+        return;
+    }
+    QString selectedOutFile = QFileDialog::getSaveFileName(this, gbk_to_utf8("ѡļ").c_str(), outFile.isEmpty() ? QDir::currentPath()+"/document" : outFile, gbk_to_utf8("ͼƬļ (*.png *.jpg *.jpeg *.bmp *.ppm *.pgm)").c_str());
     if (!selectedOutFile.isEmpty()) {
         outFile = selectedOutFile;
         qDebug() << "Output file set to:" << outFile;
@@ -2,6 +2,7 @@
 #define PICTURE_H
 #include <QWidget>
 #include <QString>
+#include <QStringList>
 #include <QCheckBox>
 #include <QLabel>
 #include <QMovie>
@@ -51,6 +52,7 @@ private:
     Ui::picture *ui;
     QString file;
     QString outFile;
+    QStringList m_batchFiles; // 多选时的输入，此时outFile为输出目录
     void *translator = nullptr;
     func effectType = noAction;  // 确保类型统一
     bool isProcessing;
@@ -61,6 +63,8 @@ private:
     bool isValidImageFile(const QString& filePath);
     void setupInputWidgets();
     void updateParameterWidget();
+    // 多选文件时整批交给CvTranslator_ProcessBatch
+    void runBatch(const param &mParam);
 private:
     // Input控件实例
     glass *m_glassWidget = nullptr;
@@ -3,6 +3,7 @@
 #include "ui_videopage.h"
 #include "src/utils/myipcmgr.h"
 #include "src/base/mplayermanager.h"
+#include "src/base/mediascanner.h"
 
 #include <QString>
 #include <QWidget>
@@ -25,6 +26,7 @@
 #include <QUrl>
 #include <QApplication>
 #include <QTimer>
+#include <QImage>
 
 // GBKתUTF8ȷĿʵ֣
 std::string gbk_to_utf8(const std::string& gbk_str);
@@ -47,6 +49,9 @@ videoPage::videoPage(QWidget *parent) :
     }
     initableWidget();
 
+    // ̨ɨ
+    connect(MediaScanner::instance(), &MediaScanner::fileScanned, this, &videoPage::onMediaScanned);
+
     // ˢ°ťźŲ
     connect(ui->flashbutton, &QPushButton::clicked, this, &videoPage::on_flashbutton_clicked);
     
@@ -140,6 +145,8 @@ bool videoPage::initableWidget()
                                                          QDir::Files | QDir::NoDotAndDotDot,
                                                          QDir::Name);
 
+    m_rowOfPath.clear();
+
     // 
     if (!videoFileList.isEmpty()) {
         ui->tableWidget->setRowCount(videoFileList.size());
@@ -147,17 +154,10 @@ bool videoPage::initableWidget()
             QFileInfo fileInfo = videoFileList.at(i);
             QString videoPath = fileInfo.absoluteFilePath();
 
-            // ȡƵ֡ΪԤͼʱBMPļ
-            QString bmpPath = QDir::tempPath() + "/" + fileInfo.baseName() + "_frame.bmp";
-            QByteArray gbkVideoPath = QString2GBK(videoPath);
-            QByteArray gbkBmpPath = QString2GBK(bmpPath);
-
-            bool getFrameOk = AvWorker_GetVideoFirstFrame(
-                        worker,
-                        gbkVideoPath.constData(),
-                        gbkBmpPath.constData(),
-                        false
-                        );
+            // ԤͼʱMediaScannerں̨̽⣬ʱֱʾռλ
+            MediaInfo mediaInfo;
+            bool cached = MediaScanner::instance()->lookup(fileInfo, mediaInfo);
+            m_rowOfPath.insert(videoPath, i);
 
             // ƵƵԪԤͼ+ƣ
             QWidget* nameWidget = new QWidget();
@@ -167,11 +167,11 @@ bool videoPage::initableWidget()
 
             // Ԥͼǩ
             QLabel* imgLabel = new QLabel();
+            imgLabel->setObjectName("thumbLabel");
             imgLabel->setFixedSize(60, 40);
             imgLabel->setScaledContents(true);
-            if (getFrameOk && QFile::exists(bmpPath)) {
-                imgLabel->setPixmap(QPixmap(bmpPath).scaled(imgLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
-                QFile::remove(bmpPath); // ɾʱļ
+            if (cached && !mediaInfo.thumbnail.isNull()) {
+                imgLabel->setPixmap(QPixmap::fromImage(mediaInfo.thumbnail).scaled(imgLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
             } else {
                 // ĬƵͼ
                 imgLabel->setPixmap(QPixmap(":/rc/video.svg").scaled(imgLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
@@ -194,20 +194,10 @@ bool videoPage::initableWidget()
 
             qDebug() << "videoPath" << videoPath << " | " << QFile::exists(videoPath);
 
-            // ȡƵʱ
-            QByteArray gbkPath = QString2GBK(videoPath);
-            double duration = AvWorker_getDuration(worker, gbkPath.constData());
-
-            // ʽʱ磺3.716 -> "0:04", 21.27 -> "0:21"
-            int minutes = static_cast<int>(duration) / 60;
-            int seconds = static_cast<int>(duration) % 60;
-            QString durationStr = QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
-
-            // ʱ
-            QTableWidgetItem *durationItem = new QTableWidgetItem(durationStr);
+            // ʱδлʱȺ̨̽
+            QTableWidgetItem *durationItem = new QTableWidgetItem(cached ? formatDuration(mediaInfo.duration) : QString("--:--"));
             durationItem->setTextAlignment(Qt::AlignCenter);
             ui->tableWidget->setItem(i, 1, durationItem);
-            qDebug()<<"duration:"<<duration;
 
             // 㲢ļСMB
             double fileSizeMB = fileInfo.size() / (1024.0 * 1024.0);
@@ -336,9 +326,42 @@ bool videoPage::initableWidget()
         ui->tableWidget->setSpan(0, 0, 1, tableHeaders.size());
     }
 
+    // ̨̽δļͨonMediaScanned
+    MediaScanner::instance()->scan(videoFileList);
+
     return true;
 }
 
+// ʽʱ磺3.716 -> "0:04", 21.27 -> "0:21"̽ʧʾ--:--
+QString videoPage::formatDuration(double duration)
+{
+    if (duration < 0) {
+        return QString("--:--");
+    }
+    int minutes = static_cast<int>(duration) / 60;
+    int seconds = static_cast<int>(duration) % 60;
+    return QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
+}
+
+void videoPage::onMediaScanned(const MediaInfo &info)
+{
+    int row = m_rowOfPath.value(info.path, -1);
+    if (row < 0 || row >= ui->tableWidget->rowCount()) {
+        return;
+    }
+
+    QWidget *nameWidget = ui->tableWidget->cellWidget(row, 0);
+    QLabel *imgLabel = nameWidget ? nameWidget->findChild<QLabel*>("thumbLabel") : nullptr;
+    if (imgLabel && !info.thumbnail.isNull()) {
+        imgLabel->setPixmap(QPixmap::fromImage(info.thumbnail).scaled(imgLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    }
+
+    QTableWidgetItem *durationItem = ui->tableWidget->item(row, 1);
+    if (durationItem) {
+        durationItem->setText(formatDuration(info.duration));
+    }
+}
+
 
 void videoPage::on_begin_clicked()
 {
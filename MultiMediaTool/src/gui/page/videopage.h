@@ -3,9 +3,11 @@
 
 #include <QWidget>
 #include <QString>
+#include <QHash>
 #include "src/gui/page/concat.h"
 #include "OpenCVFFMpegTools.h"
 #include "src/base/pagebase.h"
+#include "src/base/mediascanner.h"
 
 namespace Ui {
 class videoPage;
@@ -30,13 +32,17 @@ private slots:
     void on_import_2_clicked();
     void on_pushButton_clicked();
     void on_recordComboBox_currentIndexChanged(int index);
+    void onMediaScanned(const MediaInfo &info);
 
 private:
+    static QString formatDuration(double duration);
+
     concat *mconcat;
     QProcess *process;
     void *worker = NULL;
     Ui::videoPage *ui;
     MyIPCMgr *m_ipcMgr = nullptr;
+    QHash<QString, int> m_rowOfPath; // 文件路径 -> 表格行，用于回填扫描结果
 };
 
 
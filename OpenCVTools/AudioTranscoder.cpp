@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "AudioTranscoder.h"
+
+AudioTranscoder::~AudioTranscoder()
+{
+	if (fifo) av_audio_fifo_free(fifo);
+	if (swr) swr_free(&swr);
+	if (dec) avcodec_free_context(&dec);
+	if (enc) avcodec_free_context(&enc);
+}
+
+bool AudioTranscoder::open(AVStream* in, const AVCodecParameters* ref, bool global_header)
+{
+	AVCodec* decoder = avcodec_find_decoder(in->codecpar->codec_id);
+	AVCodec* encoder = avcodec_find_encoder(ref->codec_id);
+	if (!decoder || !encoder) return false;
+
+	dec = avcodec_alloc_context3(decoder);
+	if (!dec || avcodec_parameters_to_context(dec, in->codecpar) < 0) return false;
+	if (avcodec_open2(dec, decoder, nullptr) < 0) return false;
+	if (!dec->channel_layout) dec->channel_layout = av_get_default_channel_layout(dec->channels);
+
+	enc = avcodec_alloc_context3(encoder);
+	if (!enc) return false;
+	enc->sample_rate = ref->sample_rate;
+	enc->channels = ref->channels;
+	enc->channel_layout = ref->channel_layout ? ref->channel_layout : av_get_default_channel_layout(ref->channels);
+	enc->sample_fmt = static_cast<AVSampleFormat>(ref->format);
+	enc->bit_rate = ref->bit_rate > 0 ? ref->bit_rate : 128000;
+	enc->profile = ref->profile;
+	enc->time_base = { 1, ref->sample_rate };
+	if (global_header) enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	if (avcodec_open2(enc, encoder, nullptr) < 0) return false;
+
+	swr = swr_alloc_set_opts(nullptr,
+		enc->channel_layout, enc->sample_fmt, enc->sample_rate,
+		dec->channel_layout, dec->sample_fmt, dec->sample_rate, 0, nullptr);
+	if (!swr || swr_init(swr) < 0) return false;
+
+	fifo = av_audio_fifo_alloc(enc->sample_fmt, enc->channels, 1);
+	return fifo && frame.get() && out.get();
+}
+
+void AudioTranscoder::resample(AVFrame* in)
+{
+	// 预分配好缓冲区时swr_convert_frame把nb_samples当作容量
+	int capacity = swr_get_out_samples(swr, in ? in->nb_samples : 0);
+	capacity = std::max(2048, (capacity + 2047) / 2048 * 2048);
+	AVFrame* resampled = resample_pool.audio(capacity, enc->sample_fmt, enc->channels, enc->channel_layout, enc->sample_rate);
+	if (resampled && swr_convert_frame(swr, resampled, in) >= 0 && resampled->nb_samples > 0) {
+		av_audio_fifo_write(fifo, reinterpret_cast<void**>(resampled->data), resampled->nb_samples);
+	}
+	resample_pool.recycle(resampled);
+}
@@ -0,0 +1,95 @@
+/*****************************************************************//**
+ * \file   AudioTranscoder.h
+ * \brief  音频解码->重采样->重编码，供拼接和音频直通在容器不支持原编码时使用
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include "MediaBuffer.h"
+
+extern "C" {
+#include <libswresample/swresample.h>
+#include <libavutil/audio_fifo.h>
+}
+
+// 把输入音频流重采样并重编码为目标参数（编码器、采样率、声道、采样格式）
+// Sink: void(AVPacket* pkt, AVRational enc_time_base)
+struct AudioTranscoder {
+	AVCodecContext* dec = nullptr;
+	AVCodecContext* enc = nullptr;
+	SwrContext* swr = nullptr;
+	AVAudioFifo* fifo = nullptr;
+	FrameRef frame;
+	FramePool resample_pool; // 重采样输出，容量按2048样本取整，稳态同一尺寸
+	FramePool encode_pool;   // 送编码器的定长帧
+	PacketRef out;
+	int64_t next_pts = AV_NOPTS_VALUE; // 编码器时间基 1/sample_rate
+
+	~AudioTranscoder();
+
+	/**
+	 * @brief 打开解码器/编码器/重采样器.
+	 *
+	 * \param in 输入音频流
+	 * \param ref 目标参数，bit_rate为0时用128k
+	 * \param global_header 输出封装要求全局头时为true
+	 * \return 成功返回true
+	 */
+	bool open(AVStream* in, const AVCodecParameters* ref, bool global_header);
+
+	// 送入一个输入包，pkt为空表示冲刷，编码出的包交给sink
+	template <typename Sink>
+	void feed(AVPacket* pkt, AVRational in_tb, Sink sink)
+	{
+		if (avcodec_send_packet(dec, pkt) < 0 && pkt) return;
+		while (avcodec_receive_frame(dec, frame.get()) >= 0) {
+			if (next_pts == AV_NOPTS_VALUE && frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+				next_pts = av_rescale_q(frame->best_effort_timestamp, in_tb, enc->time_base);
+			}
+			resample(frame.get());
+			frame.unref();
+		}
+		if (!pkt) {
+			resample(nullptr); // 冲刷重采样器
+		}
+		encode_fifo(sink, pkt == nullptr);
+		if (!pkt) {
+			avcodec_send_frame(enc, nullptr);
+			drain(sink);
+		}
+	}
+
+	void resample(AVFrame* in);
+
+	// 按编码器帧长取样编码；flush时把不足一帧的尾部也送出
+	template <typename Sink>
+	void encode_fifo(Sink sink, bool flush)
+	{
+		const int frame_size = enc->frame_size > 0 ? enc->frame_size : 1024;
+		if (next_pts == AV_NOPTS_VALUE) next_pts = 0;
+		while (av_audio_fifo_size(fifo) >= frame_size || (flush && av_audio_fifo_size(fifo) > 0)) {
+			int n = std::min(frame_size, av_audio_fifo_size(fifo));
+			AVFrame* samples = encode_pool.audio(n, enc->sample_fmt, enc->channels, enc->channel_layout, enc->sample_rate);
+			if (!samples) {
+				return;
+			}
+			av_audio_fifo_read(fifo, reinterpret_cast<void**>(samples->data), n);
+			samples->pts = next_pts;
+			next_pts += n;
+			avcodec_send_frame(enc, samples);
+			encode_pool.recycle(samples);
+			drain(sink);
+		}
+	}
+
+	template <typename Sink>
+	void drain(Sink sink)
+	{
+		while (avcodec_receive_packet(enc, out.get()) >= 0) {
+			sink(out.get(), enc->time_base);
+			out.unref();
+		}
+	}
+};
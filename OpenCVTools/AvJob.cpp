@@ -0,0 +1,478 @@
+#include "pch.h"
+#include "AvJob.h"
+#include "AvWorker.h"
+#include <algorithm>
+
+static thread_local AvJob* t_current_job = nullptr;
+
+// 作业被取消时令FFmpeg的阻塞读返回AVERROR_EXIT
+static int avjob_interrupt(void* opaque)
+{
+	return static_cast<AvJob*>(opaque)->cancel.load() ? 1 : 0;
+}
+
+AvJobManager& AvJobManager::instance()
+{
+	// 不析构：进程退出时DLL卸载阶段不能join线程
+	static AvJobManager* manager = new AvJobManager();
+	return *manager;
+}
+
+static int default_thread_limit()
+{
+	return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+AvJobManager::AvJobManager()
+	: m_limit(default_thread_limit())
+{
+}
+
+int AvJobManager::submit(std::function<bool()> task, const std::string& output_path, AvJobCallback callback, void* user,
+	int priority, int threads)
+{
+	std::shared_ptr<AvJob> job = std::make_shared<AvJob>();
+	job->task = task;
+	job->output_path = output_path;
+	job->callback = callback;
+	job->user = user;
+	job->priority = priority == AvJobInteractive ? AvJobInteractive : AvJobBatch;
+	job->appetite = threads > 0 ? threads : 0;
+	job->submitted = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_stopping) {
+		return -1;
+	}
+	job->id = m_nextId++;
+	m_jobs[job->id] = job;
+	m_queues[job->priority].push_back(job);
+	dispatchLocked();
+	return job->id;
+}
+
+// 在持有m_mtx时调用：按优先级从队首派发放得下的作业，交给工作线程池执行
+void AvJobManager::dispatchLocked()
+{
+	if (m_stopping) {
+		return;
+	}
+	for (int p = AvJobInteractive; p <= AvJobBatch; ++p) {
+		std::deque<std::shared_ptr<AvJob>>& queue = m_queues[p];
+		while (!queue.empty()) {
+			std::shared_ptr<AvJob> job = queue.front();
+			// 批处理作业给交互作业留一个线程
+			int cap = (p == AvJobBatch && m_limit > 1) ? m_limit - 1 : m_limit;
+			int want = job->appetite > 0 ? std::min(job->appetite, cap) : cap;
+			// 预留槽：没有批处理在跑时，批处理队首按剩余线程立即派发，不等交互队列排空
+			bool reserved = p == AvJobBatch && m_runningBatch == 0;
+			if (p == AvJobBatch && !reserved && !m_queues[AvJobInteractive].empty()) {
+				break; // 交互作业没派发完时其余批处理作业继续等待
+			}
+			if (reserved) {
+				want = std::min(want, std::max(1, cap - m_threadsInUse));
+			}
+			// 已取消的作业不占线程，派发后立即结束
+			if (job->cancel.load()) {
+				want = 0;
+			}
+			if (!reserved && m_running > 0 && m_threadsInUse + want > (p == AvJobBatch ? cap : m_limit)) {
+				break;
+			}
+			queue.pop_front();
+			job->threads = want;
+			m_threadsInUse += want;
+			m_running++;
+			if (p == AvJobBatch) {
+				m_runningBatch++;
+			}
+
+			int64_t wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - job->submitted).count();
+			m_started++;
+			m_totalWaitMs += wait_ms;
+			m_maxWaitMs = std::max(m_maxWaitMs, wait_ms);
+			{
+				std::lock_guard<std::mutex> job_lock(job->mtx);
+				job->progress.wait_ms = wait_ms;
+			}
+			m_ready.push_back(job);
+			if (m_idleWorkers >= static_cast<int>(m_ready.size())) {
+				m_readyCv.notify_one();
+			}
+			else {
+				m_workers.emplace_back(&AvJobManager::workerLoop, this);
+			}
+		}
+	}
+}
+
+// 工作线程：取已派发的作业执行，停止时退出
+void AvJobManager::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while (true) {
+		if (m_ready.empty()) {
+			if (m_stopping) {
+				return;
+			}
+			m_idleWorkers++;
+			m_readyCv.wait(lock, [this]() { return !m_ready.empty() || m_stopping; });
+			m_idleWorkers--;
+			if (m_ready.empty()) {
+				return;
+			}
+		}
+		std::shared_ptr<AvJob> job = m_ready.front();
+		m_ready.pop_front();
+		lock.unlock();
+		run(job);
+		job.reset();
+		lock.lock();
+	}
+}
+
+void AvJobManager::shutdown(bool cancelRunning)
+{
+	std::vector<std::shared_ptr<AvJob>> dropped;
+	std::vector<std::thread> workers;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_stopping) {
+			return;
+		}
+		m_stopping = true;
+		for (auto& queue : m_queues) {
+			dropped.insert(dropped.end(), queue.begin(), queue.end());
+			queue.clear();
+		}
+		if (cancelRunning) {
+			for (auto& kv : m_jobs) {
+				kv.second->cancel.store(true);
+			}
+		}
+		m_readyCv.notify_all();
+	}
+
+	// 未派发的作业直接按取消结束
+	for (const std::shared_ptr<AvJob>& job : dropped) {
+		{
+			std::lock_guard<std::mutex> lock(job->mtx);
+			job->progress.state = AvJobCancelled;
+		}
+		if (job->callback) {
+			AvJobProgress snapshot = job->progress;
+			job->callback(job->id, &snapshot, job->user);
+		}
+		job->done_cv.notify_all();
+	}
+
+	// 已派发的作业由工作线程执行完后退出
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		workers.swap(m_workers);
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	std::cout << "[info] job scheduler stopped, cancelled queued:" << dropped.size()
+		<< " workers joined:" << workers.size() << std::endl;
+}
+
+void AvJobManager::setThreadLimit(int limit)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_limit = limit > 0 ? limit : default_thread_limit();
+	dispatchLocked();
+}
+
+void AvJobManager::stats(AvSchedulerStats& out)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	out.thread_limit = m_limit;
+	out.threads_in_use = m_threadsInUse;
+	out.running = m_running;
+	out.queued_interactive = static_cast<int>(m_queues[AvJobInteractive].size());
+	out.queued_batch = static_cast<int>(m_queues[AvJobBatch].size());
+	out.started = m_started;
+	out.avg_wait_ms = m_started > 0 ? m_totalWaitMs / m_started : 0;
+	out.max_wait_ms = m_maxWaitMs;
+}
+
+std::shared_ptr<AvJob> AvJobManager::find(int id)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_jobs.find(id);
+	return it == m_jobs.end() ? nullptr : it->second;
+}
+
+bool AvJobManager::progress(int id, AvJobProgress& out)
+{
+	std::shared_ptr<AvJob> job = find(id);
+	if (!job) return false;
+	std::lock_guard<std::mutex> lock(job->mtx);
+	out = job->progress;
+	return true;
+}
+
+void AvJobManager::cancel(int id)
+{
+	std::shared_ptr<AvJob> job = find(id);
+	if (job) job->cancel.store(true);
+}
+
+int AvJobManager::wait(int id)
+{
+	std::shared_ptr<AvJob> job = find(id);
+	if (!job) return -1;
+	std::unique_lock<std::mutex> lock(job->mtx);
+	job->done_cv.wait(lock, [&]() { return job->progress.state >= AvJobSucceeded; });
+	return job->progress.state;
+}
+
+void AvJobManager::release(int id)
+{
+	std::shared_ptr<AvJob> job = find(id);
+	if (!job) return;
+	{
+		// 未结束的作业先取消，记录在结束后由工作线程持有的引用释放
+		std::lock_guard<std::mutex> lock(job->mtx);
+		if (job->progress.state < AvJobSucceeded) job->cancel.store(true);
+	}
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_jobs.erase(id);
+}
+
+static void notify(AvJob* job)
+{
+	AvJobProgress snapshot;
+	{
+		std::lock_guard<std::mutex> lock(job->mtx);
+		snapshot = job->progress;
+	}
+	job->last_notify = std::chrono::steady_clock::now();
+	if (job->callback) {
+		job->callback(job->id, &snapshot, job->user);
+	}
+}
+
+void AvJobManager::run(const std::shared_ptr<AvJob>& job)
+{
+	bool ok = false;
+	if (!job->cancel.load()) {
+		{
+			std::lock_guard<std::mutex> lock(job->mtx);
+			job->progress.state = AvJobRunning;
+		}
+		notify(job.get());
+
+		auto begin_time = std::chrono::steady_clock::now();
+		t_current_job = job.get();
+		try {
+			ok = job->task();
+		}
+		catch (const std::exception& e) {
+			std::cerr << "[error] job " << job->id << " exception: " << e.what() << std::endl;
+			ok = false;
+		}
+		t_current_job = nullptr;
+		job->input = nullptr;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+		std::cout << "[info] job " << job->id << (job->cancel.load() ? " cancelled" : ok ? " ok" : " fair")
+			<< " priority:" << job->priority << " threads:" << job->threads
+			<< " wait ms:" << job->progress.wait_ms << " seconds:" << seconds << std::endl;
+	}
+
+	// 被取消的流程可能把中断当作文件结束正常收尾，结果一律按取消处理
+	int state = job->cancel.load() ? AvJobCancelled : ok ? AvJobSucceeded : AvJobFailed;
+	if (state != AvJobSucceeded && !job->output_path.empty()) {
+		std::remove(job->output_path.c_str());
+	}
+	{
+		std::lock_guard<std::mutex> lock(job->mtx);
+		job->progress.state = state;
+	}
+	notify(job.get());
+	job->done_cv.notify_all();
+
+	// 归还线程，派发排队的作业
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_threadsInUse -= job->threads;
+	m_running--;
+	if (job->priority == AvJobBatch) {
+		m_runningBatch--;
+	}
+	dispatchLocked();
+}
+
+bool avjob_cancelled()
+{
+	return t_current_job && t_current_job->cancel.load();
+}
+
+int avjob_threads()
+{
+	return t_current_job ? t_current_job->threads : 0;
+}
+
+std::vector<int> avjob_split_threads(std::initializer_list<int> weights)
+{
+	std::vector<int> out(weights.size(), 0);
+	int total = avjob_threads();
+	if (total <= 0 || out.empty()) {
+		return out;
+	}
+	int sum = 0;
+	for (int w : weights) sum += std::max(0, w);
+	if (sum <= 0) sum = 1;
+	int used = 0;
+	size_t i = 0;
+	for (int w : weights) {
+		if (i + 1 == out.size()) {
+			out[i] = std::max(1, total - used);
+		}
+		else {
+			out[i] = std::max(1, total * std::max(0, w) / sum);
+			used += out[i];
+		}
+		++i;
+	}
+	return out;
+}
+
+void avjob_attach(AVFormatContext* in)
+{
+	AvJob* job = t_current_job;
+	if (!job || !in) return;
+	in->interrupt_callback.callback = avjob_interrupt;
+	in->interrupt_callback.opaque = job;
+	// 上一个输入读完的部分计入基数
+	job->bytes_base += job->last_tell;
+	job->pts_base_ms += job->last_pts_ms;
+	job->last_tell = 0;
+	job->last_pts_ms = 0;
+	job->input = in;
+}
+
+void avjob_set_duration(int64_t duration_ms)
+{
+	AvJob* job = t_current_job;
+	if (!job) return;
+	std::lock_guard<std::mutex> lock(job->mtx);
+	job->progress.duration_ms = duration_ms > 0 ? duration_ms : 0;
+}
+
+void avjob_report(int64_t frames, int64_t pts_ms)
+{
+	AvJob* job = t_current_job;
+	if (!job) return;
+	if (pts_ms > job->last_pts_ms) job->last_pts_ms = pts_ms;
+	if (job->input && job->input->pb) {
+		int64_t tell = avio_tell(job->input->pb);
+		if (tell > 0) job->last_tell = tell;
+	}
+	{
+		std::lock_guard<std::mutex> lock(job->mtx);
+		job->progress.frames = frames;
+		job->progress.pts_ms = job->pts_base_ms + job->last_pts_ms;
+		job->progress.bytes = job->bytes_base + job->last_tell;
+	}
+	if (job->callback && std::chrono::steady_clock::now() - job->last_notify >= std::chrono::milliseconds(200)) {
+		notify(job);
+	}
+}
+
+// -------------------- AvJob C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_SubmitResize(const char* input_url, const char* output_url, int dst_width, int dst_height, int preset,
+	AvJobCallback callback, void* user)
+{
+	if (!input_url || !output_url) return -1;
+	std::string in(input_url), out(output_url);
+	return AvJobManager::instance().submit([=]() {
+		AvWorker worker;
+		return worker.resize_video(in, out, dst_width, dst_height, preset);
+	}, out, callback, user, AvJobBatch, 0);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_SubmitSpliceMulti(const char** input_urls, int count, const char* output_url,
+	AvJobCallback callback, void* user)
+{
+	if (!input_urls || count < 2 || !output_url) return -1;
+	std::vector<std::string> urls;
+	for (int i = 0; i < count; ++i) {
+		if (!input_urls[i]) return -1;
+		urls.push_back(input_urls[i]);
+	}
+	std::string out(output_url);
+	return AvJobManager::instance().submit([=]() {
+		AvWorker worker;
+		return worker.SpliceAVMulti(urls, out, false);
+	}, out, callback, user, AvJobBatch, 2);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_SubmitSplitSmart(const char* input_url, const char* output_url, double start_seconds, double duration_seconds,
+	AvJobCallback callback, void* user)
+{
+	if (!input_url || !output_url) return -1;
+	std::string in(input_url), out(output_url);
+	return AvJobManager::instance().submit([=]() {
+		AvWorker worker;
+		return worker.split_video_smart(in, out, start_seconds, duration_seconds) == 0;
+	}, out, callback, user, AvJobBatch, 2);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_SubmitTask(AvJobTask task, void* task_user, int priority, int threads,
+	AvJobCallback callback, void* user)
+{
+	if (!task) return -1;
+	return AvJobManager::instance().submit([=]() {
+		return task(task_user) == 0;
+	}, std::string(), callback, user, priority, threads);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool AvJob_CurrentCancelled()
+{
+	return avjob_cancelled();
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_CurrentThreads()
+{
+	return avjob_threads();
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void AvJob_Shutdown(bool cancel_running)
+{
+	AvJobManager::instance().shutdown(cancel_running);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void AvJob_SetThreadLimit(int limit)
+{
+	AvJobManager::instance().setThreadLimit(limit);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool AvJob_GetSchedulerStats(AvSchedulerStats* stats)
+{
+	if (!stats) return false;
+	AvJobManager::instance().stats(*stats);
+	return true;
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool AvJob_GetProgress(int job_id, AvJobProgress* progress)
+{
+	if (!progress) return false;
+	return AvJobManager::instance().progress(job_id, *progress);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void AvJob_Cancel(int job_id)
+{
+	AvJobManager::instance().cancel(job_id);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvJob_Wait(int job_id)
+{
+	return AvJobManager::instance().wait(job_id);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void AvJob_Release(int job_id)
+{
+	AvJobManager::instance().release(job_id);
+}
@@ -0,0 +1,120 @@
+/*****************************************************************//**
+ * \file   AvJob.h
+ * \brief  进程内统一的作业调度：按线程需求和优先级派发，进度上报、通过FFmpeg中断回调取消
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "OpenCVFFMpegTools.h"
+
+struct AVFormatContext;
+
+// 一个作业；运行中的状态只由作业线程写，进度读写受mtx保护
+struct AvJob {
+	int id = 0;
+	std::function<bool()> task;
+	std::string output_path;  // 取消或失败时删除
+	AvJobCallback callback = nullptr;
+	void* user = nullptr;
+	int priority = AvJobBatch;
+	int appetite = 0;         // 提交时声明的线程数，0表示全部核
+	int threads = 0;          // 派发时实际分到的线程数
+	std::chrono::steady_clock::time_point submitted;
+
+	std::atomic<bool> cancel{ false };
+	std::mutex mtx;
+	std::condition_variable done_cv;
+	AvJobProgress progress = { AvJobQueued, 0, 0, 0, 0, 0 };
+
+	// 以下只在作业线程访问
+	AVFormatContext* input = nullptr; // 当前输入，流程返回前有效
+	int64_t bytes_base = 0;   // 之前输入已读的字节
+	int64_t pts_base_ms = 0;  // 之前输入的时长
+	int64_t last_tell = 0;
+	int64_t last_pts_ms = 0;
+	std::chrono::steady_clock::time_point last_notify;
+};
+
+// 作业调度器（进程内唯一）
+// 所有作业的线程需求之和不超过线程上限（默认CPU核数）；交互作业优先派发，
+// 批处理作业最多占用上限减一个线程，始终给缩略图/预览这类交互作业留出一个核。
+// 同一优先级按提交顺序派发，队首放不下时后面的也不越过它，避免大作业饿死。
+// 批处理有一个预留槽：没有批处理作业在运行时，队首的批处理作业不等交互队列排空、
+// 按剩余线程（至少1个）立即派发，文件夹扫描这类连续的交互作业不会饿死批处理。
+// 作业在可join的工作线程池中执行，shutdown等待运行中的作业结束
+class AvJobManager
+{
+public:
+	static AvJobManager& instance();
+
+	int submit(std::function<bool()> task, const std::string& output_path, AvJobCallback callback, void* user,
+		int priority, int threads);
+	bool progress(int id, AvJobProgress& out);
+	void cancel(int id);
+	int wait(int id);
+	void release(int id);
+
+	void setThreadLimit(int limit);
+	void stats(AvSchedulerStats& out);
+
+	/**
+	 * @brief 停止调度器：排队中的作业按取消结束，等待运行中的作业结束后join全部工作线程.
+	 *
+	 * 须在进程退出前（DLL卸载之前）调用，之后submit返回-1
+	 * \param cancelRunning 为true时同时取消运行中的作业
+	 */
+	void shutdown(bool cancelRunning);
+
+private:
+	AvJobManager();
+	void dispatchLocked();
+	void workerLoop();
+	void run(const std::shared_ptr<AvJob>& job);
+	std::shared_ptr<AvJob> find(int id);
+
+	std::mutex m_mtx;
+	std::deque<std::shared_ptr<AvJob>> m_queues[2]; // 按AvJobPriority
+	std::map<int, std::shared_ptr<AvJob>> m_jobs;
+	int m_nextId = 1;
+	int m_limit = 1;
+	int m_threadsInUse = 0;
+	int m_running = 0;
+	int m_runningBatch = 0;
+	// 工作线程池：已派发的作业放入m_ready，由空闲线程取走；没有空闲线程时新建
+	std::vector<std::thread> m_workers;
+	std::deque<std::shared_ptr<AvJob>> m_ready;
+	std::condition_variable m_readyCv;
+	int m_idleWorkers = 0;
+	bool m_stopping = false;
+	int64_t m_started = 0;
+	int64_t m_totalWaitMs = 0;
+	int64_t m_maxWaitMs = 0;
+};
+
+// ---- 供AvWorker各流程调用；不在作业线程中时都是空操作 ----
+
+// 当前线程正在执行的作业已被取消
+bool avjob_cancelled();
+// 当前作业分到的线程数，不在作业中时为0（由调用方按CPU核数自定）
+int avjob_threads();
+// 把当前作业分到的线程按权重分给流水线各阶段（解码/缩放/编码等），每段至少1个，余数归最后一段；
+// 流水线各阶段同时运行，各自按分到的数设置thread_count，合计不超过作业的份额。不在作业中时全为0
+std::vector<int> avjob_split_threads(std::initializer_list<int> weights);
+// 为刚打开的输入安装中断回调，并开始按它统计读取字节；多输入时按顺序对每个输入调用
+void avjob_attach(AVFormatContext* in);
+// 设置预计总时长
+void avjob_set_duration(int64_t duration_ms);
+// 上报进度：frames为累计值，pts_ms相对当前输入起点；内部节流后回调
+void avjob_report(int64_t frames, int64_t pts_ms);
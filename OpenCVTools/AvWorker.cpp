@@ -2,9 +2,32 @@
 #include "AvWorker.h"
 
 #include <algorithm>
+#include <deque>
+#include <memory>
 #include <vector>
 #include "LogStreamBuf.h"
+#include "BoundedQueue.h"
+#include "SliceScaler.h"
+#include "MediaIndex.h"
+#include "MediaBuffer.h"
+#include "AudioTranscoder.h"
+#include "StreamPassthrough.h"
+#include "AvJob.h"
+
+extern "C" {
+#include <libswresample/swresample.h>
+#include <libavutil/audio_fifo.h>
+}
 static LogStreamBuf log1("app.log");
+
+// 包时间（毫秒，相对输入起点），用于上报作业进度
+static int64_t packet_time_ms(const AVFormatContext* fmt, const AVPacket* pkt)
+{
+	int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+	if (ts == AV_NOPTS_VALUE) return 0;
+	int64_t start = fmt->start_time != AV_NOPTS_VALUE ? av_rescale(fmt->start_time, 1000, AV_TIME_BASE) : 0;
+	return av_rescale_q(ts, fmt->streams[pkt->stream_index]->time_base, { 1, 1000 }) - start;
+}
 AvWorker::AvWorker()
 {
 	
@@ -21,9 +44,59 @@ void AvWorker::finishAv()
 
 }
 
-// 调整视频分辨率函数 - 修复时间戳导致的时长异常问题
 bool AvWorker::resize_video(const std::string& input_path, const std::string& output_path,
 	int dst_width, int dst_height) {
+	return resize_video(input_path, output_path, dst_width, dst_height, ResizePresetBalanced);
+}
+
+// 解码/缩放/编码流水线上传递的帧，frame为空表示结束
+struct ResizeItem {
+	AVFrame* frame;
+};
+
+// AvResizePreset对应的x264预设和缩放算法
+static void resize_preset_options(int preset, const char*& x264_preset, int& sws_flags)
+{
+	x264_preset = "medium";
+	sws_flags = SWS_BILINEAR;
+	if (preset == ResizePresetFast) {
+		x264_preset = "veryfast";
+		sws_flags = SWS_FAST_BILINEAR;
+	}
+	else if (preset == ResizePresetQuality) {
+		x264_preset = "slow";
+		sws_flags = SWS_LANCZOS;
+	}
+}
+
+bool AvWorker::resize_video(const std::string& input_path, const std::string& output_path,
+	int dst_width, int dst_height, int preset) {
+	return resize_video_impl(input_path, output_path, dst_width, dst_height, preset, false, nullptr);
+}
+
+int AvWorker::benchmark_resize(const std::string& input_path, const std::string& output_path,
+	int dst_width, int dst_height, double* serial_fps, double* threaded_fps)
+{
+	// 两次都用medium档（改造前的默认），只比较线程/条带的差别
+	double fps[2] = { 0.0, 0.0 };
+	for (int run = 0; run < 2; ++run) {
+		if (!resize_video_impl(input_path, output_path, dst_width, dst_height, ResizePresetBalanced, run == 0, &fps[run])) {
+			std::cerr << "benchmark_resize " << (run == 0 ? "serial" : "threaded") << " run fair" << std::endl;
+			return -1;
+		}
+	}
+	std::cout << "resize benchmark | " << input_path << " -> " << dst_width << "x" << dst_height
+		<< " | serial fps:" << fps[0] << " | threaded fps:" << fps[1]
+		<< " | speedup:" << (fps[0] > 0 ? fps[1] / fps[0] : 0.0) << std::endl;
+	if (serial_fps) *serial_fps = fps[0];
+	if (threaded_fps) *threaded_fps = fps[1];
+	return 0;
+}
+
+// 调整视频分辨率函数 - 修复时间戳导致的时长异常问题
+// 解码线程、条带并行缩放线程、编码写入（当前线程）三段重叠执行
+bool AvWorker::resize_video_impl(const std::string& input_path, const std::string& output_path,
+	int dst_width, int dst_height, int preset, bool serial, double* fps_out) {
 
 	auto cleanup = [](AVFormatContext* in_fmt_ctx, AVFormatContext* out_fmt_ctx,
 		AVCodecContext* in_codec_ctx, AVCodecContext* out_codec_ctx,
@@ -57,9 +130,7 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 	AVCodecContext *in_codec_ctx = nullptr, *out_codec_ctx = nullptr;
 	SwsContext* sws_ctx = nullptr;
 	AVFrame *src_frame = nullptr, *dst_frame = nullptr;
-	AVPacket pkt = { 0 };
-	pkt.data = nullptr;
-	pkt.size = 0;
+	PacketRef pkt;
 
 	int ret, video_stream_idx = -1;
 	//帧计数，用于生成备用时间戳
@@ -88,6 +159,9 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 		avformat_network_deinit();
 		return false;
 	}
+	// 作为异步作业运行时可被取消，并上报进度
+	avjob_attach(in_fmt_ctx);
+	avjob_set_duration(in_fmt_ctx->duration != AV_NOPTS_VALUE ? in_fmt_ctx->duration / 1000 : 0);
 
 	// 查找视频流索引
 	for (int i = 0; i < in_fmt_ctx->nb_streams; i++) {
@@ -132,6 +206,14 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 		return false;
 	}
 
+	// 解码/缩放/编码三段同时运行，作业分到的线程按1:1:2分给它们；不在作业中时为0，按CPU核数。
+	// serial：解码器/编码器单线程、单条带缩放，作为对比基线
+	const std::vector<int> stage_threads = serial ? std::vector<int>{ 1, 1, 1 } : avjob_split_threads({ 1, 1, 2 });
+
+	// 解码器开启帧级+片级多线程
+	in_codec_ctx->thread_count = stage_threads[0];
+	in_codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 	ret = avcodec_open2(in_codec_ctx, in_codec, nullptr);
 	if (ret < 0) {
 		char err_buf[1024] = { 0 };
@@ -200,10 +282,15 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 	out_codec_ctx->gop_size = 10;
 	out_codec_ctx->max_b_frames = 1;
 
-	// 设置H264编码器参数（增加兼容性）
+	out_codec_ctx->thread_count = stage_threads[2];
+	out_codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+	// 档位：x264预设 + 缩放算法。不再用zerolatency，它会关掉x264的帧级多线程和lookahead
+	const char* x264_preset = nullptr;
+	int sws_flags = 0;
+	resize_preset_options(preset, x264_preset, sws_flags);
 	if (out_codec_ctx->codec_id == AV_CODEC_ID_H264) {
-		av_opt_set(out_codec_ctx->priv_data, "preset", "medium", 0);
-		av_opt_set(out_codec_ctx->priv_data, "tune", "zerolatency", 0);
+		av_opt_set(out_codec_ctx->priv_data, "preset", x264_preset, 0);
 	}
 
 	if (out_fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
@@ -232,6 +319,10 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 		return false;
 	}
 
+	// 音频/字幕直通：视频时间戳沿用输入，不需要偏移
+	StreamPassthrough passthrough;
+	passthrough.addStreams(in_fmt_ctx, out_fmt_ctx, 0);
+
 	// 打开输出文件
 	if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
 		ret = avio_open(&out_fmt_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE);
@@ -256,144 +347,205 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 		return false;
 	}
 
-	// 初始化缩放上下文
-	sws_ctx = sws_getContext(in_codec_ctx->width, in_codec_ctx->height, in_codec_ctx->pix_fmt,
-		dst_width, dst_height, out_codec_ctx->pix_fmt,
-		SWS_BILINEAR, nullptr, nullptr, nullptr);
-	if (!sws_ctx) {
+	// 初始化条带缩放器（sws_ctx保持为空，由SliceScaler管理各条带的上下文）
+	SliceScaler scaler;
+	if (!scaler.init(in_codec_ctx->width, in_codec_ctx->height, in_codec_ctx->pix_fmt,
+		dst_width, dst_height, out_codec_ctx->pix_fmt, sws_flags, stage_threads[1])) {
 		std::cerr << "sws_getContext fair" << std::endl;
 		cleanup(in_fmt_ctx, out_fmt_ctx, in_codec_ctx, out_codec_ctx, sws_ctx, src_frame, dst_frame);
 		avformat_network_deinit();
 		return false;
 	}
 
-	// 初始化帧
-	src_frame = av_frame_alloc();
-	if (!src_frame) {
-		std::cerr << "av_frame_alloc fair" << std::endl;
-		cleanup(in_fmt_ctx, out_fmt_ctx, in_codec_ctx, out_codec_ctx, sws_ctx, src_frame, dst_frame);
-		avformat_network_deinit();
-		return false;
-	}
-
-	dst_frame = av_frame_alloc();
-	if (!dst_frame) {
-		std::cerr << "av_frame_alloc fair" << std::endl;
-		cleanup(in_fmt_ctx, out_fmt_ctx, in_codec_ctx, out_codec_ctx, sws_ctx, src_frame, dst_frame);
-		avformat_network_deinit();
-		return false;
-	}
+	// 写入一个编码包，时间戳转换到输出流时间基
+	auto write_encoded = [&]() -> bool {
+		while (avcodec_receive_packet(out_codec_ctx, pkt.get()) >= 0) {
+			pkt->stream_index = out_stream->index;
+			av_packet_rescale_ts(pkt.get(), out_codec_ctx->time_base, out_stream->time_base);
+			pkt->duration = av_rescale_q(1, out_codec_ctx->time_base, out_stream->time_base); // 设置帧时长
 
-	dst_frame->width = dst_width;
-	dst_frame->height = dst_height;
-	dst_frame->format = out_codec_ctx->pix_fmt;
+			{
+				std::lock_guard<std::mutex> lock(passthrough.muxMutex());
+				ret = av_interleaved_write_frame(out_fmt_ctx, pkt.get());
+			}
+			pkt.unref();
+			if (ret < 0) {
+				char err_buf[1024] = { 0 };
+				av_strerror(ret, err_buf, sizeof(err_buf));
+				std::cerr << "av_interleaved_write_frame fair" << err_buf << std::endl;
+				return false;
+			}
+		}
+		return true;
+	};
 
-	ret = av_frame_get_buffer(dst_frame, 32);
-	if (ret < 0) {
-		char err_buf[1024] = { 0 };
-		av_strerror(ret, err_buf, sizeof(err_buf));
-		std::cerr << "av_frame_get_buffer fair" << err_buf << std::endl;
-		cleanup(in_fmt_ctx, out_fmt_ctx, in_codec_ctx, out_codec_ctx, sws_ctx, src_frame, dst_frame);
-		avformat_network_deinit();
-		return false;
-	}
+	// 处理视频帧（解码 -> 缩放 -> 编码写入，三段各占一个线程）
+	// 帧结构体和缩放输出缓冲区都从池里取、用完归还，稳态不再分配
+	FramePool frame_pool;
+	const size_t queue_capacity = 8;
+	BoundedQueue<ResizeItem> decoded_queue(queue_capacity);
+	BoundedQueue<ResizeItem> scaled_queue(queue_capacity);
+	std::atomic<bool> abort(false);
+	auto begin_time = std::chrono::steady_clock::now();
+	int64_t begin_allocs = media_buffer_alloc_count();
+	// 池预热后每帧不应再有缓冲区分配；解码/缩放线程的分配也计入同一全局计数
+	AllocSteadyCheck alloc_check("resize_video");
+
+	// 解码线程：解码器内部帧会被复用，交出去的是池中帧结构体上的引用
+	std::thread decode_thread([&]() {
+		PacketRef in_pkt;
+		FrameRef frame;
+		auto drain_decoder = [&]() -> bool {
+			while (frame.get() && avcodec_receive_frame(in_codec_ctx, frame.get()) >= 0) {
+				ResizeItem item = { frame_pool.ref(frame.get()) };
+				frame.unref();
+				if (!item.frame || !decoded_queue.push(item, abort)) {
+					frame_pool.recycle(item.frame);
+					abort.store(true);
+					return false;
+				}
+			}
+			return true;
+		};
+		bool decode_ok = frame.get() != nullptr && in_pkt.get() != nullptr;
+		while (decode_ok && !abort.load() && av_read_frame(in_fmt_ctx, in_pkt.get()) >= 0) {
+			if (in_pkt->stream_index == video_stream_idx) {
+				int send_ret = avcodec_send_packet(in_codec_ctx, in_pkt.get());
+				if (send_ret < 0) {
+					char err_buf[1024] = { 0 };
+					av_strerror(send_ret, err_buf, sizeof(err_buf));
+					std::cerr << "avcodec_send_packet fair" << err_buf << std::endl;
+					abort.store(true);
+					decode_ok = false;
+				}
+				else {
+					decode_ok = drain_decoder();
+				}
+			}
+			else if (passthrough.handles(in_pkt->stream_index)) {
+				// 音频/字幕包不解码，直接写入同一封装器
+				if (passthrough.write(in_pkt.get()) < 0) {
+					std::cerr << "passthrough av_interleaved_write_frame fair" << std::endl;
+					abort.store(true);
+					decode_ok = false;
+				}
+			}
+			in_pkt.unref();
+		}
+		// 冲刷解码器中多线程缓存的帧
+		if (decode_ok && !abort.load()) {
+			avcodec_send_packet(in_codec_ctx, nullptr);
+			drain_decoder();
+		}
+		ResizeItem eos = { nullptr };
+		decoded_queue.push(eos, abort);
+	});
+
+	// 缩放线程：每帧按条带并行缩放到池中取出的目标帧
+	std::thread scale_thread([&]() {
+		ResizeItem item;
+		while (decoded_queue.pop(item, abort)) {
+			if (!item.frame) {
+				scaled_queue.push(item, abort);
+				return;
+			}
+			ResizeItem out = { frame_pool.video(dst_width, dst_height, out_codec_ctx->pix_fmt) };
+			bool scale_ok = out.frame != nullptr && scaler.scale(item.frame, out.frame);
+			if (scale_ok) {
+				out.frame->pts = item.frame->best_effort_timestamp != AV_NOPTS_VALUE ?
+					item.frame->best_effort_timestamp : item.frame->pts;
+			}
+			frame_pool.recycle(item.frame);
+			if (!scale_ok) {
+				std::cerr << "sws_scale fair" << std::endl;
+				frame_pool.recycle(out.frame);
+				abort.store(true);
+				return;
+			}
+			if (!scaled_queue.push(out, abort)) {
+				frame_pool.recycle(out.frame);
+				return;
+			}
+		}
+	});
 
-	// 处理视频帧（解码→缩放→编码→写入）
+	// 编码写入：在当前线程
 	bool process_success = true;
-	while (av_read_frame(in_fmt_ctx, &pkt) >= 0) {
-		if (pkt.stream_index != video_stream_idx) {
-			av_packet_unref(&pkt);
-			continue;
+	ResizeItem item;
+	while (scaled_queue.pop(item, abort)) {
+		if (!item.frame) {
+			break;
 		}
-
-		// 解码帧
-		ret = avcodec_send_packet(in_codec_ctx, &pkt);
+		AVFrame* scaled = item.frame;
+
+		// PTS时间戳处理（增加边界校验，避免无效值）
+		int64_t pts = scaled->pts;
+		if (pts == AV_NOPTS_VALUE) {
+			// 无有效PTS时，用帧计数生成（frame_index * 时间基）
+			pts = frame_index * av_q2d(out_codec_ctx->time_base) * AV_TIME_BASE;
+			AVRational av_time_base_q = { 1, AV_TIME_BASE }; // 显式定义结构体变量
+			pts = av_rescale_q(pts, av_time_base_q, out_codec_ctx->time_base);
+		}
+		else {
+			// 有有效PTS时，正确转换到编码器时间基
+			pts = av_rescale_q(pts, in_time_base, out_codec_ctx->time_base);
+		}
+		scaled->pts = pts;
+		frame_index++;
+		avjob_report(frame_index, av_rescale_q(pts, out_codec_ctx->time_base, { 1, 1000 }) -
+			(in_fmt_ctx->start_time != AV_NOPTS_VALUE ? in_fmt_ctx->start_time / 1000 : 0));
+
+		// 编码帧
+		ret = avcodec_send_frame(out_codec_ctx, scaled);
+		frame_pool.recycle(scaled);
 		if (ret < 0) {
 			char err_buf[1024] = { 0 };
 			av_strerror(ret, err_buf, sizeof(err_buf));
-			std::cerr << "avcodec_send_packet fair" << err_buf << std::endl;
-			av_packet_unref(&pkt);
+			std::cerr << "avcodec_send_frame fair" << err_buf << std::endl;
 			process_success = false;
 			break;
 		}
-
-		while (avcodec_receive_frame(in_codec_ctx, src_frame) >= 0) {
-			// 缩放帧
-			sws_scale(sws_ctx, src_frame->data, src_frame->linesize, 0,
-				in_codec_ctx->height, dst_frame->data, dst_frame->linesize);
-
-			// PTS时间戳处理（增加边界校验，避免无效值）
-			int64_t pts = src_frame->pts;
-			if (pts == AV_NOPTS_VALUE) {
-				// 无有效PTS时，用帧计数生成（frame_index * 时间基）
-				pts = frame_index * av_q2d(out_codec_ctx->time_base) * AV_TIME_BASE;
-				AVRational av_time_base_q = { 1, AV_TIME_BASE }; // 显式定义结构体变量
-				pts = av_rescale_q(pts, av_time_base_q, out_codec_ctx->time_base);
-			}
-			else {
-				// 有有效PTS时，正确转换到编码器时间基
-				pts = av_rescale_q(pts, in_time_base, out_codec_ctx->time_base);
-			}
-			dst_frame->pts = pts;
-			dst_frame->pkt_dts = dst_frame->pts; // DTS和PTS对齐（避免B帧导致的时序问题）
-			frame_index++;
-
-			// 编码帧
-			ret = avcodec_send_frame(out_codec_ctx, dst_frame);
-			if (ret < 0) {
-				char err_buf[1024] = { 0 };
-				av_strerror(ret, err_buf, sizeof(err_buf));
-				std::cerr << "avcodec_send_frame fair" << err_buf << std::endl;
-				process_success = false;
-				break;
-			}
-
-			while (avcodec_receive_packet(out_codec_ctx, &pkt) >= 0) {
-				pkt.stream_index = out_stream->index;
-				// 数据包PTS/DTS转换到输出流时间基
-				av_packet_rescale_ts(&pkt, out_codec_ctx->time_base, out_stream->time_base);
-				pkt.dts = pkt.pts; // 兜底：DTS和PTS一致
-				pkt.duration = av_rescale_q(1, out_codec_ctx->time_base, out_stream->time_base); // 设置帧时长
-
-				ret = av_interleaved_write_frame(out_fmt_ctx, &pkt);
-				if (ret < 0) {
-					char err_buf[1024] = { 0 };
-					av_strerror(ret, err_buf, sizeof(err_buf));
-					std::cerr << "av_interleaved_write_frame fair" << err_buf << std::endl;
-					process_success = false;
-					break;
-				}
-				av_packet_unref(&pkt);
-			}
-			if (!process_success) break;
+		if (!write_encoded()) {
+			process_success = false;
+			break;
 		}
-		av_packet_unref(&pkt);
-		if (!process_success) break;
+		alloc_check.frameDone();
+	}
+	if (!process_success || abort.load()) {
+		process_success = false;
+		abort.store(true);
+	}
+
+	// 出错时取空队列，让上游线程退出
+	decode_thread.join();
+	scale_thread.join();
+	while (decoded_queue.tryPop(item)) {
+		frame_pool.recycle(item.frame);
+	}
+	while (scaled_queue.tryPop(item)) {
+		frame_pool.recycle(item.frame);
 	}
 
 	//  刷新编码器
 	if (process_success) {
 		avcodec_send_frame(out_codec_ctx, nullptr);
-		while (avcodec_receive_packet(out_codec_ctx, &pkt) >= 0) {
-			pkt.stream_index = out_stream->index;
-			av_packet_rescale_ts(&pkt, out_codec_ctx->time_base, out_stream->time_base);
-			pkt.dts = pkt.pts;
-			pkt.duration = av_rescale_q(1, out_codec_ctx->time_base, out_stream->time_base);
-
-			ret = av_interleaved_write_frame(out_fmt_ctx, &pkt);
-			if (ret < 0) {
-				char err_buf[1024] = { 0 };
-				av_strerror(ret, err_buf, sizeof(err_buf));
-				std::cerr << "av_interleaved_write_frame fair" << err_buf << std::endl;
-				process_success = false;
-				break;
-			}
-			av_packet_unref(&pkt);
-		}
+		process_success = write_encoded();
 	}
 
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	std::cout << "resize_video | " << in_codec_ctx->width << "x" << in_codec_ctx->height
+		<< " -> " << dst_width << "x" << dst_height
+		<< " | preset:" << x264_preset << " | slices:" << scaler.sliceCount()
+		<< " | frames:" << frame_index << " | seconds:" << seconds
+		<< " | fps:" << (seconds > 0 ? frame_index / seconds : 0.0) << (serial ? " | serial" : "")
+		<< " | buffer allocs:" << (media_buffer_alloc_count() - begin_allocs)
+		<< " | copied streams:" << passthrough.copiedStreams()
+		<< " | transcoded streams:" << passthrough.transcodedStreams() << std::endl;
+	alloc_check.report();
+
 	// 写入文件尾
 	if (process_success) {
+		passthrough.flush();
 		ret = av_write_trailer(out_fmt_ctx);
 		if (ret < 0) {
 			char err_buf[1024] = { 0 };
@@ -403,6 +555,10 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 		}
 	}
 
+	if (fps_out) {
+		*fps_out = seconds > 0 ? frame_index / seconds : 0.0;
+	}
+
 	// 统一清理资源
 	cleanup(in_fmt_ctx, out_fmt_ctx, in_codec_ctx, out_codec_ctx, sws_ctx, src_frame, dst_frame);
 	avformat_network_deinit();
@@ -410,6 +566,297 @@ bool AvWorker::resize_video(const std::string& input_path, const std::string& ou
 	return process_success;
 }
 
+// 码率阶梯中的一路输出：独立的缩放器/编码器/封装器，在自己的线程里消费解码帧
+struct LadderBranch {
+	std::string url;
+	int width = 0;
+	int height = 0;
+	AVFormatContext* fmt = nullptr;
+	AVCodecContext* enc = nullptr;
+	AVStream* stream = nullptr;
+	SliceScaler scaler;
+	FramePool scaled_pool;         // 本路缩放输出
+	FramePool* source_pool = nullptr; // 分发来的源帧引用由它回收
+	PacketRef pkt;
+	std::unique_ptr<BoundedQueue<ResizeItem>> queue;
+	std::atomic<bool> abort{ false }; // 本路出错时置位，解码线程不再给它送帧
+	bool header_written = false;
+	bool ok = false;
+	int64_t frames = 0;
+	std::thread worker;
+
+	~LadderBranch()
+	{
+		if (enc) avcodec_free_context(&enc);
+		if (fmt) {
+			if (!(fmt->oformat->flags & AVFMT_NOFILE))
+				avio_closep(&fmt->pb);
+			avformat_free_context(fmt);
+		}
+	}
+
+	bool open(const AVCodecContext* dec, const AVStream* in_stream, AVRational frame_rate,
+		int bit_rate, const char* x264_preset, int sws_flags, int slices, int enc_threads)
+	{
+		if (avformat_alloc_output_context2(&fmt, nullptr, nullptr, url.c_str()) < 0) {
+			std::cerr << "avformat_alloc_output_context2 fair " << url << std::endl;
+			return false;
+		}
+		AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+		if (!codec) {
+			std::cerr << "avcodec_find_encoder fair" << std::endl;
+			return false;
+		}
+		stream = avformat_new_stream(fmt, codec);
+		enc = avcodec_alloc_context3(codec);
+		if (!stream || !enc) {
+			std::cerr << "avformat_new_stream fair" << std::endl;
+			return false;
+		}
+		enc->width = width;
+		enc->height = height;
+		enc->pix_fmt = AV_PIX_FMT_YUV420P;
+		enc->time_base = in_stream->time_base;
+		enc->framerate = frame_rate;
+		enc->gop_size = 10;
+		enc->max_b_frames = 1;
+		enc->thread_count = enc_threads;
+		enc->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+		if (bit_rate > 0) enc->bit_rate = bit_rate;
+		av_opt_set(enc->priv_data, "preset", x264_preset, 0);
+		if (fmt->oformat->flags & AVFMT_GLOBALHEADER) {
+			enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+		}
+		if (avcodec_open2(enc, codec, nullptr) < 0 ||
+			avcodec_parameters_from_context(stream->codecpar, enc) < 0) {
+			std::cerr << "avcodec_open2 fair " << url << std::endl;
+			return false;
+		}
+		stream->time_base = enc->time_base;
+
+		if (!scaler.init(dec->width, dec->height, dec->pix_fmt, width, height, enc->pix_fmt, sws_flags, slices)) {
+			std::cerr << "sws_getContext fair" << std::endl;
+			return false;
+		}
+
+		if (!(fmt->oformat->flags & AVFMT_NOFILE) && avio_open(&fmt->pb, url.c_str(), AVIO_FLAG_WRITE) < 0) {
+			std::cerr << "avio_open fair " << url << std::endl;
+			return false;
+		}
+		if (avformat_write_header(fmt, nullptr) < 0) {
+			std::cerr << "avformat_write_header fair " << url << std::endl;
+			return false;
+		}
+		header_written = true;
+		queue.reset(new BoundedQueue<ResizeItem>(8));
+		return true;
+	}
+
+	bool write_encoded()
+	{
+		while (avcodec_receive_packet(enc, pkt.get()) >= 0) {
+			pkt->stream_index = stream->index;
+			av_packet_rescale_ts(pkt.get(), enc->time_base, stream->time_base);
+			int ret = av_interleaved_write_frame(fmt, pkt.get());
+			pkt.unref();
+			if (ret < 0) {
+				std::cerr << "av_interleaved_write_frame fair " << url << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 线程主体：取共享的源帧引用 -> 缩放 -> 编码写入，收到空帧后冲刷并写文件尾
+	void run(int64_t frame_duration)
+	{
+		bool success = pkt.get() != nullptr;
+		ResizeItem item;
+		while (success && queue->pop(item, abort)) {
+			if (!item.frame) {
+				break;
+			}
+			AVFrame* scaled = scaled_pool.video(width, height, enc->pix_fmt);
+			success = scaled != nullptr && scaler.scale(item.frame, scaled);
+			if (success) {
+				int64_t pts = item.frame->best_effort_timestamp;
+				scaled->pts = pts != AV_NOPTS_VALUE ? pts : frames * frame_duration;
+				success = avcodec_send_frame(enc, scaled) >= 0 && write_encoded();
+			}
+			scaled_pool.recycle(scaled);
+			source_pool->recycle(item.frame);
+			frames++;
+		}
+		if (success) {
+			avcodec_send_frame(enc, nullptr);
+			success = write_encoded() && av_write_trailer(fmt) >= 0;
+		}
+		ok = success;
+		if (!success) {
+			std::cerr << "[error] rendition fair: " << url << std::endl;
+		}
+		// 出错后不再接收，取空剩余的帧引用
+		abort.store(true);
+		while (queue->tryPop(item)) {
+			source_pool->recycle(item.frame);
+		}
+	}
+};
+
+/**
+ * @brief 一次解码输出多档分辨率（码率阶梯）.
+ *
+ * 解码在当前线程，每路输出一个线程；解码帧以池中帧结构体分发引用，各路共享同一份解码图像
+ * \return 成功输出的路数，打开输入失败返回-1
+ */
+int AvWorker::resize_video_ladder(const std::string& input_path, const AvRendition* renditions, int count, int preset)
+{
+	if (input_path.empty() || !renditions || count <= 0) {
+		std::cerr << "resize_video_ladder invalid param" << std::endl;
+		return -1;
+	}
+
+	avformat_network_init();
+	AVFormatContext* in_fmt_ctx = nullptr;
+	AVCodecContext* dec = nullptr;
+	auto cleanup = [&]() {
+		if (dec) avcodec_free_context(&dec);
+		if (in_fmt_ctx) avformat_close_input(&in_fmt_ctx);
+		avformat_network_deinit();
+	};
+
+	if (avformat_open_input(&in_fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0 ||
+		avformat_find_stream_info(in_fmt_ctx, nullptr) < 0) {
+		std::cerr << "avformat_open_input fair: " << input_path << std::endl;
+		cleanup();
+		return -1;
+	}
+	int video_idx = av_find_best_stream(in_fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_idx < 0) {
+		std::cerr << "video_stream_idx is -1" << std::endl;
+		cleanup();
+		return -1;
+	}
+	AVStream* in_stream = in_fmt_ctx->streams[video_idx];
+	AVCodec* decoder = avcodec_find_decoder(in_stream->codecpar->codec_id);
+	dec = decoder ? avcodec_alloc_context3(decoder) : nullptr;
+	if (!dec || avcodec_parameters_to_context(dec, in_stream->codecpar) < 0) {
+		std::cerr << "avcodec_find_decoder fair" << std::endl;
+		cleanup();
+		return -1;
+	}
+	// 作业中的线程按 解码1 : 各路缩放合计count : 各路编码合计2*count 切分
+	const std::vector<int> stage_threads = avjob_split_threads({ 1, count, 2 * count });
+	dec->thread_count = stage_threads[0];
+	dec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+	if (avcodec_open2(dec, decoder, nullptr) < 0) {
+		std::cerr << "avcodec_open2 fair" << std::endl;
+		cleanup();
+		return -1;
+	}
+
+	const char* x264_preset = nullptr;
+	int sws_flags = 0;
+	resize_preset_options(preset, x264_preset, sws_flags);
+
+	AVRational frame_rate = in_stream->r_frame_rate;
+	if (frame_rate.num == 0 || frame_rate.den == 0) {
+		frame_rate = { 30, 1 }; // 兜底：默认30fps
+	}
+	const int64_t frame_duration = std::max<int64_t>(1, av_rescale_q(1, av_inv_q(frame_rate), in_stream->time_base));
+
+	// 各路分摊CPU核做条带缩放（作业中只分摊缩放阶段分到的线程）
+	int cores = stage_threads[1];
+	if (cores <= 0) cores = static_cast<int>(std::thread::hardware_concurrency());
+	int slices = std::max(1, cores / count);
+	int enc_threads = stage_threads[2] > 0 ? std::max(1, stage_threads[2] / count) : 0;
+
+	FramePool source_pool; // 须比各路活得久
+	std::vector<std::unique_ptr<LadderBranch>> branches;
+	for (int i = 0; i < count; ++i) {
+		const AvRendition& r = renditions[i];
+		if (!r.output_url || r.width <= 0 || r.height <= 0 || r.width % 2 != 0 || r.height % 2 != 0) {
+			std::cerr << "[error] rendition " << i << " invalid, skip" << std::endl;
+			continue;
+		}
+		std::unique_ptr<LadderBranch> branch(new LadderBranch());
+		branch->url = r.output_url;
+		branch->width = r.width;
+		branch->height = r.height;
+		branch->source_pool = &source_pool;
+		if (!branch->open(dec, in_stream, frame_rate, r.bit_rate, x264_preset, sws_flags, slices, enc_threads)) {
+			continue;
+		}
+		branches.push_back(std::move(branch));
+	}
+	if (branches.empty()) {
+		cleanup();
+		return 0;
+	}
+
+	auto begin_time = std::chrono::steady_clock::now();
+	int64_t begin_allocs = media_buffer_alloc_count();
+	for (auto& branch : branches) {
+		LadderBranch* b = branch.get();
+		b->worker = std::thread([b, frame_duration]() { b->run(frame_duration); });
+	}
+
+	// 分发：每路拿到的是同一解码缓冲的引用，不拷贝像素
+	int64_t decoded = 0;
+	FrameRef frame;
+	auto fan_out = [&]() {
+		while (avcodec_receive_frame(dec, frame.get()) >= 0) {
+			for (auto& branch : branches) {
+				if (branch->abort.load()) continue;
+				ResizeItem item = { source_pool.ref(frame.get()) };
+				// 该路出错时push放弃并返回false，引用在这里归还
+				if (item.frame && !branch->queue->push(item, branch->abort)) {
+					source_pool.recycle(item.frame);
+				}
+			}
+			frame.unref();
+			decoded++;
+		}
+	};
+
+	PacketRef pkt;
+	while (frame.get() && pkt.get() && av_read_frame(in_fmt_ctx, pkt.get()) >= 0) {
+		if (pkt->stream_index == video_idx && avcodec_send_packet(dec, pkt.get()) >= 0) {
+			fan_out();
+		}
+		pkt.unref();
+	}
+	if (frame.get()) {
+		avcodec_send_packet(dec, nullptr);
+		fan_out();
+	}
+
+	int written = 0;
+	for (auto& branch : branches) {
+		ResizeItem eos = { nullptr };
+		branch->queue->push(eos, branch->abort);
+	}
+	for (auto& branch : branches) {
+		branch->worker.join();
+		if (branch->ok) written++;
+		// 出错的一路在自己取空队列之后，分发端仍可能入队成功，join后再取空一次，归还帧引用
+		ResizeItem left;
+		while (branch->queue->tryPop(left)) {
+			if (left.frame) source_pool.recycle(left.frame);
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	std::cout << "resize_video_ladder | " << dec->width << "x" << dec->height
+		<< " | renditions:" << written << "/" << count << " | frames:" << decoded
+		<< " | seconds:" << seconds << " | fps:" << (seconds > 0 ? decoded / seconds : 0.0)
+		<< " | buffer allocs:" << (media_buffer_alloc_count() - begin_allocs) << std::endl;
+
+	branches.clear();
+	cleanup();
+	return written;
+}
+
 // 保存RGB数据为BMP图片
 bool AvWorker::SaveFrameToBmp(const uint8_t* rgb_data, int width, int height, const std::string& output_path) {
 	// 严格按照BMP标准定义结构体（禁用编译器对齐）
@@ -624,19 +1071,19 @@ bool AvWorker::GetVideoFirstFrame(const std::string& input_url, const std::strin
 		codec_ctx->width, codec_ctx->height, 1);
 
 	// 8. 读取并解码第一帧
-	AVPacket pkt = { 0 };
+	PacketRef pkt;
 	bool got_first_frame = false;
-	while (av_read_frame(fmt_ctx, &pkt) >= 0 && !got_first_frame) {
-		if (pkt.stream_index != video_stream_idx) {
-			av_packet_unref(&pkt);
+	while (av_read_frame(fmt_ctx, pkt.get()) >= 0 && !got_first_frame) {
+		if (pkt->stream_index != video_stream_idx) {
+			pkt.unref();
 			continue;
 		}
 
 		// 发送数据包到解码器
-		ret = avcodec_send_packet(codec_ctx, &pkt);
+		ret = avcodec_send_packet(codec_ctx, pkt.get());
 		if (ret < 0) {
 			std::cerr << "send packet fair" << std::endl;
-			av_packet_unref(&pkt);
+			pkt.unref();
 			continue;
 		}
 
@@ -654,7 +1101,7 @@ bool AvWorker::GetVideoFirstFrame(const std::string& input_url, const std::strin
 			got_first_frame = true; // 拿到第一帧后退出循环
 		}
 
-		av_packet_unref(&pkt);
+		pkt.unref();
 	}
 
 	if (!got_first_frame) {
@@ -674,634 +1121,1661 @@ bool AvWorker::GetVideoFirstFrame(const std::string& input_url, const std::strin
 }
 
 
-bool AvWorker::SpliceAV(const std::string& input_url1, const std::string& input_url2, const std::string& output_url, bool is_rtsp)
+/**
+ * @brief 快速缩略图.
+ *
+ * 与GetVideoFirstFrame相比：限制探测量，只解关键帧，解码器支持时用lowres降分辨率解码，
+ * 一次sws直接缩放到缩略图尺寸，结果编码在内存中返回而不落盘
+ */
+bool AvWorker::GetVideoThumbnail(const std::string& input_url, int max_width, int max_height, int format,
+	double seek_seconds, std::vector<uint8_t>& out, int& out_width, int& out_height, bool is_rtsp)
 {
-	//  初始化FFmpeg网络模块（本地文件也建议保留，兼容RTSP场景）
+	out.clear();
+	out_width = out_height = 0;
+	if (input_url.empty() || max_width <= 0 || max_height <= 0) {
+		std::cerr << "GetVideoThumbnail invalid param" << std::endl;
+		return false;
+	}
+
 	avformat_network_init();
+	AVFormatContext* fmt_ctx = nullptr;
+	AVCodecContext* codec_ctx = nullptr;
+	AVFrame* frame = av_frame_alloc();
+	auto cleanup = [&]() {
+		if (frame) av_frame_free(&frame);
+		if (codec_ctx) avcodec_free_context(&codec_ctx);
+		if (fmt_ctx) avformat_close_input(&fmt_ctx);
+		avformat_network_deinit();
+	};
 
-	// 资源初始化（所有资源默认置空，便于统一释放）
-	AVFormatContext* fmt_ctx1 = nullptr;
-	AVFormatContext* fmt_ctx2 = nullptr;
-	AVFormatContext* out_fmt_ctx = nullptr;
+	// 只探测开头一小段，缩略图不需要精确的码率/帧率统计
 	AVDictionary* options = nullptr;
-	int ret = 0;
-	bool is_success = false; // 标记整体操作是否成功
-
-	// 针对RTSP流设置参数（本地文件会自动忽略）
+	av_dict_set(&options, "probesize", "262144", 0);
+	av_dict_set(&options, "analyzeduration", "500000", 0);
 	if (is_rtsp) {
 		av_dict_set(&options, "rtsp_transport", "tcp", 0);
 		av_dict_set(&options, "stimeout", "5000000", 0);
-		av_dict_set(&options, "max_delay", "1000000", 0);
 	}
-
-	// 打开第一个输入文件/流（错误处理：失败则直接释放资源返回）
-	ret = avformat_open_input(&fmt_ctx1, input_url1.c_str(), nullptr, &options);
-	if (ret < 0) {
-		char err_buf[1024] = { 0 };
-		av_strerror(ret, err_buf, sizeof(err_buf));
-		std::cerr << "[error] open_input 1 fair index: " << input_url1 << "-" << err_buf << std::endl;
-		av_dict_free(&options);
-		avformat_network_deinit();
+	int ret = avformat_open_input(&fmt_ctx, input_url.c_str(), nullptr, &options);
+	av_dict_free(&options);
+	if (ret < 0 || !frame) {
+		std::cerr << "open input fair: " << input_url << std::endl;
+		cleanup();
 		return false;
 	}
-
-	// 打开第二个输入文件/流（错误处理：失败则释放第一个输入资源）
-	ret = avformat_open_input(&fmt_ctx2, input_url2.c_str(), nullptr, &options);
-	if (ret < 0){
-		char err_buf[1024] = { 0 };
-		av_strerror(ret, err_buf, sizeof(err_buf));
-		std::cerr << "[error]open_input 2 fair index:" << input_url2 << "-" << err_buf << std::endl;
-		av_dict_free(&options);
-		avformat_close_input(&fmt_ctx1);
-		avformat_network_deinit();
+	if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+		std::cerr << "Get stream info failed" << std::endl;
+		cleanup();
 		return false;
 	}
-	av_dict_free(&options);
-	options = nullptr;
 
-	// 获取第一个输入流信息
-	ret = avformat_find_stream_info(fmt_ctx1, nullptr);
-	if (ret < 0) {
-		std::cerr << "[error]find_stream_info 1 fair index:" << input_url1 << std::endl;
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
+	int video_stream_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_stream_idx < 0) {
+		std::cerr << "video_stream_idx is -1" << std::endl;
+		cleanup();
 		return false;
 	}
+	AVStream* stream = fmt_ctx->streams[video_stream_idx];
+	// 其它流的包直接在解复用层丢弃
+	for (unsigned int i = 0; i < fmt_ctx->nb_streams; ++i) {
+		if (static_cast<int>(i) != video_stream_idx) {
+			fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+		}
+	}
 
-	// 获取第二个输入流信息
-	ret = avformat_find_stream_info(fmt_ctx2, nullptr);
-	if (ret < 0) {
-		std::cerr << "[error]find_stream_info 2 fair index:" << input_url2 << std::endl;
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
+	AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+	codec_ctx = codec ? avcodec_alloc_context3(codec) : nullptr;
+	if (!codec_ctx || avcodec_parameters_to_context(codec_ctx, stream->codecpar) < 0) {
+		std::cerr << "avcodec_find_decoder fair" << std::endl;
+		cleanup();
 		return false;
 	}
-
-	// 打印输入流信息（调试用）
-	std::cout << "[info] Input 1 streams count: " << fmt_ctx1->nb_streams << std::endl;
-	std::cout << "[info] Input 2 streams count: " << fmt_ctx2->nb_streams << std::endl;
-
-	// 创建输出上下文
-	ret = avformat_alloc_output_context2(&out_fmt_ctx, nullptr, nullptr, output_url.c_str());
-	if (!out_fmt_ctx) {
-		std::cerr << "[error]craete output stream fair index:" << output_url << std::endl;
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
+	// 只解关键帧；单线程避免帧级多线程带来的额外延迟
+	codec_ctx->skip_frame = AVDISCARD_NONKEY;
+	codec_ctx->thread_count = 1;
+	codec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+	// 解码器支持lowres时，选不小于缩略图尺寸的最低分辨率
+	int lowres = 0;
+	while (lowres < av_codec_get_max_lowres(codec) &&
+		(codec_ctx->width >> (lowres + 1)) >= max_width && (codec_ctx->height >> (lowres + 1)) >= max_height) {
+		lowres++;
+	}
+	codec_ctx->lowres = lowres;
+	if (avcodec_open2(codec_ctx, codec, nullptr) < 0) {
+		std::cerr << "open codec fair" << std::endl;
+		cleanup();
 		return false;
 	}
 
-	// 复制流信息到输出上下文
-	bool stream_copy_ok = true;
-	for (int i = 0; i < fmt_ctx1->nb_streams && stream_copy_ok; i++) {
-		AVStream* in_stream = fmt_ctx1->streams[i];
-		AVStream* out_stream = avformat_new_stream(out_fmt_ctx, nullptr);
-
-		if (!out_stream) {
-			std::cerr << "[error]create output stream fair index:" << i << std::endl;
-			stream_copy_ok = false;
-			break;
+	// 定位到指定时间之前的关键帧
+	if (seek_seconds > 0) {
+		int64_t ts = av_rescale_q(static_cast<int64_t>(seek_seconds * AV_TIME_BASE), { 1, AV_TIME_BASE }, stream->time_base);
+		if (av_seek_frame(fmt_ctx, video_stream_idx, ts, AVSEEK_FLAG_BACKWARD) >= 0) {
+			avcodec_flush_buffers(codec_ctx);
 		}
+	}
 
-		// 复制流参数
-		ret = avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
-		if (ret < 0) {
-			char err_buf[1024] = { 0 };
-			av_strerror(ret, err_buf, sizeof(err_buf));
-			std::cerr << "[error]copy stream fair index:" << i << " - " << err_buf << std::endl;
-			stream_copy_ok = false;
+	PacketRef pkt;
+	bool got_frame = false;
+	bool eof = false;
+	while (!got_frame) {
+		if (!eof) {
+			ret = av_read_frame(fmt_ctx, pkt.get());
+			if (ret < 0) {
+				eof = true;
+				avcodec_send_packet(codec_ctx, nullptr);
+			}
+			else {
+				if (pkt->stream_index == video_stream_idx) {
+					avcodec_send_packet(codec_ctx, pkt.get());
+				}
+				pkt.unref();
+			}
+		}
+		ret = avcodec_receive_frame(codec_ctx, frame);
+		if (ret == 0) {
+			got_frame = true;
+		}
+		else if (eof) {
 			break;
 		}
-		out_stream->codecpar->codec_tag = 0;
-
-		// 关键：把输入流的 time_base 同步到输出流，避免后续 rescale 使用错误 time_base
-		out_stream->time_base = in_stream->time_base;
-		out_stream->avg_frame_rate = in_stream->avg_frame_rate;
-		out_stream->r_frame_rate = in_stream->r_frame_rate;
-		out_stream->sample_aspect_ratio = in_stream->sample_aspect_ratio;
 	}
-
-	// 流复制失败的错误处理
-	if (!stream_copy_ok) {
-		avformat_free_context(out_fmt_ctx);
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
+	if (!got_frame) {
+		std::cerr << "got_first_frame is NULL" << std::endl;
+		cleanup();
 		return false;
 	}
 
-	// 打开输出文件IO
-	if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-		ret = avio_open(&out_fmt_ctx->pb, output_url.c_str(), AVIO_FLAG_WRITE);
-		if (ret < 0) {
-			char err_buf[1024] = { 0 };
-			av_strerror(ret, err_buf, sizeof(err_buf));
-			std::cerr << "[error]open  output fair url:" << output_url << " - " << err_buf << std::endl;
-			avformat_free_context(out_fmt_ctx);
-			avformat_close_input(&fmt_ctx1);
-			avformat_close_input(&fmt_ctx2);
-			avformat_network_deinit();
-			return false;
-		}
+	// 按比例缩放到不超过max_width x max_height，宽高取偶数便于后续使用
+	double scale = std::min(static_cast<double>(max_width) / frame->width, static_cast<double>(max_height) / frame->height);
+	scale = std::min(scale, 1.0);
+	out_width = std::max(2, static_cast<int>(frame->width * scale) & ~1);
+	out_height = std::max(2, static_cast<int>(frame->height * scale) & ~1);
+
+	cv::Mat bgr(out_height, out_width, CV_8UC3);
+	SwsContext* sws_ctx = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+		out_width, out_height, AV_PIX_FMT_BGR24, SWS_AREA, nullptr, nullptr, nullptr);
+	if (!sws_ctx) {
+		std::cerr << "create sws_ctx fair" << std::endl;
+		cleanup();
+		return false;
 	}
+	uint8_t* dst_data[4] = { bgr.data, nullptr, nullptr, nullptr };
+	int dst_linesize[4] = { static_cast<int>(bgr.step), 0, 0, 0 };
+	sws_scale(sws_ctx, frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
+	sws_freeContext(sws_ctx);
 
-	//  写入文件头
-	ret = avformat_write_header(out_fmt_ctx, nullptr);
-	if (ret < 0) {
-		char err_buf[1024] = { 0 };
-		av_strerror(ret, err_buf, sizeof(err_buf));
-		std::cerr << "[error]write header fair" << output_url << "-" << err_buf << std::endl;
+	bool ok = true;
+	if (format == ThumbFormatJpeg) {
+		std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, 85 };
+		ok = cv::imencode(".jpg", bgr, out, params);
+	}
+	else if (format == ThumbFormatPng) {
+		std::vector<int> params = { cv::IMWRITE_PNG_COMPRESSION, 1 };
+		ok = cv::imencode(".png", bgr, out, params);
+	}
+	else {
+		out.assign(bgr.data, bgr.data + static_cast<size_t>(out_width) * out_height * 3); // 紧密排列的BGR24
+	}
+
+	cleanup();
+	return ok && !out.empty();
+}
+
+bool AvWorker::SpliceAV(const std::string& input_url1, const std::string& input_url2, const std::string& output_url, bool is_rtsp)
+{
+	// 两路拼接即N路拼接的特例
+	std::vector<std::string> inputs;
+	inputs.push_back(input_url1);
+	inputs.push_back(input_url2);
+	return SpliceAVMulti(inputs, output_url, is_rtsp);
+}
 
-		// 释放输出资源
-		if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-			avio_closep(&out_fmt_ctx->pb);
+/**
+ * @brief FFmpeg视频分割（避免空指针访问）
+ * @param input_path 输入视频路径（必须是本地可访问的MP4文件）
+ * @param output_path 输出视频路径
+ * @param start_seconds 起始时间（秒，>=0）
+ * @param duration_seconds 持续时长（秒，0表示到结尾）
+ * @return 0成功，-1失败
+ */
+int AvWorker::split_video(const std::string& input_path,
+	const std::string& output_path,
+	double start_seconds,
+	double duration_seconds) {
+	// 1. 参数合法性校验
+	if (input_path.empty() || output_path.empty()) {
+		std::cerr << "错误：输入或输出路径为空" << std::endl;
+		return -1;
+	}
+	if (start_seconds < 0) {
+		std::cerr << "错误：起始时间不能为负数" << std::endl;
+		return -1;
+	}
+	if (duration_seconds < 0) {
+		std::cerr << "错误：持续时长不能为负数" << std::endl;
+		return -1;
+	}
+
+	// 初始化FFmpeg相关变量，全部初始化为nullptr避免空指针
+	AVFormatContext *input_fmt_ctx = nullptr;
+	AVFormatContext *output_fmt_ctx = nullptr;
+	int ret = -1;
+
+	// 打开输入文件
+	if (avformat_open_input(&input_fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0) {
+		std::cerr << "错误：无法打开输入文件 " << input_path << std::endl;
+
+		if (output_fmt_ctx) {
+			if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+				avio_closep(&output_fmt_ctx->pb);
+			}
+			avformat_free_context(output_fmt_ctx);
+		}
+		if (input_fmt_ctx) {
+			avformat_close_input(&input_fmt_ctx);
 		}
-		avformat_free_context(out_fmt_ctx);
+		return -1;
+	}
 
-		// 释放输入资源
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
-		return false;
+	// 获取输入文件流信息
+	if (avformat_find_stream_info(input_fmt_ctx, nullptr) < 0) {
+		std::cerr << "错误：无法获取流信息" << std::endl;
+		avformat_close_input(&input_fmt_ctx);
+		return -1;
 	}
 
-	// 处理第一个视频的音视频帧
-	AVPacket pkt = {};
-	av_packet_unref(&pkt);
+	// 创建输出格式上下文
+	if (avformat_alloc_output_context2(&output_fmt_ctx, nullptr, nullptr, output_path.c_str()) < 0) {
+		std::cerr << "错误：无法创建输出格式上下文" << std::endl;
+		avformat_close_input(&input_fmt_ctx);
+		return -1;
+	}
 
-	// 定义AVRounding枚举变量，解决类型不兼容问题
-	AVRounding rounding = static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+	// 5. 遍历输入流，创建对应的输出流
+	int video_stream_index = -1;
+	int audio_stream_index = -1;
+	for (unsigned int i = 0; i < input_fmt_ctx->nb_streams; i++) {
+		AVStream *in_stream = input_fmt_ctx->streams[i];
+		AVStream *out_stream = avformat_new_stream(output_fmt_ctx, nullptr);
+		if (!out_stream) {
+			std::cerr << "错误：无法创建输出流" << std::endl;
+			avformat_free_context(output_fmt_ctx);
+			avformat_close_input(&input_fmt_ctx);
+			return -1;
+		}
 
-	// 按“每个输出流”累计结束时间戳 + 最后一帧的DTS/PTS（用于单调性校验）
-	const int out_nb_streams = static_cast<int>(out_fmt_ctx->nb_streams);
-	std::vector<int64_t> out_stream_end_ts(out_nb_streams, 0);        // 拼接偏移量
-	std::vector<int64_t> out_stream_last_dts(out_nb_streams, -1);     // 最后一帧的DTS
-	std::vector<int64_t> out_stream_last_pts(out_nb_streams, -1);     // 最后一帧的PTS
-	std::vector<bool> out_stream_has_ts(out_nb_streams, false);
+		// 复制流参数
+		if (avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
+			std::cerr << "错误：无法复制流参数" << std::endl;
+			avformat_free_context(output_fmt_ctx);
+			avformat_close_input(&input_fmt_ctx);
+			return -1;
+		}
+		out_stream->codecpar->codec_tag = 0;
 
-	auto rescale_ts = [&](int64_t ts, const AVRational& in_tb, const AVRational& out_tb) -> int64_t {
-		if (ts == AV_NOPTS_VALUE) {
-			return AV_NOPTS_VALUE;
+		// 记录视频/音频流索引
+		if (in_stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && video_stream_index == -1) {
+			video_stream_index = i;
 		}
-		return av_rescale_q_rnd(ts, in_tb, out_tb, rounding);
-	};
+		else if (in_stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && audio_stream_index == -1) {
+			audio_stream_index = i;
+		}
+	}
 
-	// 时间戳单调性修正函数
-	auto fix_timestamp_monotonic = [&](int stream_idx, int64_t& pts, int64_t& dts) {
-		if (stream_idx < 0 || stream_idx >= out_nb_streams) return;
+	// 检查是否找到视频流
+	if (video_stream_index == -1) {
+		std::cerr << "错误：输入文件中未找到视频流" << std::endl;
+		avformat_free_context(output_fmt_ctx);
+		avformat_close_input(&input_fmt_ctx);
+		return -1;
+	}
 
-		// 修正DTS（必须严格递增）
-		if (dts != AV_NOPTS_VALUE) {
-			if (out_stream_last_dts[stream_idx] >= 0) {
-				if (dts <= out_stream_last_dts[stream_idx]) {
-					dts = out_stream_last_dts[stream_idx] + 1;
-				}
-			}
-			out_stream_last_dts[stream_idx] = dts;
+	// 6. 打开输出文件
+	if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		if (avio_open(&output_fmt_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE) < 0) {
+			std::cerr << "错误：无法打开输出文件 " << output_path << std::endl;
+			avformat_free_context(output_fmt_ctx);
+			avformat_close_input(&input_fmt_ctx);
+			return -1;
 		}
+	}
 
-		// 修正PTS（PTS >= DTS 且递增）
-		if (pts != AV_NOPTS_VALUE) {
-			if (out_stream_last_pts[stream_idx] >= 0) {
-				if (pts <= out_stream_last_pts[stream_idx]) {
-					pts = out_stream_last_pts[stream_idx] + 1;
-				}
+	// 写入文件头
+	if (avformat_write_header(output_fmt_ctx, nullptr) < 0) {
+		std::cerr << "错误：无法写入文件头" << std::endl;
+		if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+			avio_closep(&output_fmt_ctx->pb);
+		}
+		avformat_free_context(output_fmt_ctx);
+		avformat_close_input(&input_fmt_ctx);
+		return -1;
+	}
+
+	// 计算时间戳
+	AVRational ration = { 1,AV_TIME_BASE };
+	int64_t start_ts = av_rescale_q(static_cast<int64_t>(start_seconds * AV_TIME_BASE),
+		ration,
+		input_fmt_ctx->streams[video_stream_index]->time_base);
+	int64_t end_ts = AV_NOPTS_VALUE;
+	if (duration_seconds > 0) {
+		end_ts = av_rescale_q(static_cast<int64_t>((start_seconds + duration_seconds) * AV_TIME_BASE),
+			ration,
+			input_fmt_ctx->streams[video_stream_index]->time_base);
+	}
+
+	// 定位到起始时间位置：纯复制只能从关键帧开始，切点对齐到起点前的关键帧，输出时间戳以该关键帧为0，
+	// 避免从非关键帧开头导致花屏。关键帧索引已缓存时按它的准确时间戳跳，否则不为此扫描整个文件，
+	// 直接向前跳到目标前的关键帧，以读到的第一个视频关键帧为切点
+	AVStream *video_in = input_fmt_ctx->streams[video_stream_index];
+	int64_t video_start = video_in->start_time != AV_NOPTS_VALUE ? video_in->start_time : 0;
+	int64_t seek_ts = video_start + start_ts;
+	if (end_ts != AV_NOPTS_VALUE) {
+		end_ts += video_start;
+	}
+	std::vector<double> keyframes;
+	int key = MediaIndex::instance().cachedKeyframes(input_path, keyframes) ?
+		MediaIndex::keyframeBefore(keyframes, start_seconds) : -1;
+	if (key >= 0) {
+		seek_ts = video_start + static_cast<int64_t>(llround(keyframes[key] / av_q2d(video_in->time_base)));
+	}
+	if (av_seek_frame(input_fmt_ctx, video_stream_index, seek_ts, AVSEEK_FLAG_BACKWARD) < 0) {
+		std::cerr << "av_seek_frame fair ,read from beginning" << std::endl;
+	}
+	start_ts = AV_NOPTS_VALUE; // 读到第一个视频关键帧时确定
+
+	// 读取并写入帧
+	PacketRef pkt;
+
+	while (av_read_frame(input_fmt_ctx, pkt.get()) >= 0) {
+		AVStream *in_stream = input_fmt_ctx->streams[pkt->stream_index];
+		AVStream *out_stream = output_fmt_ctx->streams[pkt->stream_index];
+		bool is_video = pkt->stream_index == video_stream_index;
+		int64_t pkt_ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+
+		// 第一个视频关键帧之前的包（跳转落点前残留的各流数据）丢弃
+		if (start_ts == AV_NOPTS_VALUE) {
+			if (!is_video || !(pkt->flags & AV_PKT_FLAG_KEY) || pkt_ts == AV_NOPTS_VALUE) {
+				pkt.unref();
+				continue;
 			}
-			// 确保PTS >= DTS
-			if (dts != AV_NOPTS_VALUE && pts < dts) {
-				pts = dts;
+			start_ts = pkt_ts;
+		}
+
+		// 检查是否超出结束时间
+		if (end_ts != AV_NOPTS_VALUE && pkt->pts != AV_NOPTS_VALUE) {
+			int64_t end_check = av_rescale_q(pkt->pts, in_stream->time_base, video_in->time_base);
+			if (end_check > end_ts) {
+				pkt.unref();
+				break;
 			}
-			out_stream_last_pts[stream_idx] = pts;
 		}
-	};
 
-	bool first_video_write_ok = true;
-	int first_video_frame_count = 0; // 统计第一个视频写入帧数
-	while (first_video_write_ok && av_read_frame(fmt_ctx1, &pkt) >= 0) {
-		const int out_index = pkt.stream_index;
-		if (out_index < 0 || out_index >= out_nb_streams) {
-			av_packet_unref(&pkt);
-			pkt = {};
+		// 切点换算到当前流的时间基；切点之前的其它流数据包，以及开放GOP中显示时间早于关键帧、
+		// 参考上一个GOP的前导B帧都会得到负的pts，丢弃
+		int64_t stream_start_ts = av_rescale_q(start_ts, video_in->time_base, in_stream->time_base);
+		if (pkt_ts != AV_NOPTS_VALUE && pkt_ts < stream_start_ts) {
+			pkt.unref();
 			continue;
 		}
 
-		AVStream* in_stream = fmt_ctx1->streams[pkt.stream_index];
-		AVStream* out_stream = out_fmt_ctx->streams[out_index];
-		if (!out_stream) {
-			av_packet_unref(&pkt);
-			pkt = {};
-			continue;
+		// 调整时间戳（相对起始时间）
+		if (pkt->pts != AV_NOPTS_VALUE) {
+			pkt->pts = av_rescale_q_rnd(pkt->pts - stream_start_ts,
+				in_stream->time_base,
+				out_stream->time_base,
+				static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
 		}
+		if (pkt->dts != AV_NOPTS_VALUE) {
+			pkt->dts = av_rescale_q_rnd(pkt->dts - stream_start_ts,
+				in_stream->time_base,
+				out_stream->time_base,
+				static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
+		}
+		if (pkt->duration > 0) {
+			pkt->duration = av_rescale_q(pkt->duration,
+				in_stream->time_base,
+				out_stream->time_base);
+		}
+		pkt->pos = -1;
 
-		// 时基转换
-		pkt.pts = rescale_ts(pkt.pts, in_stream->time_base, out_stream->time_base);
-		pkt.dts = rescale_ts(pkt.dts, in_stream->time_base, out_stream->time_base);
-		pkt.duration = av_rescale_q(pkt.duration, in_stream->time_base, out_stream->time_base);
-		pkt.pos = -1;
+		// 写入数据包
+		if (av_interleaved_write_frame(output_fmt_ctx, pkt.get()) < 0) {
+			std::cerr << "错误：写入帧失败" << std::endl;
+			pkt.unref();
+			break;
+		}
+		pkt.unref();
+	}
 
-		// 修正时间戳单调性（第一个视频也要做）
-		fix_timestamp_monotonic(out_index, pkt.pts, pkt.dts);
+	// 11. 写入文件尾
+	av_write_trailer(output_fmt_ctx);
+	ret = 0; // 执行到这里表示成功
 
-		ret = av_interleaved_write_frame(out_fmt_ctx, &pkt);
-		if (ret < 0) {
-			char err_buf[1024] = { 0 };
-			av_strerror(ret, err_buf, sizeof(err_buf));
-			std::cerr << "[error] write first frame failed, stream: " << out_index << " - " << err_buf << std::endl;
-			first_video_write_ok = false;
-			av_packet_unref(&pkt);
-			pkt = {};
-			break;
+
+
+	return ret;
+}
+
+// ---------------- 智能剪切 ----------------
+
+// 把avcC格式extradata中的SPS/PPS转成带长度前缀的NAL，接在复制的第一个关键帧前面，
+// 使重编码片段的参数集被覆盖回原始参数集
+static bool avcc_parameter_sets(const AVCodecParameters* par, std::vector<uint8_t>& out, int& nal_size)
+{
+	const uint8_t* p = par->extradata;
+	int size = par->extradata_size;
+	if (!p || size < 7 || p[0] != 1) {
+		return false; // 不是avcC
+	}
+	nal_size = (p[4] & 3) + 1;
+	int pos = 5;
+	for (int pass = 0; pass < 2; ++pass) {
+		if (pos >= size) return false;
+		int count = pass == 0 ? (p[pos] & 0x1f) : p[pos];
+		pos++;
+		for (int i = 0; i < count; ++i) {
+			if (pos + 2 > size) return false;
+			int len = (p[pos] << 8) | p[pos + 1];
+			pos += 2;
+			if (pos + len > size) return false;
+			for (int b = nal_size - 1; b >= 0; --b) {
+				out.push_back(static_cast<uint8_t>((len >> (8 * b)) & 0xff));
+			}
+			out.insert(out.end(), p + pos, p + pos + len);
+			pos += len;
 		}
+	}
+	return true;
+}
 
-		first_video_frame_count++;
+// Annex B（起始码分隔）转为长度前缀格式
+static void annexb_to_length_prefixed(const uint8_t* data, int size, int nal_size, std::vector<uint8_t>& out)
+{
+	auto find_start = [&](int from, int& sc_len) {
+		for (int i = from; i + 3 <= size; ++i) {
+			if (data[i] == 0 && data[i + 1] == 0) {
+				if (data[i + 2] == 1) { sc_len = 3; return i; }
+				if (i + 4 <= size && data[i + 2] == 0 && data[i + 3] == 1) { sc_len = 4; return i; }
+			}
+		}
+		sc_len = 0;
+		return size;
+	};
 
-		// 累计每个输出流的结束时间戳（用修正后的DTS）
-		int64_t ts_for_end = (pkt.dts != AV_NOPTS_VALUE) ? pkt.dts : pkt.pts;
-		if (ts_for_end != AV_NOPTS_VALUE) {
-			int64_t end_ts = ts_for_end + ((pkt.duration > 0) ? pkt.duration : 1);
-			if (!out_stream_has_ts[out_index] || end_ts > out_stream_end_ts[out_index]) {
-				out_stream_end_ts[out_index] = end_ts;
-				out_stream_has_ts[out_index] = true;
+	int sc_len = 0;
+	int start = find_start(0, sc_len);
+	while (start < size) {
+		int nal_begin = start + sc_len;
+		int next_len = 0;
+		int next = find_start(nal_begin, next_len);
+		int len = next - nal_begin;
+		if (len > 0) {
+			for (int b = nal_size - 1; b >= 0; --b) {
+				out.push_back(static_cast<uint8_t>((len >> (8 * b)) & 0xff));
 			}
+			out.insert(out.end(), data + nal_begin, data + next);
 		}
+		start = next;
+		sc_len = next_len;
+	}
+}
 
-		av_packet_unref(&pkt);
-		pkt = {};
+// 从Annex B格式的数据（编码器extradata）中找到SPS，取出profile_idc和level_idc
+static bool annexb_sps_profile_level(const uint8_t* data, int size, int& profile, int& level)
+{
+	for (int i = 0; i + 6 <= size; ++i) {
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 && (data[i + 3] & 0x1f) == 7) {
+			profile = data[i + 4];
+			level = data[i + 6];
+			return true;
+		}
 	}
+	return false;
+}
 
-	std::cout << "[info] First video frame count: " << first_video_frame_count << std::endl;
+/**
+ * @brief 关键帧精确的智能剪切.
+ *
+ * 从起点前的关键帧开始解码，只把[起点, 下一个关键帧)这段重编码，之后全部直接复制数据包；
+ * 起点恰好是关键帧或编码器不可用时退化为从关键帧开始的纯复制。
+ * 重编码按源的profile/level/像素格式配置，编码器给出的SPS与源不一致时（两套参数集无法衔接）整段重编码
+ * @return 0成功，-1失败
+ */
+int AvWorker::split_video_smart(const std::string& input_path,
+	const std::string& output_path,
+	double start_seconds,
+	double duration_seconds) {
+	if (input_path.empty() || output_path.empty()) {
+		std::cerr << "错误：输入或输出路径为空" << std::endl;
+		return -1;
+	}
+	if (start_seconds < 0 || duration_seconds < 0) {
+		std::cerr << "错误：起始时间/持续时长不能为负数" << std::endl;
+		return -1;
+	}
 
-	// 第一个视频写入失败的错误处理
-	if (!first_video_write_ok) {
-		av_write_trailer(out_fmt_ctx);
-		if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-			avio_closep(&out_fmt_ctx->pb);
+	auto begin_time = std::chrono::steady_clock::now();
+	AVFormatContext* in_fmt_ctx = nullptr;
+	AVFormatContext* out_fmt_ctx = nullptr;
+	AVCodecContext* dec_ctx = nullptr;
+	AVCodecContext* enc_ctx = nullptr;
+	AVFrame* frame = nullptr;
+	PacketRef pkt;
+	PacketRef enc_pkt;
+	PacketRef out_pkt;
+
+	auto cleanup = [&]() {
+		pkt.unref();
+		enc_pkt.unref();
+		if (frame) av_frame_free(&frame);
+		if (dec_ctx) avcodec_free_context(&dec_ctx);
+		if (enc_ctx) avcodec_free_context(&enc_ctx);
+		if (in_fmt_ctx) avformat_close_input(&in_fmt_ctx);
+		if (out_fmt_ctx) {
+			if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE))
+				avio_closep(&out_fmt_ctx->pb);
+			avformat_free_context(out_fmt_ctx);
+			out_fmt_ctx = nullptr;
 		}
-		avformat_free_context(out_fmt_ctx);
-		avformat_close_input(&fmt_ctx1);
-		avformat_close_input(&fmt_ctx2);
-		avformat_network_deinit();
-		return false;
+	};
+
+	if (avformat_open_input(&in_fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0 ||
+		avformat_find_stream_info(in_fmt_ctx, nullptr) < 0) {
+		std::cerr << "split_video_smart open input fair " << input_path << std::endl;
+		cleanup();
+		return -1;
+	}
+	avjob_attach(in_fmt_ctx);
+	if (duration_seconds > 0) {
+		avjob_set_duration(static_cast<int64_t>(duration_seconds * 1000));
+	}
+	else if (in_fmt_ctx->duration != AV_NOPTS_VALUE) {
+		avjob_set_duration(in_fmt_ctx->duration / 1000 - static_cast<int64_t>(start_seconds * 1000));
+	}
+	int64_t read_packets = 0;
+
+	int video_idx = av_find_best_stream(in_fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_idx < 0) {
+		std::cerr << "错误：输入文件中未找到视频流" << std::endl;
+		cleanup();
+		return -1;
 	}
+	AVStream* in_video = in_fmt_ctx->streams[video_idx];
 
-	// 处理第二个视频的音视频帧
-	pkt = {};
-	av_packet_unref(&pkt);
+	if (avformat_alloc_output_context2(&out_fmt_ctx, nullptr, nullptr, output_path.c_str()) < 0) {
+		std::cerr << "错误：无法创建输出格式上下文" << std::endl;
+		cleanup();
+		return -1;
+	}
 
-	// 流映射（按类型匹配）
-	std::vector<int> stream_mapping2(static_cast<int>(fmt_ctx2->nb_streams), -1);
-	std::vector<int> video_stream_idx;
-	std::vector<int> audio_stream_idx;
-	for (int j = 0; j < out_nb_streams; ++j) {
-		AVStream* out = out_fmt_ctx->streams[j];
-		if (out->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-			video_stream_idx.push_back(j);
+	// 只保留视频和音频流，stream_map[i]为输入流i对应的输出流下标
+	std::vector<int> stream_map(in_fmt_ctx->nb_streams, -1);
+	for (unsigned int i = 0; i < in_fmt_ctx->nb_streams; i++) {
+		AVMediaType type = in_fmt_ctx->streams[i]->codecpar->codec_type;
+		if ((int)i != video_idx && type != AVMEDIA_TYPE_AUDIO) {
+			continue;
 		}
-		else if (out->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-			audio_stream_idx.push_back(j);
+		AVStream* out_stream = avformat_new_stream(out_fmt_ctx, nullptr);
+		if (!out_stream || avcodec_parameters_copy(out_stream->codecpar, in_fmt_ctx->streams[i]->codecpar) < 0) {
+			std::cerr << "错误：无法创建输出流" << std::endl;
+			cleanup();
+			return -1;
 		}
+		out_stream->codecpar->codec_tag = 0;
+		out_stream->time_base = in_fmt_ctx->streams[i]->time_base;
+		stream_map[i] = out_stream->index;
 	}
 
-	int video_idx = 0, audio_idx = 0;
-	for (int i = 0; i < static_cast<int>(fmt_ctx2->nb_streams); ++i) {
-		AVStream* in2 = fmt_ctx2->streams[i];
-		if (in2->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && video_idx < video_stream_idx.size()) {
-			stream_mapping2[i] = video_stream_idx[video_idx++];
+	// 起止时间相对视频起点（TS、带编辑列表的MP4等start_time不为0），换成与包时间戳可比的绝对值；
+	// 之后视频与音频都减去同一个start_ts，输出仍从0开始且两者对齐
+	int64_t video_start = in_video->start_time != AV_NOPTS_VALUE ? in_video->start_time : 0;
+	int64_t start_ts = video_start +
+		av_rescale_q(static_cast<int64_t>(start_seconds * AV_TIME_BASE), { 1, AV_TIME_BASE }, in_video->time_base);
+	int64_t end_ts = AV_NOPTS_VALUE;
+	if (duration_seconds > 0) {
+		end_ts = video_start +
+			av_rescale_q(static_cast<int64_t>((start_seconds + duration_seconds) * AV_TIME_BASE), { 1, AV_TIME_BASE }, in_video->time_base);
+	}
+
+	// 回退到起点之前的关键帧
+	if (av_seek_frame(in_fmt_ctx, video_idx, start_ts, AVSEEK_FLAG_BACKWARD) < 0) {
+		std::cerr << "av_seek_frame fair ,read from beginning" << std::endl;
+	}
+
+	// 只对H.264做拼接（参数集可从avcC恢复），其它编码退化为从关键帧复制
+	std::vector<uint8_t> param_sets;
+	int nal_size = 4;
+	bool can_reencode = in_video->codecpar->codec_id == AV_CODEC_ID_H264 &&
+		avcc_parameter_sets(in_video->codecpar, param_sets, nal_size);
+
+	AVCodec* decoder = can_reencode ? avcodec_find_decoder(in_video->codecpar->codec_id) : nullptr;
+	AVCodec* encoder = can_reencode ? avcodec_find_encoder(in_video->codecpar->codec_id) : nullptr;
+	// 整段重编码：编码器的参数集与源不兼容，不能与复制的GOP拼在一起
+	bool full_reencode = false;
+	const std::vector<int> stage_threads = avjob_split_threads({ 1, 3 });
+	if (decoder && encoder) {
+		dec_ctx = avcodec_alloc_context3(decoder);
+		if (!dec_ctx || avcodec_parameters_to_context(dec_ctx, in_video->codecpar) < 0) {
+			can_reencode = false;
 		}
-		else if (in2->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && audio_idx < audio_stream_idx.size()) {
-			stream_mapping2[i] = audio_stream_idx[audio_idx++];
+		else {
+			dec_ctx->thread_count = stage_threads[0];
+			if (avcodec_open2(dec_ctx, decoder, nullptr) < 0) {
+				can_reencode = false;
+			}
+		}
+
+		// 按源的profile/level/像素格式配置编码器，使重编码片段的SPS与源一致
+		AVPixelFormat src_fmt = static_cast<AVPixelFormat>(in_video->codecpar->format);
+		auto configure_encoder = [&](AVCodecContext* ctx, bool global_header) {
+			ctx->width = in_video->codecpar->width;
+			ctx->height = in_video->codecpar->height;
+			ctx->pix_fmt = src_fmt != AV_PIX_FMT_NONE ? src_fmt :
+				(dec_ctx->pix_fmt != AV_PIX_FMT_NONE ? dec_ctx->pix_fmt : AV_PIX_FMT_YUV420P);
+			ctx->profile = in_video->codecpar->profile;
+			ctx->level = in_video->codecpar->level;
+			ctx->sample_aspect_ratio = in_video->codecpar->sample_aspect_ratio;
+			ctx->time_base = in_video->time_base;
+			ctx->framerate = av_guess_frame_rate(in_fmt_ctx, in_video, nullptr);
+			ctx->gop_size = global_header ? 250 : 600; // 拼接时片段内只需一个I帧
+			ctx->max_b_frames = 0; // 保证dts单调，便于与复制部分衔接
+			ctx->thread_count = stage_threads[1];
+			if (global_header) {
+				ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+			}
+			av_opt_set(ctx->priv_data, "preset", "veryfast", 0);
+			av_opt_set(ctx->priv_data, "crf", "18", 0);
+		};
+
+		// 先用GLOBAL_HEADER打开一次，从extradata取编码器实际输出的profile/level与源比较
+		AVCodecContext* probe_ctx = can_reencode ? avcodec_alloc_context3(encoder) : nullptr;
+		if (probe_ctx) {
+			configure_encoder(probe_ctx, true);
+		}
+		if (!probe_ctx || avcodec_open2(probe_ctx, encoder, nullptr) < 0) {
+			if (can_reencode) {
+				std::cerr << "smart cut encoder open fair, fallback to keyframe copy" << std::endl;
+			}
+			can_reencode = false;
 		}
 		else {
-			stream_mapping2[i] = -1;
+			int enc_profile = -1, enc_level = -1;
+			const uint8_t* avcc = in_video->codecpar->extradata;
+			bool same = probe_ctx->pix_fmt == src_fmt &&
+				annexb_sps_profile_level(probe_ctx->extradata, probe_ctx->extradata_size, enc_profile, enc_level) &&
+				enc_profile == avcc[1] && enc_level == avcc[3];
+			if (!same) {
+				// 用带全局参数集的编码器整段重编码，输出流的extradata换成编码器的
+				std::cout << "smart cut: encoder sps (profile " << enc_profile << " level " << enc_level
+					<< ") differs from source (profile " << (int)avcc[1] << " level " << (int)avcc[3]
+					<< "), reencode whole segment" << std::endl;
+				full_reencode = true;
+				enc_ctx = probe_ctx;
+				probe_ctx = nullptr;
+				AVStream* out_stream = out_fmt_ctx->streams[stream_map[video_idx]];
+				if (avcodec_parameters_from_context(out_stream->codecpar, enc_ctx) < 0) {
+					can_reencode = false;
+				}
+				out_stream->codecpar->codec_tag = 0;
+			}
+			else {
+				avcodec_free_context(&probe_ctx);
+				// 不设置GLOBAL_HEADER，参数集随关键帧带出
+				enc_ctx = avcodec_alloc_context3(encoder);
+				if (!enc_ctx) {
+					can_reencode = false;
+				}
+				else {
+					configure_encoder(enc_ctx, false);
+					if (avcodec_open2(enc_ctx, encoder, nullptr) < 0) {
+						std::cerr << "smart cut encoder open fair, fallback to keyframe copy" << std::endl;
+						can_reencode = false;
+					}
+				}
+			}
+			if (probe_ctx) {
+				avcodec_free_context(&probe_ctx);
+			}
+		}
+		if (full_reencode && !can_reencode) {
+			// 输出流已改为编码器参数，无法再退回复制
+			std::cerr << "smart cut full reencode fair" << std::endl;
+			cleanup();
+			return -1;
 		}
 	}
-
-	// 打印映射信息
-	std::cout << "[info] Stream mapping for input 2: " << std::endl;
-	for (int i = 0; i < stream_mapping2.size(); ++i) {
-		std::cout << "  Input2 stream " << i << " -> Output stream " << stream_mapping2[i] << std::endl;
+	else {
+		can_reencode = false;
 	}
 
-	// 第二个视频的首帧偏移（按流独立计算）
-	std::vector<int64_t> in2_first_pts(static_cast<int>(fmt_ctx2->nb_streams), AV_NOPTS_VALUE);
-	std::vector<int64_t> in2_first_dts(static_cast<int>(fmt_ctx2->nb_streams), AV_NOPTS_VALUE);
-
-	bool second_video_write_ok = true;
-	int second_video_frame_count = 0;
+	if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		if (avio_open(&out_fmt_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE) < 0) {
+			std::cerr << "错误：无法打开输出文件 " << output_path << std::endl;
+			cleanup();
+			return -1;
+		}
+	}
+	if (avformat_write_header(out_fmt_ctx, nullptr) < 0) {
+		std::cerr << "错误：无法写入文件头" << std::endl;
+		cleanup();
+		return -1;
+	}
 
-	while (second_video_write_ok && av_read_frame(fmt_ctx2, &pkt) >= 0) {
-		const int in_index = pkt.stream_index;
-		if (in_index < 0 || in_index >= static_cast<int>(stream_mapping2.size())) {
-			av_packet_unref(&pkt);
-			pkt = {};
-			continue;
+	AVStream* out_video = out_fmt_ctx->streams[stream_map[video_idx]];
+	frame = av_frame_alloc();
+
+	// 0: 等待起点前的关键帧 1: 重编码起点到下一关键帧 2: 直接复制
+	int phase = 0;
+	bool video_done = false;
+	bool write_error = false;
+	int64_t last_video_dts = AV_NOPTS_VALUE;
+	int64_t last_video_duration = 0;
+	int reencoded_frames = 0;
+	int copied_packets = 0;
+	// 重编码片段没有B帧，dts==pts；按源首个关键帧的pts-dts整体前移，使其dts与复制部分的解码延迟一致
+	int64_t head_dts_shift = 0;
+	// 复制部分整体加的常量偏移（输出时间基），在第一个复制包处算出一次，pts/dts同加
+	int64_t copy_offset = 0;
+	bool copy_started = false;
+
+	// 写一个视频包：时间戳平移到起点；复制的包再加上与重编码片段衔接的常量偏移
+	auto write_video = [&](AVPacket* p, AVRational src_tb, bool copied) {
+		if (p->pts != AV_NOPTS_VALUE) p->pts = av_rescale_q(p->pts - start_ts, src_tb, out_video->time_base);
+		if (p->dts != AV_NOPTS_VALUE) p->dts = av_rescale_q(p->dts - start_ts, src_tb, out_video->time_base);
+		if (p->duration > 0) p->duration = av_rescale_q(p->duration, src_tb, out_video->time_base);
+		if (copied) {
+			if (!copy_started) {
+				copy_started = true;
+				if (last_video_dts != AV_NOPTS_VALUE && p->dts != AV_NOPTS_VALUE && p->dts <= last_video_dts) {
+					copy_offset = last_video_dts + std::max<int64_t>(1, last_video_duration) - p->dts;
+					std::cout << "smart cut: copied part delayed by " << copy_offset << " ticks" << std::endl;
+				}
+			}
+			if (p->pts != AV_NOPTS_VALUE) p->pts += copy_offset;
+			if (p->dts != AV_NOPTS_VALUE) p->dts += copy_offset;
 		}
-		const int out_index = stream_mapping2[in_index];
-		if (out_index < 0 || out_index >= out_nb_streams) {
-			av_packet_unref(&pkt);
-			pkt = {};
-			continue;
+		if (p->dts != AV_NOPTS_VALUE) {
+			last_video_dts = p->dts;
+			last_video_duration = p->duration;
 		}
-
-		AVStream* in_stream = fmt_ctx2->streams[in_index];
-		AVStream* out_stream = out_fmt_ctx->streams[out_index];
-		if (!out_stream) {
-			av_packet_unref(&pkt);
-			pkt = {};
-			second_video_write_ok = false;
-			break;
+		p->stream_index = out_video->index;
+		p->pos = -1;
+		if (av_interleaved_write_frame(out_fmt_ctx, p) < 0) {
+			std::cerr << "错误：写入帧失败" << std::endl;
+			write_error = true;
 		}
+	};
 
-		// 转换到输出时基
-		int64_t new_pts = rescale_ts(pkt.pts, in_stream->time_base, out_stream->time_base);
-		int64_t new_dts = rescale_ts(pkt.dts, in_stream->time_base, out_stream->time_base);
-		int64_t new_duration = av_rescale_q(pkt.duration, in_stream->time_base, out_stream->time_base);
+	// 取出编码器中的包并写入；编码器时间基为输入时间基，frame->pts未平移
+	auto drain_encoder = [&]() {
+		while (avcodec_receive_packet(enc_ctx, enc_pkt.get()) >= 0) {
+			if (full_reencode) {
+				// 输出流用编码器的extradata，由封装器处理起始码
+				write_video(enc_pkt.get(), enc_ctx->time_base, false);
+				enc_pkt.unref();
+				continue;
+			}
+			std::vector<uint8_t> converted;
+			annexb_to_length_prefixed(enc_pkt->data, enc_pkt->size, nal_size, converted);
+			if (av_new_packet(out_pkt.get(), static_cast<int>(converted.size())) == 0) {
+				memcpy(out_pkt->data, converted.data(), converted.size());
+				out_pkt->pts = enc_pkt->pts;
+				out_pkt->dts = enc_pkt->dts != AV_NOPTS_VALUE ? enc_pkt->dts - head_dts_shift : AV_NOPTS_VALUE;
+				out_pkt->duration = enc_pkt->duration;
+				out_pkt->flags = enc_pkt->flags;
+				write_video(out_pkt.get(), enc_ctx->time_base, false);
+				out_pkt.unref();
+			}
+			enc_pkt.unref();
+		}
+	};
 
-		// 第二个视频自身起点归零（按流独立）
-		if (new_pts != AV_NOPTS_VALUE && in2_first_pts[in_index] == AV_NOPTS_VALUE) {
-			in2_first_pts[in_index] = new_pts;
+	// 解码并把[起点, 终点)的帧送入编码器
+	auto decode_and_encode = [&](AVPacket* p) {
+		if (avcodec_send_packet(dec_ctx, p) < 0) {
+			return;
 		}
-		if (new_dts != AV_NOPTS_VALUE && in2_first_dts[in_index] == AV_NOPTS_VALUE) {
-			in2_first_dts[in_index] = new_dts;
+		while (avcodec_receive_frame(dec_ctx, frame) >= 0) {
+			int64_t ts = frame->best_effort_timestamp;
+			if (ts != AV_NOPTS_VALUE && ts >= start_ts && (end_ts == AV_NOPTS_VALUE || ts < end_ts)) {
+				frame->pts = ts;
+				frame->pict_type = reencoded_frames == 0 ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+				if (avcodec_send_frame(enc_ctx, frame) >= 0) {
+					reencoded_frames++;
+				}
+				drain_encoder();
+			}
+			av_frame_unref(frame);
 		}
-		if (new_pts != AV_NOPTS_VALUE && in2_first_pts[in_index] != AV_NOPTS_VALUE) {
-			new_pts -= in2_first_pts[in_index];
+	};
+
+	// 结束重编码阶段：冲刷解码器和编码器
+	auto finish_reencode = [&]() {
+		decode_and_encode(nullptr);
+		avcodec_send_frame(enc_ctx, nullptr);
+		drain_encoder();
+	};
+
+	while (!write_error && av_read_frame(in_fmt_ctx, pkt.get()) >= 0) {
+		avjob_report(++read_packets, packet_time_ms(in_fmt_ctx, pkt.get()) - static_cast<int64_t>(start_seconds * 1000));
+		int out_idx = stream_map[pkt->stream_index];
+		if (out_idx < 0) {
+			pkt.unref();
+			continue;
 		}
-		if (new_dts != AV_NOPTS_VALUE && in2_first_dts[in_index] != AV_NOPTS_VALUE) {
-			new_dts -= in2_first_dts[in_index];
+		AVStream* in_stream = in_fmt_ctx->streams[pkt->stream_index];
+
+		if (pkt->stream_index != video_idx) {
+			// 音频：按起止时间直接复制
+			int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+			int64_t a_start = av_rescale_q(start_ts, in_video->time_base, in_stream->time_base);
+			bool before = ts != AV_NOPTS_VALUE && ts < a_start;
+			bool after = end_ts != AV_NOPTS_VALUE && ts != AV_NOPTS_VALUE &&
+				av_rescale_q(ts, in_stream->time_base, in_video->time_base) >= end_ts;
+			if (before || after) {
+				pkt.unref();
+				if (after && video_done) break;
+				continue;
+			}
+			AVStream* out_stream = out_fmt_ctx->streams[out_idx];
+			av_packet_rescale_ts(pkt.get(), in_stream->time_base, out_stream->time_base);
+			int64_t shift = av_rescale_q(start_ts, in_video->time_base, out_stream->time_base);
+			if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= shift;
+			if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= shift;
+			pkt->stream_index = out_idx;
+			pkt->pos = -1;
+			if (av_interleaved_write_frame(out_fmt_ctx, pkt.get()) < 0) {
+				write_error = true;
+			}
+			pkt.unref();
+			continue;
 		}
 
-		// 加上第一个视频的结束偏移（核心修复：按输出流独立偏移）
-		int64_t offset = out_stream_end_ts[out_index];
-		if (new_pts != AV_NOPTS_VALUE) new_pts += offset;
-		if (new_dts != AV_NOPTS_VALUE) new_dts += offset;
-
-		// 强制修正时间戳单调性（解决核心错误）
-		fix_timestamp_monotonic(out_index, new_pts, new_dts);
+		if (video_done) {
+			pkt.unref();
+			continue;
+		}
 
-		// 赋值给packet
-		pkt.stream_index = out_index;
-		pkt.pts = new_pts;
-		pkt.dts = new_dts;
-		pkt.duration = new_duration;
-		pkt.pos = -1;
+		bool key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+		int64_t pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
 
-		// 写入帧（忽略单帧错误，继续处理）
-		ret = av_interleaved_write_frame(out_fmt_ctx, &pkt);
-		if (ret < 0) {
-			char err_buf[1024] = { 0 };
-			av_strerror(ret, err_buf, sizeof(err_buf));
-			std::cerr << "[warning] write second frame failed (ignored), in_stream: " << in_index
-				<< " -> out_stream: " << out_index << " - " << err_buf << std::endl;
-			av_packet_unref(&pkt);
-			pkt = {};
+		if (end_ts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts >= end_ts && phase != 1) {
+			video_done = true;
+			pkt.unref();
 			continue;
 		}
 
-		second_video_frame_count++;
+		if (phase == 0) {
+			if (!key) {
+				pkt.unref();
+				continue; // 回退未落在关键帧上，跳过
+			}
+			// 起点正好是关键帧或无法重编码时直接复制
+			phase = ((pts >= start_ts && !full_reencode) || !can_reencode) ? 2 : 1;
+			if (phase == 2 && pts < start_ts) {
+				start_ts = pts; // 纯复制模式从该关键帧起算
+			}
+			if (phase == 1 && !full_reencode && pkt->dts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts > pkt->dts) {
+				head_dts_shift = pts - pkt->dts;
+			}
+		}
+		else if (phase == 1 && key && pts >= start_ts && !full_reencode) {
+			// 到达下一个关键帧：结束重编码，补上原始参数集后转入复制
+			finish_reencode();
+			phase = 2;
+			std::vector<uint8_t> with_ps(param_sets);
+			with_ps.insert(with_ps.end(), pkt->data, pkt->data + pkt->size);
+			PacketRef ps_pkt;
+			if (av_new_packet(ps_pkt.get(), static_cast<int>(with_ps.size())) == 0) {
+				memcpy(ps_pkt->data, with_ps.data(), with_ps.size());
+				av_packet_copy_props(ps_pkt.get(), pkt.get());
+				if (end_ts == AV_NOPTS_VALUE || pts < end_ts) {
+					write_video(ps_pkt.get(), in_stream->time_base, true);
+					copied_packets++;
+				}
+				else {
+					video_done = true;
+				}
+				ps_pkt.unref();
+			}
+			pkt.unref();
+			continue;
+		}
 
-		// 更新结束时间戳
-		int64_t ts_for_end = (pkt.dts != AV_NOPTS_VALUE) ? pkt.dts : pkt.pts;
-		if (ts_for_end != AV_NOPTS_VALUE) {
-			int64_t end_ts = ts_for_end + ((pkt.duration > 0) ? pkt.duration : 1);
-			if (end_ts > out_stream_end_ts[out_index]) {
-				out_stream_end_ts[out_index] = end_ts;
+		if (phase == 1) {
+			decode_and_encode(pkt.get());
+			if (end_ts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE && pts >= end_ts) {
+				// 终点落在首个GOP内，整段都是重编码
+				finish_reencode();
+				phase = 2;
+				video_done = true;
 			}
 		}
+		else {
+			write_video(pkt.get(), in_stream->time_base, true);
+			copied_packets++;
+		}
+		pkt.unref();
+	}
 
-		av_packet_unref(&pkt);
-		pkt = {};
+	if (phase == 1 && !write_error) {
+		finish_reencode();
 	}
 
-	std::cout << "[info] Second video frame count: " << second_video_frame_count << std::endl;
+	av_write_trailer(out_fmt_ctx);
 
-	// 刷新缓冲区
-	if (out_fmt_ctx && out_fmt_ctx->pb) {
-		avio_flush(out_fmt_ctx->pb);
-	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	std::cout << "split_video_smart | " << (full_reencode ? "full reencode" : "head reencode")
+		<< " | reencoded frames:" << reencoded_frames
+		<< " | copied packets:" << copied_packets
+		<< " | seconds:" << seconds << std::endl;
 
-	// 写入文件尾
-	ret = av_write_trailer(out_fmt_ctx);
-	if (ret < 0) {
-		char err_buf[1024] = { 0 };
-		av_strerror(ret, err_buf, sizeof(err_buf));
-		std::cerr << "[错误] 写入文件尾失败: " << output_url << " - " << err_buf << std::endl;
+	cleanup();
+	return write_error ? -1 : 0;
+}
+// ---------------- 单次读取多段分割 ----------------
+
+// 一个分段的输出状态
+struct SplitOutput {
+	std::string path;
+	int64_t start_ts = 0;              // 视频时间基
+	int64_t end_ts = AV_NOPTS_VALUE;   // 视频时间基
+	int64_t base_ts = 0;               // 实际起点（起点前的关键帧）
+	AVFormatContext* fmt_ctx = nullptr;
+	std::vector<int> stream_map;
+	int state = 0;                     // 0未开始 1写入中 2已结束 -1失败
+};
+
+// 为分段创建只含视频/音频的复制输出
+static bool open_copy_output(AVFormatContext* in_fmt_ctx, int video_idx, SplitOutput& out)
+{
+	if (avformat_alloc_output_context2(&out.fmt_ctx, nullptr, nullptr, out.path.c_str()) < 0) {
+		return false;
 	}
-	else {
-		std::cout << "[成功] 视频拼接完成，输出文件: " << output_url << std::endl;
-		is_success = true;
+	out.stream_map.assign(in_fmt_ctx->nb_streams, -1);
+	for (unsigned int i = 0; i < in_fmt_ctx->nb_streams; i++) {
+		AVMediaType type = in_fmt_ctx->streams[i]->codecpar->codec_type;
+		if ((int)i != video_idx && type != AVMEDIA_TYPE_AUDIO) {
+			continue;
+		}
+		AVStream* out_stream = avformat_new_stream(out.fmt_ctx, nullptr);
+		if (!out_stream || avcodec_parameters_copy(out_stream->codecpar, in_fmt_ctx->streams[i]->codecpar) < 0) {
+			return false;
+		}
+		out_stream->codecpar->codec_tag = 0;
+		out_stream->time_base = in_fmt_ctx->streams[i]->time_base;
+		out.stream_map[i] = out_stream->index;
+	}
+	if (!(out.fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		if (avio_open(&out.fmt_ctx->pb, out.path.c_str(), AVIO_FLAG_WRITE) < 0) {
+			return false;
+		}
 	}
+	return avformat_write_header(out.fmt_ctx, nullptr) >= 0;
+}
 
-	// 释放资源
-	if (fmt_ctx1) avformat_close_input(&fmt_ctx1);
-	if (fmt_ctx2) avformat_close_input(&fmt_ctx2);
+static void close_copy_output(SplitOutput& out, bool write_trailer)
+{
+	if (!out.fmt_ctx) {
+		return;
+	}
+	if (write_trailer) {
+		av_write_trailer(out.fmt_ctx);
+	}
+	if (!(out.fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		avio_closep(&out.fmt_ctx->pb);
+	}
+	avformat_free_context(out.fmt_ctx);
+	out.fmt_ctx = nullptr;
+}
 
-	if (out_fmt_ctx) {
-		if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-			avio_closep(&out_fmt_ctx->pb);
-		}
-		avformat_free_context(out_fmt_ctx);
+// 把输入包写入一个分段，时间戳平移到该段起点；pkt为复用的临时包。返回false表示写入失败
+static bool write_to_output(AVFormatContext* in_fmt_ctx, int video_idx, SplitOutput& out, const AVPacket* src, AVPacket* pkt)
+{
+	int out_idx = out.stream_map[src->stream_index];
+	if (out_idx < 0) {
+		return true;
 	}
+	AVStream* in_stream = in_fmt_ctx->streams[src->stream_index];
+	AVStream* out_stream = out.fmt_ctx->streams[out_idx];
+	int64_t shift = av_rescale_q(out.base_ts, in_fmt_ctx->streams[video_idx]->time_base, in_stream->time_base);
 
-	avformat_network_deinit();
+	// 起点之前的音频不写
+	int64_t ts = src->pts != AV_NOPTS_VALUE ? src->pts : src->dts;
+	if (src->stream_index != video_idx && ts != AV_NOPTS_VALUE && ts < shift) {
+		return true;
+	}
 
-	return is_success;
+	if (av_packet_ref(pkt, src) < 0) {
+		return false;
+	}
+	if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= shift;
+	if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= shift;
+	av_packet_rescale_ts(pkt, in_stream->time_base, out_stream->time_base);
+	pkt->stream_index = out_idx;
+	pkt->pos = -1;
+	int ret = av_interleaved_write_frame(out.fmt_ctx, pkt);
+	av_packet_unref(pkt);
+	return ret >= 0;
 }
 
 /**
- * @brief FFmpeg视频分割（避免空指针访问）
- * @param input_path 输入视频路径（必须是本地可访问的MP4文件）
- * @param output_path 输出视频路径
- * @param start_seconds 起始时间（秒，>=0）
- * @param duration_seconds 持续时长（秒，0表示到结尾）
- * @return 0成功，-1失败
+ * @brief 一次读取输入，按时间段同时写出多个分段（直接复制，起点对齐到之前的关键帧）.
+ *
+ * 缓存当前GOP的数据包；读到下一个关键帧时，起点落在该GOP内的分段以缓存内容开头
+ * @return 成功写出的分段数，打开输入失败返回-1
  */
-int AvWorker::split_video(const std::string& input_path,
-	const std::string& output_path,
-	double start_seconds,
-	double duration_seconds) {
-	// 1. 参数合法性校验
-	if (input_path.empty() || output_path.empty()) {
-		std::cerr << "错误：输入或输出路径为空" << std::endl;
+int AvWorker::split_video_multi(const std::string& input_path, const AvSplitSegment* segments, int count)
+{
+	if (input_path.empty() || !segments || count <= 0) {
+		std::cerr << "split_video_multi: invalid args" << std::endl;
 		return -1;
 	}
-	if (start_seconds < 0) {
-		std::cerr << "错误：起始时间不能为负数" << std::endl;
+
+	auto begin_time = std::chrono::steady_clock::now();
+	int64_t begin_allocs = media_buffer_alloc_count();
+	AVFormatContext* in_fmt_ctx = nullptr;
+	if (avformat_open_input(&in_fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0 ||
+		avformat_find_stream_info(in_fmt_ctx, nullptr) < 0) {
+		std::cerr << "split_video_multi open input fair " << input_path << std::endl;
+		if (in_fmt_ctx) avformat_close_input(&in_fmt_ctx);
 		return -1;
 	}
-	if (duration_seconds < 0) {
-		std::cerr << "错误：持续时长不能为负数" << std::endl;
+
+	int video_idx = av_find_best_stream(in_fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_idx < 0) {
+		std::cerr << "错误：输入文件中未找到视频流" << std::endl;
+		avformat_close_input(&in_fmt_ctx);
 		return -1;
 	}
+	AVRational video_tb = in_fmt_ctx->streams[video_idx]->time_base;
+	// 分段时间相对视频起点，加上start_time后才能与包时间戳比较（TS等格式不从0开始）
+	int64_t video_start = in_fmt_ctx->streams[video_idx]->start_time != AV_NOPTS_VALUE ?
+		in_fmt_ctx->streams[video_idx]->start_time : 0;
+
+	std::vector<SplitOutput> outputs(count);
+	int64_t min_start = INT64_MAX;
+	for (int i = 0; i < count; ++i) {
+		const AvSplitSegment& seg = segments[i];
+		SplitOutput& out = outputs[i];
+		if (!seg.output_url || !*seg.output_url || seg.start_seconds < 0 || seg.duration_seconds < 0) {
+			out.state = -1;
+			continue;
+		}
+		out.path = seg.output_url;
+		out.start_ts = video_start +
+			av_rescale_q(static_cast<int64_t>(seg.start_seconds * AV_TIME_BASE), { 1, AV_TIME_BASE }, video_tb);
+		if (seg.duration_seconds > 0) {
+			out.end_ts = video_start +
+				av_rescale_q(static_cast<int64_t>((seg.start_seconds + seg.duration_seconds) * AV_TIME_BASE), { 1, AV_TIME_BASE }, video_tb);
+		}
+		min_start = std::min(min_start, out.start_ts);
+	}
+
+	// 只定位一次：最早分段起点之前的关键帧
+	if (min_start != INT64_MAX && min_start > video_start) {
+		if (av_seek_frame(in_fmt_ctx, video_idx, min_start, AVSEEK_FLAG_BACKWARD) < 0) {
+			std::cerr << "av_seek_frame fair ,read from beginning" << std::endl;
+		}
+	}
+
+	// 当前GOP的数据包（含音频），包结构体在池里循环使用
+	PacketPool gop_pool;
+	PacketRef scratch;
+	std::vector<AVPacket*> gop;
+	int64_t gop_key_ts = AV_NOPTS_VALUE;
+	int64_t last_video_ts = AV_NOPTS_VALUE; // 读到的最大视频时间戳，文件结束时判断起点是否越界
+	auto clear_gop = [&]() {
+		for (AVPacket* p : gop) {
+			gop_pool.recycle(p);
+		}
+		gop.clear();
+	};
+
+	// 起点落在当前GOP内的分段：打开输出并写入缓存的GOP
+	auto start_pending = [&](int64_t next_key_ts) {
+		if (gop_key_ts == AV_NOPTS_VALUE) {
+			return;
+		}
+		for (SplitOutput& out : outputs) {
+			if (out.state != 0) continue;
+			bool in_gop = next_key_ts == AV_NOPTS_VALUE || out.start_ts < next_key_ts;
+			if (!in_gop) continue;
+			if (next_key_ts == AV_NOPTS_VALUE && (last_video_ts == AV_NOPTS_VALUE || out.start_ts > last_video_ts)) {
+				// 起点在输入结尾之后，不输出只含音频或空的文件
+				std::cerr << "split_video_multi start beyond end of input " << out.path << std::endl;
+				out.state = -1;
+				continue;
+			}
+			if (out.end_ts != AV_NOPTS_VALUE && out.end_ts <= gop_key_ts) {
+				out.state = -1; // 整段落在读取范围之前
+				continue;
+			}
+			out.base_ts = std::min(gop_key_ts, out.start_ts);
+			if (!open_copy_output(in_fmt_ctx, video_idx, out)) {
+				std::cerr << "split_video_multi open output fair " << out.path << std::endl;
+				close_copy_output(out, false);
+				out.state = -1;
+				continue;
+			}
+			out.state = 1;
+			for (AVPacket* p : gop) {
+				if (!write_to_output(in_fmt_ctx, video_idx, out, p, scratch.get())) {
+					out.state = -1;
+					close_copy_output(out, false);
+					break;
+				}
+			}
+		}
+	};
+
+	auto pending_or_active = [&]() {
+		for (const SplitOutput& out : outputs) {
+			if (out.state == 0 || out.state == 1) return true;
+		}
+		return false;
+	};
+
+	PacketRef pkt;
+	while (pending_or_active() && av_read_frame(in_fmt_ctx, pkt.get()) >= 0) {
+		bool is_video = pkt->stream_index == video_idx;
+		int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+		int64_t ts_video = ts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE :
+			av_rescale_q(ts, in_fmt_ctx->streams[pkt->stream_index]->time_base, video_tb);
+
+		if (is_video && ts != AV_NOPTS_VALUE) {
+			last_video_ts = last_video_ts == AV_NOPTS_VALUE ? ts : std::max(last_video_ts, ts);
+		}
+		if (is_video && (pkt->flags & AV_PKT_FLAG_KEY) && ts != AV_NOPTS_VALUE) {
+			start_pending(ts);
+			clear_gop();
+			gop_key_ts = ts;
+		}
+
+		// 还有未开始的分段时才需要缓存
+		bool has_pending = false;
+		for (const SplitOutput& out : outputs) {
+			if (out.state == 0) { has_pending = true; break; }
+		}
+		if (has_pending && gop_key_ts != AV_NOPTS_VALUE) {
+			AVPacket* cached = gop_pool.clone(pkt.get());
+			if (cached) gop.push_back(cached);
+		}
+
+		for (SplitOutput& out : outputs) {
+			if (out.state != 1) continue;
+			if (out.end_ts != AV_NOPTS_VALUE && ts_video != AV_NOPTS_VALUE && ts_video >= out.end_ts) {
+				if (is_video) {
+					// 视频到达终点，该分段结束
+					close_copy_output(out, true);
+					out.state = 2;
+				}
+				continue;
+			}
+			if (!write_to_output(in_fmt_ctx, video_idx, out, pkt.get(), scratch.get())) {
+				std::cerr << "split_video_multi write fair " << out.path << std::endl;
+				close_copy_output(out, false);
+				out.state = -1;
+			}
+		}
+		pkt.unref();
+	}
+
+	// 文件结束：起点落在最后一个GOP内的分段
+	start_pending(AV_NOPTS_VALUE);
+	clear_gop();
+
+	int written = 0;
+	for (SplitOutput& out : outputs) {
+		if (out.state == 1) {
+			close_copy_output(out, true);
+			out.state = 2;
+		}
+		if (out.state == 2) {
+			written++;
+		}
+		else {
+			close_copy_output(out, false);
+			std::cerr << "split_video_multi segment fair " << out.path << std::endl;
+		}
+	}
+	avformat_close_input(&in_fmt_ctx);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	std::cout << "split_video_multi | segments:" << written << "/" << count
+		<< " | seconds:" << seconds
+		<< " | buffer allocs:" << (media_buffer_alloc_count() - begin_allocs) << std::endl;
+	return written;
+}
+
+// ---------------- N路拼接 ----------------
+
+static bool same_extradata(const AVCodecParameters* a, const AVCodecParameters* b)
+{
+	if (a->extradata_size != b->extradata_size) return false;
+	return a->extradata_size == 0 || memcmp(a->extradata, b->extradata, a->extradata_size) == 0;
+}
+
+// 能否与参考视频流直接拼接复制
+static bool splice_video_compatible(const AVCodecParameters* ref, const AVCodecParameters* par)
+{
+	return ref->codec_id == par->codec_id && ref->width == par->width && ref->height == par->height &&
+		ref->format == par->format && same_extradata(ref, par);
+}
+
+static bool splice_audio_compatible(const AVCodecParameters* ref, const AVCodecParameters* par)
+{
+	return ref->codec_id == par->codec_id && ref->sample_rate == par->sample_rate &&
+		ref->channels == par->channels && ref->format == par->format && same_extradata(ref, par);
+}
+
+// 重编码器生成的全局头能否直接用参考流的extradata解码（输出头里只有参考流的那一份）
+static bool splice_header_compatible(const AVCodecContext* enc, const AVCodecParameters* ref)
+{
+	if (!(enc->flags & AV_CODEC_FLAG_GLOBAL_HEADER)) {
+		return true; // 参数集在码流内
+	}
+	return enc->extradata_size == ref->extradata_size &&
+		(ref->extradata_size == 0 || memcmp(enc->extradata, ref->extradata, ref->extradata_size) == 0);
+}
 
-	// 初始化FFmpeg相关变量，全部初始化为nullptr避免空指针
-	AVFormatContext *input_fmt_ctx = nullptr;
-	AVFormatContext *output_fmt_ctx = nullptr;
-	int ret = -1;
+// 把不兼容输入的视频重编码为参考流的编码/尺寸/像素格式
+struct SpliceVideoTranscoder {
+	AVCodecContext* dec = nullptr;
+	AVCodecContext* enc = nullptr;
+	SwsContext* sws = nullptr;
+	FrameRef frame;
+	FramePool scaled_pool; // 编码器可能还持有上一帧，每帧从池里取新的目标帧
+	PacketRef out;
+	PacketRef conv;
+	bool to_avcc = false; // 编码输出为Annex B，需转成长度前缀
+	int nal_size = 4;
+
+	~SpliceVideoTranscoder()
+	{
+		if (sws) sws_freeContext(sws);
+		if (dec) avcodec_free_context(&dec);
+		if (enc) avcodec_free_context(&enc);
+	}
+
+	bool open(AVFormatContext* fmt, AVStream* in, const AVCodecParameters* ref, bool global_header)
+	{
+		AVCodec* decoder = avcodec_find_decoder(in->codecpar->codec_id);
+		AVCodec* encoder = avcodec_find_encoder(ref->codec_id);
+		if (!decoder || !encoder) return false;
+
+		// 解码和编码同时运行，分摊作业的线程
+		const std::vector<int> stage_threads = avjob_split_threads({ 1, 3 });
+		dec = avcodec_alloc_context3(decoder);
+		if (!dec || avcodec_parameters_to_context(dec, in->codecpar) < 0) return false;
+		dec->thread_count = stage_threads[0];
+		if (avcodec_open2(dec, decoder, nullptr) < 0) return false;
+
+		enc = avcodec_alloc_context3(encoder);
+		if (!enc) return false;
+		enc->width = ref->width;
+		enc->height = ref->height;
+		enc->pix_fmt = static_cast<AVPixelFormat>(ref->format);
+		enc->sample_aspect_ratio = ref->sample_aspect_ratio;
+		enc->time_base = in->time_base;
+		enc->framerate = av_guess_frame_rate(fmt, in, nullptr);
+		enc->max_b_frames = 0;
+		enc->thread_count = stage_threads[1];
+		if (ref->bit_rate > 0) enc->bit_rate = ref->bit_rate;
+
+		std::vector<uint8_t> unused;
+		to_avcc = ref->codec_id == AV_CODEC_ID_H264 && avcc_parameter_sets(ref, unused, nal_size);
+		if (ref->codec_id == AV_CODEC_ID_H264) {
+			av_opt_set(enc->priv_data, "preset", "veryfast", 0);
+			av_opt_set(enc->priv_data, "crf", "18", 0);
+		}
+		// H.264参数集放在码流内，避免与参考流的extradata冲突
+		if (global_header && !to_avcc) {
+			enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+		}
+		if (avcodec_open2(enc, encoder, nullptr) < 0) return false;
 
-	// 打开输入文件
-	if (avformat_open_input(&input_fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0) {
-		std::cerr << "错误：无法打开输入文件 " << input_path << std::endl;
+		return frame.get() && out.get() && conv.get();
+	}
 
-		if (output_fmt_ctx) {
-			if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-				avio_closep(&output_fmt_ctx->pb);
+	// 送入一个包（nullptr为冲刷），产生的编码包交给sink
+	template <typename Sink>
+	void feed(AVPacket* pkt, Sink sink)
+	{
+		if (avcodec_send_packet(dec, pkt) < 0 && pkt) return;
+		while (avcodec_receive_frame(dec, frame.get()) >= 0) {
+			if (!sws) {
+				sws = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+					enc->width, enc->height, enc->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
 			}
-			avformat_free_context(output_fmt_ctx);
+			AVFrame* scaled = sws ? scaled_pool.video(enc->width, enc->height, enc->pix_fmt) : nullptr;
+			if (scaled) {
+				sws_scale(sws, frame->data, frame->linesize, 0, frame->height, scaled->data, scaled->linesize);
+				scaled->pts = frame->best_effort_timestamp;
+				avcodec_send_frame(enc, scaled);
+				scaled_pool.recycle(scaled);
+				drain(sink);
+			}
+			frame.unref();
 		}
-		if (input_fmt_ctx) {
-			avformat_close_input(&input_fmt_ctx);
+		if (!pkt) {
+			avcodec_send_frame(enc, nullptr);
+			drain(sink);
 		}
-		return -1;
 	}
 
-	// 获取输入文件流信息
-	if (avformat_find_stream_info(input_fmt_ctx, nullptr) < 0) {
-		std::cerr << "错误：无法获取流信息" << std::endl;
-		avformat_close_input(&input_fmt_ctx);
-		return -1;
+	template <typename Sink>
+	void drain(Sink sink)
+	{
+		while (avcodec_receive_packet(enc, out.get()) >= 0) {
+			if (to_avcc) {
+				std::vector<uint8_t> converted;
+				annexb_to_length_prefixed(out->data, out->size, nal_size, converted);
+				if (av_new_packet(conv.get(), static_cast<int>(converted.size())) == 0) {
+					memcpy(conv->data, converted.data(), converted.size());
+					av_packet_copy_props(conv.get(), out.get());
+					sink(conv.get(), enc->time_base);
+					conv.unref();
+				}
+			}
+			else {
+				sink(out.get(), enc->time_base);
+			}
+			out.unref();
+		}
 	}
+};
 
-	// 创建输出格式上下文
-	if (avformat_alloc_output_context2(&output_fmt_ctx, nullptr, nullptr, output_path.c_str()) < 0) {
-		std::cerr << "错误：无法创建输出格式上下文" << std::endl;
-		avformat_close_input(&input_fmt_ctx);
-		return -1;
+/**
+ * @brief N路拼接.
+ *
+ * 以第一个输入的首个视频流/音频流为参考，先检查各输入能否直接复制；
+ * 兼容的输入直接复制数据包，不兼容的输入单独重编码为参考流参数。
+ * 每个输入的时间戳整体加一个常量偏移（前面各输入的结束时间），同concat demuxer，不改写单个包。
+ * 每个输入只取第一个视频流和第一个音频流，其余流（字幕、多音轨等）丢弃并打印提示。
+ * 输出封装需要全局头、且重编码器生成的extradata与参考流不同时（H.264以外的编码）无法混合复制/重编码，直接失败
+ */
+bool AvWorker::SpliceAVMulti(const std::vector<std::string>& input_urls, const std::string& output_url, bool is_rtsp)
+{
+	if (input_urls.size() < 2 || output_url.empty()) {
+		std::cerr << "[error] SpliceAVMulti need at least 2 inputs" << std::endl;
+		return false;
 	}
 
-	// 5. 遍历输入流，创建对应的输出流
-	int video_stream_index = -1;
-	int audio_stream_index = -1;
-	for (unsigned int i = 0; i < input_fmt_ctx->nb_streams; i++) {
-		AVStream *in_stream = input_fmt_ctx->streams[i];
-		AVStream *out_stream = avformat_new_stream(output_fmt_ctx, nullptr);
-		if (!out_stream) {
-			std::cerr << "错误：无法创建输出流" << std::endl;
-			avformat_free_context(output_fmt_ctx);
-			avformat_close_input(&input_fmt_ctx);
-			return -1;
-		}
+	avformat_network_init();
+	auto begin_time = std::chrono::steady_clock::now();
+	int64_t begin_allocs = media_buffer_alloc_count();
+
+	struct SpliceInput {
+		AVFormatContext* fmt = nullptr;
+		int video = -1;
+		int audio = -1;
+		bool copy_video = true;
+		bool copy_audio = true;
+	};
+	std::vector<SpliceInput> inputs(input_urls.size());
+	AVFormatContext* out_fmt_ctx = nullptr;
 
-		// 复制流参数
-		if (avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
-			std::cerr << "错误：无法复制流参数" << std::endl;
-			avformat_free_context(output_fmt_ctx);
-			avformat_close_input(&input_fmt_ctx);
-			return -1;
+	auto cleanup = [&]() {
+		for (SpliceInput& in : inputs) {
+			if (in.fmt) avformat_close_input(&in.fmt);
 		}
-		out_stream->codecpar->codec_tag = 0;
+		if (out_fmt_ctx) {
+			if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE))
+				avio_closep(&out_fmt_ctx->pb);
+			avformat_free_context(out_fmt_ctx);
+			out_fmt_ctx = nullptr;
+		}
+		avformat_network_deinit();
+	};
 
-		// 记录视频/音频流索引
-		if (in_stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && video_stream_index == -1) {
-			video_stream_index = i;
+	// 1. 先探测全部输入，提前发现打不开的文件
+	for (size_t i = 0; i < input_urls.size(); ++i) {
+		AVDictionary* options = nullptr;
+		if (is_rtsp) {
+			av_dict_set(&options, "rtsp_transport", "tcp", 0);
+			av_dict_set(&options, "stimeout", "5000000", 0);
 		}
-		else if (in_stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && audio_stream_index == -1) {
-			audio_stream_index = i;
+		int ret = avformat_open_input(&inputs[i].fmt, input_urls[i].c_str(), nullptr, &options);
+		av_dict_free(&options);
+		if (ret < 0 || avformat_find_stream_info(inputs[i].fmt, nullptr) < 0) {
+			std::cerr << "[error] open_input fair index:" << i << " " << input_urls[i] << std::endl;
+			cleanup();
+			return false;
 		}
+		inputs[i].video = av_find_best_stream(inputs[i].fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+		inputs[i].audio = av_find_best_stream(inputs[i].fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
 	}
 
-	// 检查是否找到视频流
-	if (video_stream_index == -1) {
-		std::cerr << "错误：输入文件中未找到视频流" << std::endl;
-		avformat_free_context(output_fmt_ctx);
-		avformat_close_input(&input_fmt_ctx);
-		return -1;
+	int64_t total_ms = 0;
+	for (const SpliceInput& in : inputs) {
+		if (in.fmt->duration != AV_NOPTS_VALUE) total_ms += in.fmt->duration / 1000;
 	}
+	avjob_set_duration(total_ms);
 
-	// 6. 打开输出文件
-	if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-		if (avio_open(&output_fmt_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE) < 0) {
-			std::cerr << "错误：无法打开输出文件 " << output_path << std::endl;
-			avformat_free_context(output_fmt_ctx);
-			avformat_close_input(&input_fmt_ctx);
-			return -1;
+	const SpliceInput& ref = inputs[0];
+	if (ref.video < 0 && ref.audio < 0) {
+		std::cerr << "[error] first input has no audio/video" << std::endl;
+		cleanup();
+		return false;
+	}
+	const AVCodecParameters* ref_v = ref.video >= 0 ? ref.fmt->streams[ref.video]->codecpar : nullptr;
+	const AVCodecParameters* ref_a = ref.audio >= 0 ? ref.fmt->streams[ref.audio]->codecpar : nullptr;
+
+	// 2. 兼容性检查
+	for (size_t i = 1; i < inputs.size(); ++i) {
+		SpliceInput& in = inputs[i];
+		if (ref_v && in.video >= 0) {
+			in.copy_video = splice_video_compatible(ref_v, in.fmt->streams[in.video]->codecpar);
+		}
+		if (ref_a && in.audio >= 0) {
+			in.copy_audio = splice_audio_compatible(ref_a, in.fmt->streams[in.audio]->codecpar);
+		}
+		std::cout << "[info] input " << i << " video:" << (in.copy_video ? "copy" : "reencode")
+			<< " audio:" << (in.copy_audio ? "copy" : "reencode") << std::endl;
+	}
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		int kept = (inputs[i].video >= 0 ? 1 : 0) + (inputs[i].audio >= 0 ? 1 : 0);
+		int dropped = static_cast<int>(inputs[i].fmt->nb_streams) - kept;
+		if (dropped > 0) {
+			std::cout << "[warn] input " << i << " only first video/audio stream kept, dropped "
+				<< dropped << " stream(s)" << std::endl;
 		}
 	}
 
-	// 写入文件头
-	if (avformat_write_header(output_fmt_ctx, nullptr) < 0) {
-		std::cerr << "错误：无法写入文件头" << std::endl;
-		if (!(output_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-			avio_closep(&output_fmt_ctx->pb);
+	// 3. 输出流取参考流参数
+	if (avformat_alloc_output_context2(&out_fmt_ctx, nullptr, nullptr, output_url.c_str()) < 0) {
+		std::cerr << "[error]craete output stream fair index:" << output_url << std::endl;
+		cleanup();
+		return false;
+	}
+	int out_video = -1, out_audio = -1;
+	for (int k = 0; k < 2; ++k) {
+		int idx = k == 0 ? ref.video : ref.audio;
+		if (idx < 0) continue;
+		AVStream* in_stream = ref.fmt->streams[idx];
+		AVStream* out_stream = avformat_new_stream(out_fmt_ctx, nullptr);
+		if (!out_stream || avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
+			std::cerr << "[error]create output stream fair" << std::endl;
+			cleanup();
+			return false;
 		}
-		avformat_free_context(output_fmt_ctx);
-		avformat_close_input(&input_fmt_ctx);
-		return -1;
+		out_stream->codecpar->codec_tag = 0;
+		out_stream->time_base = in_stream->time_base;
+		out_stream->avg_frame_rate = in_stream->avg_frame_rate;
+		out_stream->r_frame_rate = in_stream->r_frame_rate;
+		out_stream->sample_aspect_ratio = in_stream->sample_aspect_ratio;
+		(k == 0 ? out_video : out_audio) = out_stream->index;
 	}
 
-	// 计算时间戳
-	AVRational ration = { 1,AV_TIME_BASE };
-	int64_t start_ts = av_rescale_q(static_cast<int64_t>(start_seconds * AV_TIME_BASE),
-		ration,
-		input_fmt_ctx->streams[video_stream_index]->time_base);
-	int64_t end_ts = AV_NOPTS_VALUE;
-	if (duration_seconds > 0) {
-		end_ts = av_rescale_q(static_cast<int64_t>((start_seconds + duration_seconds) * AV_TIME_BASE),
-			ration,
-			input_fmt_ctx->streams[video_stream_index]->time_base);
+	const bool global_header = (out_fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+	// 需要重编码的输入先试开一次编码器：生成的全局头与参考流不同时，重编码部分用输出头无法解码
+	for (size_t i = 1; i < inputs.size() && global_header; ++i) {
+		SpliceInput& in = inputs[i];
+		bool header_ok = true;
+		if (in.video >= 0 && ref_v && !in.copy_video) {
+			SpliceVideoTranscoder probe;
+			header_ok = probe.open(in.fmt, in.fmt->streams[in.video], ref_v, true) &&
+				splice_header_compatible(probe.enc, ref_v);
+		}
+		if (header_ok && in.audio >= 0 && ref_a && !in.copy_audio) {
+			AudioTranscoder probe;
+			header_ok = probe.open(in.fmt->streams[in.audio], ref_a, true) &&
+				splice_header_compatible(probe.enc, ref_a);
+		}
+		if (!header_ok) {
+			std::cerr << "[error] input " << i << " needs reencode but encoder header differs from first input, "
+				"mixed copy/reencode not supported for this codec" << std::endl;
+			cleanup();
+			return false;
+		}
 	}
 
-	// 定位到起始时间位置
-	if (av_seek_frame(input_fmt_ctx, video_stream_index, start_ts, AVSEEK_FLAG_ANY) < 0) {
-		std::cerr << "av_seek_frame fair ,begin closest frame" << std::endl;
+	if (!(out_fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		if (avio_open(&out_fmt_ctx->pb, output_url.c_str(), AVIO_FLAG_WRITE) < 0) {
+			std::cerr << "[error]open  output fair url:" << output_url << std::endl;
+			cleanup();
+			return false;
+		}
+	}
+	if (avformat_write_header(out_fmt_ctx, nullptr) < 0) {
+		std::cerr << "[error]write header fair" << output_url << std::endl;
+		cleanup();
+		return false;
 	}
 
-	// 读取并写入帧
-	AVPacket pkt = { 0 };
-	pkt.data = nullptr;
-	pkt.size = 0;
+	// 参考流为avcC时，重编码片段之后的第一个复制包前补上参考参数集
+	std::vector<uint8_t> ref_param_sets;
+	int ref_nal_size = 4;
+	if (ref_v && ref_v->codec_id == AV_CODEC_ID_H264) {
+		avcc_parameter_sets(ref_v, ref_param_sets, ref_nal_size);
+	}
+
+	const AVRational us = { 1, AV_TIME_BASE };
+	int64_t last_video_dts = AV_NOPTS_VALUE; // 已写出的最后一个视频dts，AV_TIME_BASE
+	int64_t offset = 0;       // 当前输入在输出中的起点，AV_TIME_BASE
+	int64_t segment_end = 0;  // 当前输入写出的最大结束时间，AV_TIME_BASE
+	int64_t input_start = 0;  // 当前输入自身的起始时间，AV_TIME_BASE
+	bool write_ok = true;
+	int packets = 0;
+
+	// 整个输入的时间戳加同一个常量偏移后写入，B帧的pts/dts关系保持不变
+	auto write_packet = [&](AVPacket* pkt, AVRational src_tb, int out_idx) {
+		AVStream* out_stream = out_fmt_ctx->streams[out_idx];
+		int64_t shift = av_rescale_q(offset - input_start, us, src_tb);
+		if (pkt->pts != AV_NOPTS_VALUE) pkt->pts += shift;
+		if (pkt->dts != AV_NOPTS_VALUE) pkt->dts += shift;
+		av_packet_rescale_ts(pkt, src_tb, out_stream->time_base);
+		if (out_idx == out_video && pkt->dts != AV_NOPTS_VALUE) {
+			last_video_dts = av_rescale_q(pkt->dts, out_stream->time_base, us);
+		}
 
-	while (av_read_frame(input_fmt_ctx, &pkt) >= 0) {
-		AVStream *in_stream = input_fmt_ctx->streams[pkt.stream_index];
-		AVStream *out_stream = output_fmt_ctx->streams[pkt.stream_index];
+		int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+		if (ts != AV_NOPTS_VALUE) {
+			int64_t end = av_rescale_q(ts + (pkt->duration > 0 ? pkt->duration : 1), out_stream->time_base, us);
+			segment_end = std::max(segment_end, end);
+		}
 
-		// 检查是否超出结束时间
-		if (end_ts != AV_NOPTS_VALUE && pkt.pts != AV_NOPTS_VALUE) {
-			int64_t pkt_ts = av_rescale_q(pkt.pts, in_stream->time_base, input_fmt_ctx->streams[video_stream_index]->time_base);
-			if (pkt_ts > end_ts) {
-				av_packet_unref(&pkt);
+		pkt->stream_index = out_idx;
+		pkt->pos = -1;
+		if (av_interleaved_write_frame(out_fmt_ctx, pkt) < 0) {
+			std::cerr << "[error] write frame failed, stream: " << out_idx << std::endl;
+			write_ok = false;
+		}
+		packets++;
+	};
+
+	bool prev_video_reencoded = false;
+	for (size_t i = 0; i < inputs.size() && write_ok && !avjob_cancelled(); ++i) {
+		SpliceInput& in = inputs[i];
+		avjob_attach(in.fmt);
+		input_start = in.fmt->start_time != AV_NOPTS_VALUE ? in.fmt->start_time : 0;
+		segment_end = offset;
+
+		std::unique_ptr<SpliceVideoTranscoder> vt;
+		std::unique_ptr<AudioTranscoder> at;
+		if (in.video >= 0 && out_video >= 0 && !in.copy_video) {
+			vt.reset(new SpliceVideoTranscoder());
+			if (!vt->open(in.fmt, in.fmt->streams[in.video], ref_v, global_header)) {
+				std::cerr << "[error] video reencoder open fair index:" << i << std::endl;
+				write_ok = false;
+				break;
+			}
+		}
+		if (in.audio >= 0 && out_audio >= 0 && !in.copy_audio) {
+			at.reset(new AudioTranscoder());
+			if (!at->open(in.fmt->streams[in.audio], ref_a, global_header)) {
+				std::cerr << "[error] audio reencoder open fair index:" << i << std::endl;
+				write_ok = false;
 				break;
 			}
 		}
 
-		// 调整时间戳（相对起始时间）
-		if (pkt.pts != AV_NOPTS_VALUE) {
-			pkt.pts = av_rescale_q_rnd(pkt.pts - start_ts,
-				in_stream->time_base,
-				out_stream->time_base,
-				static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
+		auto video_sink = [&](AVPacket* p, AVRational tb) { write_packet(p, tb, out_video); };
+		auto audio_sink = [&](AVPacket* p, AVRational tb) { write_packet(p, tb, out_audio); };
+		bool need_param_sets = prev_video_reencoded && !vt && !ref_param_sets.empty();
+
+		// 偏移在第一个视频包处定下：B帧输入的首个dts早于start_time，若不晚于上一输入最后的dts则整体再后移。
+		// 在此之前读到的包先缓存，保证同一输入的所有包用同一偏移
+		std::deque<AVPacket*> held;
+		if (in.video >= 0 && out_video >= 0 && last_video_dts != AV_NOPTS_VALUE) {
+			const AVPacket* first_video = nullptr;
+			while (held.size() < 1000) {
+				AVPacket* p = av_packet_alloc();
+				if (!p || av_read_frame(in.fmt, p) < 0) {
+					av_packet_free(&p);
+					break;
+				}
+				held.push_back(p);
+				if (p->stream_index == in.video) {
+					first_video = p;
+					break;
+				}
+			}
+			if (first_video && first_video->dts != AV_NOPTS_VALUE) {
+				AVRational vtb = in.fmt->streams[in.video]->time_base;
+				int64_t first_dts = offset + av_rescale_q(first_video->dts, vtb, us) - input_start;
+				if (first_dts <= last_video_dts) {
+					int64_t bump = last_video_dts + 1 - first_dts;
+					offset += bump;
+					segment_end = offset;
+					std::cout << "[info] input " << i << " shifted by " << bump << "us to keep video dts increasing" << std::endl;
+				}
+			}
 		}
-		if (pkt.dts != AV_NOPTS_VALUE) {
-			pkt.dts = av_rescale_q_rnd(pkt.dts - start_ts,
-				in_stream->time_base,
-				out_stream->time_base,
-				static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
+		auto next_packet = [&](AVPacket* out) {
+			if (!held.empty()) {
+				AVPacket* p = held.front();
+				held.pop_front();
+				av_packet_move_ref(out, p);
+				av_packet_free(&p);
+				return true;
+			}
+			return av_read_frame(in.fmt, out) >= 0;
+		};
+
+		PacketRef pkt;
+		while (write_ok && next_packet(pkt.get())) {
+			avjob_report(packets, packet_time_ms(in.fmt, pkt.get()));
+			AVRational tb = in.fmt->streams[pkt->stream_index]->time_base;
+			if (pkt->stream_index == in.video && out_video >= 0) {
+				if (vt) {
+					vt->feed(pkt.get(), video_sink);
+				}
+				else if (need_param_sets) {
+					std::vector<uint8_t> data(ref_param_sets);
+					data.insert(data.end(), pkt->data, pkt->data + pkt->size);
+					PacketRef ps_pkt;
+					if (av_new_packet(ps_pkt.get(), static_cast<int>(data.size())) == 0) {
+						memcpy(ps_pkt->data, data.data(), data.size());
+						av_packet_copy_props(ps_pkt.get(), pkt.get());
+						write_packet(ps_pkt.get(), tb, out_video);
+						ps_pkt.unref();
+					}
+					need_param_sets = false;
+				}
+				else {
+					write_packet(pkt.get(), tb, out_video);
+				}
+			}
+			else if (pkt->stream_index == in.audio && out_audio >= 0) {
+				if (at) {
+					at->feed(pkt.get(), tb, audio_sink);
+				}
+				else {
+					write_packet(pkt.get(), tb, out_audio);
+				}
+			}
+			pkt.unref();
 		}
-		if (pkt.duration > 0) {
-			pkt.duration = av_rescale_q(pkt.duration,
-				in_stream->time_base,
-				out_stream->time_base);
+		for (AVPacket* p : held) {
+			av_packet_free(&p);
 		}
-		pkt.pos = -1;
 
-		// 写入数据包
-		if (av_interleaved_write_frame(output_fmt_ctx, &pkt) < 0) {
-			std::cerr << "错误：写入帧失败" << std::endl;
-			av_packet_unref(&pkt);
-			break;
-		}
-		av_packet_unref(&pkt);
-	}
+		if (vt) vt->feed(nullptr, video_sink);
+		if (at) at->feed(nullptr, in.fmt->streams[in.audio]->time_base, audio_sink);
+		prev_video_reencoded = vt != nullptr;
 
-	// 11. 写入文件尾
-	av_write_trailer(output_fmt_ctx);
-	ret = 0; // 执行到这里表示成功
+		// 下一个输入接在本输入最长的流之后，音视频共用同一偏移保持同步
+		offset = segment_end;
+	}
 
+	if (write_ok) {
+		if (av_write_trailer(out_fmt_ctx) < 0) {
+			std::cerr << "[错误] 写入文件尾失败: " << output_url << std::endl;
+			write_ok = false;
+		}
+	}
 
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+	std::cout << "[info] SpliceAVMulti inputs:" << inputs.size() << " packets:" << packets
+		<< " seconds:" << seconds << " buffer allocs:" << (media_buffer_alloc_count() - begin_allocs)
+		<< (write_ok ? " ok" : " fair") << std::endl;
 
-	return ret;
+	cleanup();
+	return write_ok;
 }
 /*
 double AvWorker::getDuration(const std::string & input_path)
@@ -1411,6 +2885,11 @@ extern "C" OPENCVFFMPEGTOOLS_API double AvWorker_getDuration(void* worker, const
 		return -1;
 	}
 	std::string input_path = input_url;
+	// 本地文件走元数据索引，未变化的文件不再重新探测；网络流等无法stat的地址直接探测
+	AvMediaInfo info;
+	if (MediaIndex::instance().getInfo(input_path, info) && info.duration >= 0) {
+		return info.duration;
+	}
 	return static_cast<AvWorker*>(worker)->getDuration(input_path);
 }
 
@@ -1427,6 +2906,36 @@ extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_GetVideoFirstFrame(void* worker,
 	return static_cast<AvWorker*>(worker)->GetVideoFirstFrame(input_url, output_bmp, is_rtsp);
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_GetVideoThumbnail(void* worker, const char* input_url, int max_width, int max_height, int format,
+	double seek_seconds, unsigned char** out_data, int* out_size, int* out_width, int* out_height, bool is_rtsp)
+{
+	if (!worker || !input_url || !out_data || !out_size) {
+		return false;
+	}
+	*out_data = nullptr;
+	*out_size = 0;
+	std::vector<uint8_t> buffer;
+	int w = 0, h = 0;
+	if (!static_cast<AvWorker*>(worker)->GetVideoThumbnail(input_url, max_width, max_height, format, seek_seconds, buffer, w, h, is_rtsp)) {
+		return false;
+	}
+	// 在DLL内分配，调用方用AvWorker_FreeBuffer释放
+	*out_data = static_cast<unsigned char*>(av_malloc(buffer.size()));
+	if (!*out_data) {
+		return false;
+	}
+	memcpy(*out_data, buffer.data(), buffer.size());
+	*out_size = static_cast<int>(buffer.size());
+	if (out_width) *out_width = w;
+	if (out_height) *out_height = h;
+	return true;
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void AvWorker_FreeBuffer(unsigned char* data)
+{
+	av_free(data);
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_SpliceAV(void* worker, const char* input_url1, const char* input_url2, const char* output_url, bool is_rtsp)
 {
 	if (!worker || !input_url1 || !input_url2 || !output_url) {
@@ -1435,6 +2944,19 @@ extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_SpliceAV(void* worker, const char
 	return static_cast<AvWorker*>(worker)->SpliceAV(input_url1, input_url2, output_url, is_rtsp);
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_SpliceAVMulti(void* worker, const char** input_urls, int count, const char* output_url, bool is_rtsp)
+{
+	if (!worker || !input_urls || count < 2 || !output_url) {
+		return false;
+	}
+	std::vector<std::string> inputs;
+	for (int i = 0; i < count; ++i) {
+		if (!input_urls[i]) return false;
+		inputs.push_back(input_urls[i]);
+	}
+	return static_cast<AvWorker*>(worker)->SpliceAVMulti(inputs, output_url, is_rtsp);
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_resize_video(void* worker, const char* input_url, const char* output_url, int dst_width, int dst_height)
 {
 	if (!worker || !input_url  || !output_url) {
@@ -1443,6 +2965,108 @@ extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_resize_video(void* worker, const
 	return static_cast<AvWorker*>(worker)->resize_video(input_url,  output_url, dst_width,dst_height);
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_resize_video_preset(void* worker, const char* input_url, const char* output_url, int dst_width, int dst_height, int preset)
+{
+	if (!worker || !input_url || !output_url) {
+		return false;
+	}
+	return static_cast<AvWorker*>(worker)->resize_video(input_url, output_url, dst_width, dst_height, preset);
+}
+
+// 单独测缩放段吞吐：合成一帧YUV420P源图，分别用单条带和按CPU核数切条带缩放frames次，
+// 目标帧从池中取、用完归还。返回预热后的缓冲区分配次数，参数错误或缩放失败返回-1
+extern "C" OPENCVFFMPEGTOOLS_API int AvWorker_BenchmarkScale(int src_width, int src_height, int dst_width, int dst_height,
+	int preset, int frames, double* single_fps, double* sliced_fps)
+{
+	if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0 || frames <= 0) {
+		return -1;
+	}
+	const char* x264_preset = nullptr;
+	int sws_flags = 0;
+	resize_preset_options(preset, x264_preset, sws_flags);
+
+	FramePool src_pool;
+	AVFrame* src = src_pool.video(src_width, src_height, AV_PIX_FMT_YUV420P);
+	if (!src) {
+		std::cerr << "AvWorker_BenchmarkScale alloc fair" << std::endl;
+		return -1;
+	}
+	// 斜向渐变，避免纯色图让缩放走捷径
+	for (int p = 0; p < 3; ++p) {
+		int w = p == 0 ? src_width : (src_width + 1) / 2;
+		int h = p == 0 ? src_height : (src_height + 1) / 2;
+		for (int y = 0; y < h; ++y) {
+			uint8_t* row = src->data[p] + static_cast<ptrdiff_t>(y) * src->linesize[p];
+			for (int x = 0; x < w; ++x) {
+				row[x] = static_cast<uint8_t>((x + y * (p + 1)) & 0xFF);
+			}
+		}
+	}
+
+	FramePool dst_pool;
+	const int warmup = std::min(5, frames);
+	int64_t steady_allocs = 0;
+	double fps[2] = { 0.0, 0.0 };
+	const int slice_requests[2] = { 1, 0 };
+	int slice_counts[2] = { 1, 1 };
+	bool ok = true;
+	for (int run = 0; run < 2 && ok; ++run) {
+		SliceScaler scaler;
+		if (!scaler.init(src_width, src_height, AV_PIX_FMT_YUV420P, dst_width, dst_height, AV_PIX_FMT_YUV420P,
+			sws_flags, slice_requests[run])) {
+			std::cerr << "sws_getContext fair" << std::endl;
+			ok = false;
+			break;
+		}
+		slice_counts[run] = scaler.sliceCount();
+		int64_t base_allocs = 0;
+		auto begin_time = std::chrono::steady_clock::now();
+		for (int i = 0; i < warmup + frames && ok; ++i) {
+			if (i == warmup) {
+				base_allocs = media_buffer_alloc_count();
+				begin_time = std::chrono::steady_clock::now();
+			}
+			AVFrame* dst = dst_pool.video(dst_width, dst_height, AV_PIX_FMT_YUV420P);
+			ok = dst != nullptr && scaler.scale(src, dst);
+			dst_pool.recycle(dst);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+		fps[run] = seconds > 0 ? frames / seconds : 0.0;
+		steady_allocs += media_buffer_alloc_count() - base_allocs;
+	}
+	src_pool.recycle(src);
+	if (!ok) {
+		std::cerr << "AvWorker_BenchmarkScale sws_scale fair" << std::endl;
+		return -1;
+	}
+
+	std::cout << "scale benchmark | " << src_width << "x" << src_height << " -> " << dst_width << "x" << dst_height
+		<< " | preset:" << x264_preset << " | frames:" << frames
+		<< " | single fps:" << fps[0] << " | slices:" << slice_counts[1] << " fps:" << fps[1]
+		<< " | speedup:" << (fps[0] > 0 ? fps[1] / fps[0] : 0.0)
+		<< " | steady buffer allocs:" << steady_allocs << std::endl;
+	if (single_fps) *single_fps = fps[0];
+	if (sliced_fps) *sliced_fps = fps[1];
+	return static_cast<int>(steady_allocs);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvWorker_BenchmarkResize(void* worker, const char* input_url, const char* output_url,
+	int dst_width, int dst_height, double* serial_fps, double* threaded_fps)
+{
+	if (!worker || !input_url || !output_url) {
+		return -1;
+	}
+	return static_cast<AvWorker*>(worker)->benchmark_resize(input_url, output_url, dst_width, dst_height, serial_fps, threaded_fps);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvWorker_resize_video_ladder(void* worker, const char* input_url, const AvRendition* renditions, int count, int preset)
+{
+	if (!worker || !input_url || !renditions || count <= 0) {
+		return -1;
+	}
+	return static_cast<AvWorker*>(worker)->resize_video_ladder(input_url, renditions, count, preset);
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_split_video(
 	void* worker,
 	const char* input_url,
@@ -1467,3 +3091,28 @@ extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_split_video(
 	return (result == 0);
 }
 
+
+extern "C" OPENCVFFMPEGTOOLS_API bool AvWorker_split_video_smart(
+	void* worker,
+	const char* input_url,
+	const char* output_url,
+	double start_seconds,
+	double duration_seconds)
+{
+	if (!worker || !input_url || !output_url) {
+		return false;
+	}
+	return static_cast<AvWorker*>(worker)->split_video_smart(input_url, output_url, start_seconds, duration_seconds) == 0;
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int AvWorker_split_video_multi(
+	void* worker,
+	const char* input_url,
+	const AvSplitSegment* segments,
+	int count)
+{
+	if (!worker || !input_url || !segments || count <= 0) {
+		return -1;
+	}
+	return static_cast<AvWorker*>(worker)->split_video_multi(input_url, segments, count);
+}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "OpenCVFFMpegTools.h"
 
@@ -21,6 +22,17 @@ public :
 	 * \return 
 	 */
 	bool SpliceAV(const std::string& input_url1, const std::string& input_url2, const std::string& output_url, bool is_rtsp);
+	/**
+	 * N·ƴ.
+	 * 
+	 * ԵһƵΪ׼һµֱӸƣһµ뵥رƴӡ
+	 * ÿֻһƵ͵һƵ
+	 * \param input_urls 2룬˳ƴ
+	 * \param output_url
+	 * \param is_rtsp
+	 * \return 
+	 */
+	bool SpliceAVMulti(const std::vector<std::string>& input_urls, const std::string& output_url, bool is_rtsp);
 	/**
 	 * ÷ֱ.
 	 * 
@@ -32,6 +44,34 @@ public :
 	 */
 	bool resize_video(const std::string& input_path, const std::string& output_path,
 		int dst_width, int dst_height);
+	/**
+	 * ÷ֱʣѡٶ/λ.
+	 * 
+	 * 롢šˮִУʱfps
+	 * \param preset AvResizePreset
+	 * \return 
+	 */
+	bool resize_video(const std::string& input_path, const std::string& output_path,
+		int dst_width, int dst_height, int preset);
+	/**
+	 * ʽݣһνͬʱ൵ֱ.
+	 * 
+	 * ÿһ+̣߳֡÷ַ
+	 * \param renditions 
+	 * \param preset AvResizePreset
+	 * \return ɹ·-1ʾʧ
+	 */
+	int resize_video_ladder(const std::string& input_path, const AvRendition* renditions, int count, int preset);
+	/**
+	 * 4K->1080pŵˮ¶Ա.
+	 * 
+	 * ͬһresize_videomediumȴлߣ/1̡߳ţ
+	 * ٰĬ߳СԸռһ߳صִУֻÿβڲС
+	 * ļΪڶĽ
+	 * \return ɹ0һʧܷ-1
+	 */
+	int benchmark_resize(const std::string& input_path, const std::string& output_path,
+		int dst_width, int dst_height, double* serial_fps, double* threaded_fps);
 	/**
 	 * @brief Ƶһ֡.
 	 * 
@@ -41,6 +81,21 @@ public :
 	 * \return 
 	 */
 	bool GetVideoFirstFrame(const std::string& input_url, const std::string& output_bmp, bool is_rtsp = false);
+	/**
+	 * ͼڴз.
+	 * 
+	 * \param max_width ͼ
+	 * \param max_height ͼ߶
+	 * \param format AvThumbFormat
+	 * \param seek_seconds >0ʱȡʱ֮ǰĹؼ֡ȡһؼ֡
+	 * \param out ͼƬݣBGR24أ
+	 * \param out_width ʵʿ
+	 * \param out_height ʵʸ߶
+	 * \param is_rtsp
+	 * \return 
+	 */
+	bool GetVideoThumbnail(const std::string& input_url, int max_width, int max_height, int format,
+		double seek_seconds, std::vector<uint8_t>& out, int& out_width, int& out_height, bool is_rtsp);
 	/**
 	 * @brief Ϊbmp.
 	 * 
@@ -64,6 +119,31 @@ public :
 		const std::string& output_path,
 		double start_seconds,
 		double duration_seconds);
+	/**
+	 * @brief ֡ȷָֻر㵽һؼ֡ƬΣֱӸ.
+	 * 
+	 * \param input_path
+	 * \param output_path
+	 * \param start_seconds
+	 * \param duration_seconds 0ʾβ
+	 * \return 0ɹ-1ʧ
+	 */
+	int split_video_smart(const std::string& input_path,
+		const std::string& output_path,
+		double start_seconds,
+		double duration_seconds);
+	/**
+	 * @brief һζȡ룬ͬʱֶΣֱӸƣ.
+	 * 
+	 * \param input_path
+	 * \param segments ֶ
+	 * \param count ֶθ
+	 * \return ɹдķֶʧܷ-1
+	 */
+	int split_video_multi(const std::string& input_path, const AvSplitSegment* segments, int count);
 	double getDuration(const std::string& input_path);
+private:
+	bool resize_video_impl(const std::string& input_path, const std::string& output_path,
+		int dst_width, int dst_height, int preset, bool serial, double* fps_out);
 };
 
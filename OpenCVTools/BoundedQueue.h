@@ -0,0 +1,165 @@
+/*****************************************************************//**
+ * \file   BoundedQueue.h
+ * \brief  有界无锁队列（多生产者/多消费者），用于解码-特效-编码流水线
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+template <typename T>
+class BoundedQueue
+{
+public:
+	/**
+	 * @brief 创建队列.
+	 *
+	 * \param capacity 容量，内部向上取整到2的幂
+	 */
+	explicit BoundedQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		m_mask = size - 1;
+		m_cells.reset(new Cell[size]);
+		for (size_t i = 0; i < size; ++i) {
+			m_cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+		m_enqueuePos.store(0, std::memory_order_relaxed);
+		m_dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	/**
+	 * @brief 非阻塞入队.
+	 *
+	 * \return 队列已满返回false
+	 */
+	bool tryPush(const T& value)
+	{
+		Cell* cell = nullptr;
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &m_cells[pos & m_mask];
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (diff < 0) {
+				return false; // 已满
+			}
+			else {
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = value;
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief 非阻塞出队.
+	 *
+	 * \return 队列为空返回false
+	 */
+	bool tryPop(T& value)
+	{
+		Cell* cell = nullptr;
+		size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &m_cells[pos & m_mask];
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (diff < 0) {
+				return false; // 为空
+			}
+			else {
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		value = cell->data;
+		cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief 阻塞入队，abort 置位时放弃.
+	 *
+	 * \return 成功入队返回true
+	 */
+	bool push(const T& value, const std::atomic<bool>& abort)
+	{
+		int spins = 0;
+		while (!tryPush(value)) {
+			if (abort.load(std::memory_order_relaxed)) {
+				return false;
+			}
+			backoff(spins);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 阻塞出队，abort 置位时放弃.
+	 *
+	 * \return 成功出队返回true
+	 */
+	bool pop(T& value, const std::atomic<bool>& abort)
+	{
+		int spins = 0;
+		while (!tryPop(value)) {
+			if (abort.load(std::memory_order_relaxed)) {
+				return false;
+			}
+			backoff(spins);
+		}
+		return true;
+	}
+
+private:
+	// 先自旋让出，再短暂休眠，避免空等时占满CPU
+	static void backoff(int& spins)
+	{
+		if (++spins < 64) {
+			std::this_thread::yield();
+		}
+		else {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	}
+
+	struct Cell {
+		std::atomic<size_t> seq;
+		T data;
+	};
+
+	// 入队/出队位置分处不同缓存行，避免生产者和消费者互相失效。
+	// 用整行填充而不是alignas(64)：过对齐类型在C++14下new出来不保证对齐（C4316/-Waligned-new）
+	static const size_t kCacheLine = 64;
+
+	std::unique_ptr<Cell[]> m_cells;
+	size_t m_mask = 0;
+	char m_pad0[kCacheLine];
+	std::atomic<size_t> m_enqueuePos;
+	char m_pad1[kCacheLine];
+	std::atomic<size_t> m_dequeuePos;
+	char m_pad2[kCacheLine];
+};
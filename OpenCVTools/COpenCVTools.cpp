@@ -1,129 +1,226 @@
 #include "pch.h"
 #include "COpenCVTools.h"
+#include "MediaBuffer.h"
+
+// 池中最多保留的空闲frame数量，超出的直接释放
+static const size_t kMaxPooledFrames = 8;
 
 COpenCVTools::COpenCVTools()
 {
 	return;
 }
 
+COpenCVTools::~COpenCVTools()
+{
+	for (auto& it : m_swsCache) {
+		sws_freeContext(it.second);
+	}
+	m_swsCache.clear();
+
+	std::lock_guard<std::mutex> lock(m_poolMtx);
+	for (AVFrame* frame : m_framePool) {
+		av_frame_free(&frame);
+	}
+	m_framePool.clear();
+}
+
 void COpenCVTools::test()
 {
 	cv::Mat a;
 }
 
+SwsContext* COpenCVTools::getSwsContext(int w, int h, int srcFmt, int dstFmt)
+{
+	SwsKey key = { w, h, srcFmt, dstFmt };
+	auto it = m_swsCache.find(key);
+	if (it != m_swsCache.end()) {
+		return it->second;
+	}
+
+	SwsContext* swsCtx = sws_getContext(
+		w, h, (AVPixelFormat)srcFmt,
+		w, h, (AVPixelFormat)dstFmt,
+		SWS_BICUBIC, NULL, NULL, NULL);
+	if (!swsCtx) {
+		return nullptr;
+	}
+	m_swsCache[key] = swsCtx;
+	return swsCtx;
+}
+
+AVFrame* COpenCVTools::acquireFrame(int w, int h, int format)
+{
+	AVFrame* frame = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_poolMtx);
+		while (!m_framePool.empty()) {
+			AVFrame* cand = m_framePool.back();
+			m_framePool.pop_back();
+			if (cand->width == w && cand->height == h && cand->format == format) {
+				frame = cand;
+				break;
+			}
+			// 尺寸变化的旧frame直接丢弃
+			av_frame_free(&cand);
+		}
+	}
+
+	if (frame) {
+		// 编码器可能仍持有引用，此时才会重新分配
+		AVBufferRef* before = frame->buf[0];
+		if (av_frame_make_writable(frame) < 0) {
+			av_frame_free(&frame);
+			return nullptr;
+		}
+		if (frame->buf[0] != before) {
+			media_buffer_note_alloc();
+		}
+		return frame;
+	}
+
+	media_buffer_note_alloc();
+	frame = av_frame_alloc();
+	if (!frame) {
+		return nullptr;
+	}
+	frame->width = w;
+	frame->height = h;
+	frame->format = format;
+	if (av_frame_get_buffer(frame, 32) < 0) {
+		av_frame_free(&frame);
+		return nullptr;
+	}
+	return frame;
+}
+
+void COpenCVTools::recycleFrame(AVFrame* frame)
+{
+	if (!frame) {
+		return;
+	}
+	// 清掉上一帧的时间戳等属性，保留数据缓冲
+	frame->pts = AV_NOPTS_VALUE;
+	frame->pict_type = AV_PICTURE_TYPE_NONE;
+	frame->key_frame = 0;
+
+	std::lock_guard<std::mutex> lock(m_poolMtx);
+	if (m_framePool.size() >= kMaxPooledFrames) {
+		av_frame_free(&frame);
+		return;
+	}
+	m_framePool.push_back(frame);
+}
+
 cv::Mat COpenCVTools::AVFrameToCVMat(AVFrame* yuv420Frame)
 {
-	if (!yuv420Frame || yuv420Frame->width <= 0 || yuv420Frame->height <= 0) {
+	cv::Mat mat;
+	if (!AVFrameToCVMat(yuv420Frame, mat)) {
 		return cv::Mat(); // 返回空Mat
 	}
+	// 包装模式下拷贝一份，保证返回值独立于frame
+	if (yuv420Frame->format == AV_PIX_FMT_BGR24) {
+		return mat.clone();
+	}
+	return mat;
+}
+
+bool COpenCVTools::AVFrameToCVMat(AVFrame* frame, cv::Mat& out)
+{
+	if (!frame || frame->width <= 0 || frame->height <= 0) {
+		return false;
+	}
 
 	// 得到AVFrame信息
-	int srcW = yuv420Frame->width;
-	int srcH = yuv420Frame->height;
-	AVPixelFormat srcFormat = (AVPixelFormat)yuv420Frame->format;
-	
+	int srcW = frame->width;
+	int srcH = frame->height;
+	AVPixelFormat srcFormat = (AVPixelFormat)frame->format;
+
 	// 检查输入格式是否有效
 	if (srcFormat < 0 || srcFormat >= AV_PIX_FMT_NB) {
-		return cv::Mat();
+		return false;
 	}
 
-	// 直接创建3通道BGR Mat
-	cv::Mat mat(srcH, srcW, CV_8UC3);
-	
-	// 创建SwsContext：从任意格式转换为BGR24
-	SwsContext* swsCtx = sws_getContext(
-		srcW, srcH, srcFormat,
-		srcW, srcH, AV_PIX_FMT_BGR24,
-		SWS_BICUBIC, NULL, NULL, NULL);
+	// 已经是BGR24：out有同尺寸的自有缓冲区（u非空，不是包装外部内存）时拷贝进去，不改变调用方的Mat；
+	// 否则借用frame的数据，不拷贝
+	if (srcFormat == AV_PIX_FMT_BGR24) {
+		cv::Mat wrapped(srcH, srcW, CV_8UC3, frame->data[0], frame->linesize[0]);
+		if (out.u && out.rows == srcH && out.cols == srcW && out.type() == CV_8UC3) {
+			wrapped.copyTo(out);
+		}
+		else {
+			out = wrapped;
+		}
+		return true;
+	}
+
+	// 尺寸不变时create不会重新分配
+	out.create(srcH, srcW, CV_8UC3);
 
+	SwsContext* swsCtx = getSwsContext(srcW, srcH, srcFormat, AV_PIX_FMT_BGR24);
 	if (!swsCtx) {
-		return cv::Mat(); // SwsContext创建失败
+		return false; // SwsContext创建失败
 	}
 
 	// 设置输出数据指针和步长（直接使用Mat的数据）
-	uint8_t* dst_data[4] = { mat.data, nullptr, nullptr, nullptr };
-	int dst_linesize[4] = { mat.cols * 3, 0, 0, 0 };
+	uint8_t* dst_data[4] = { out.data, nullptr, nullptr, nullptr };
+	int dst_linesize[4] = { (int)out.step[0], 0, 0, 0 };
 
 	// 执行格式转换
 	sws_scale(swsCtx,
-		(const uint8_t* const*)yuv420Frame->data, yuv420Frame->linesize,
+		(const uint8_t* const*)frame->data, frame->linesize,
 		0, srcH,
 		dst_data, dst_linesize);
 
-	// 释放
-	sws_freeContext(swsCtx);
-
-	return mat;
+	return true;
 }
 
 AVFrame* COpenCVTools::CVMatToAVFrame(cv::Mat& inMat)
 {
-	if (inMat.empty() || inMat.cols <= 0 || inMat.rows <= 0) {
+	if (inMat.empty() || inMat.cols <= 0 || inMat.rows <= 0 || inMat.depth() != CV_8U) {
 		return nullptr;
 	}
 
-	// 确保输入是3通道BGR格式
-	cv::Mat bgrMat;
-	if (inMat.channels() == 1) {
-		// 单通道转3通道（灰度转BGR）
-		cv::cvtColor(inMat, bgrMat, cv::COLOR_GRAY2BGR);
-	} else if (inMat.channels() == 4) {
-		// BGRA转BGR
-		cv::cvtColor(inMat, bgrMat, cv::COLOR_BGRA2BGR);
-	} else if (inMat.channels() == 3) {
-		bgrMat = inMat;
-	} else {
+	// 按通道数选择源格式，由sws一步转到YUV420P，省去cvtColor的中间Mat
+	AVPixelFormat srcFormat;
+	switch (inMat.channels()) {
+	case 1:
+		srcFormat = AV_PIX_FMT_GRAY8;
+		break;
+	case 3:
+		srcFormat = AV_PIX_FMT_BGR24;
+		break;
+	case 4:
+		srcFormat = AV_PIX_FMT_BGRA;
+		break;
+	default:
 		// 不支持的通道数
 		return nullptr;
 	}
 
-	int width = bgrMat.cols;
-	int height = bgrMat.rows;
+	int width = inMat.cols;
+	int height = inMat.rows;
 
-	// 创建AVFrame填充参数 注：调用者释放该frame
-	AVFrame* frame = av_frame_alloc();
+	// 从池中取frame 注：调用者通过recycleFrame归还或自行释放
+	AVFrame* frame = acquireFrame(width, height, AV_PIX_FMT_YUV420P);
 	if (!frame) {
 		return nullptr;
 	}
-	frame->width = width;
-	frame->height = height;
-	frame->format = AV_PIX_FMT_YUV420P;
-
-	// 初始化AVFrame内部空间
-	int ret = av_frame_get_buffer(frame, 32);
-	if (ret < 0) {
-		av_frame_free(&frame);
-		return nullptr;
-	}
-	ret = av_frame_make_writable(frame);
-	if (ret < 0) {
-		av_frame_free(&frame);
-		return nullptr;
-	}
-
-	// 使用SwsContext进行转换
-	SwsContext* swsCtx = sws_getContext(
-		width, height, AV_PIX_FMT_BGR24,
-		width, height, AV_PIX_FMT_YUV420P,
-		SWS_BICUBIC, NULL, NULL, NULL);
 
+	SwsContext* swsCtx = getSwsContext(width, height, srcFormat, AV_PIX_FMT_YUV420P);
 	if (!swsCtx) {
-		av_frame_free(&frame);
+		recycleFrame(frame);
 		return nullptr;
 	}
 
-	// 设置输入数据指针
-	uint8_t* src_data[4] = { bgrMat.data, nullptr, nullptr, nullptr };
-	int src_linesize[4] = { width * 3, 0, 0, 0 };
+	// 设置输入数据指针，步长取Mat实际step以支持ROI
+	const uint8_t* src_data[4] = { inMat.data, nullptr, nullptr, nullptr };
+	int src_linesize[4] = { (int)inMat.step[0], 0, 0, 0 };
 
 	// 执行转换
 	sws_scale(swsCtx,
-		(const uint8_t* const*)src_data, src_linesize,
+		src_data, src_linesize,
 		0, height,
 		frame->data, frame->linesize);
 
-	// 清理
-	sws_freeContext(swsCtx);
-
 	return frame;
 }
@@ -5,14 +5,59 @@
 
 #ifdef __cplusplus
 #include <opencv2/opencv.hpp>
+#include <map>
+#include <mutex>
+#include <vector>
 
 struct AVFrame;
+struct SwsContext;
 
+// 有状态的转换器：缓存SwsContext并复用AVFrame，非线程安全（recycleFrame除外）
 class  COpenCVTools {
 public:
 	COpenCVTools();
+	~COpenCVTools();
+	COpenCVTools(const COpenCVTools&) = delete;
+	COpenCVTools& operator=(const COpenCVTools&) = delete;
+
 	void test();
 	cv::Mat AVFrameToCVMat(AVFrame* yuv420Frame);
+	/**
+	 * @brief 转换为BGR Mat，复用out的缓冲区.
+	 *
+	 * 其它格式经swscale写入out，尺寸不变时不重新分配。BGR24帧：out已有同尺寸的自有缓冲区时拷贝进去；
+	 * 否则out借用frame的数据（不拷贝），此时out只读、仅在frame有效期内可用，不要原地改写
+	 * \return 成功返回true
+	 */
+	bool AVFrameToCVMat(AVFrame* frame, cv::Mat& out);
+	/**
+	 * @brief 转换为YUV420P AVFrame.
+	 *
+	 * 返回的frame来自内部池，用完后调用recycleFrame归还（直接av_frame_free也安全）
+	 */
 	AVFrame* CVMatToAVFrame(cv::Mat& inMat);
+	// 归还CVMatToAVFrame得到的frame，可在其它线程调用
+	void recycleFrame(AVFrame* frame);
+
+private:
+	struct SwsKey {
+		int w;
+		int h;
+		int srcFmt;
+		int dstFmt;
+		bool operator<(const SwsKey& o) const {
+			if (w != o.w) return w < o.w;
+			if (h != o.h) return h < o.h;
+			if (srcFmt != o.srcFmt) return srcFmt < o.srcFmt;
+			return dstFmt < o.dstFmt;
+		}
+	};
+
+	SwsContext* getSwsContext(int w, int h, int srcFmt, int dstFmt);
+	AVFrame* acquireFrame(int w, int h, int format);
+
+	std::map<SwsKey, SwsContext*> m_swsCache;
+	std::vector<AVFrame*> m_framePool;
+	std::mutex m_poolMtx;
 };
 #endif
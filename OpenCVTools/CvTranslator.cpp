@@ -1,7 +1,12 @@
 #include "pch.h"
 #include "CvTranslator.h"
+#include "COpenCVTools.h"
+#include "EffectChain.h"
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <functional>
 
 
 CvTranslator::CvTranslator()
@@ -83,74 +88,230 @@ cv::Mat CvTranslator::customOilPaintApprox(const cv::Mat& src, int radius, doubl
 cv::Mat CvTranslator::applyMosaic(const cv::Mat &src, const cv::Rect &mosaicRegion, int cellSize) {
 	// 创建一个与源图像相同大小的目标图像
 	cv::Mat dst = src.clone();
+	applyMosaicRegions(dst, std::vector<cv::Rect>(1, mosaicRegion), cellSize);
+	return dst;
+}
 
-	// 马赛克区域的边界检查
-	int startX = cv::max(0, mosaicRegion.x);
-	int startY = cv::max(0, mosaicRegion.y);
-	int endX = cv::min(src.cols, mosaicRegion.x + mosaicRegion.width);
-	int endY = cv::min(src.rows, mosaicRegion.y + mosaicRegion.height);
-
-	// 遍历马赛克区域
-	for (int y = startY; y < endY; y += cellSize) {
-		for (int x = startX; x < endX; x += cellSize) {
-			// 计算马赛克块的边界
-			int x1 = x;
-			int y1 = y;
-			int x2 = cv::min(x + cellSize, endX);
-			int y2 = cv::min(y + cellSize, endY);
-
-			// 计算马赛克块的中心点
-			int centerX = (x1 + x2) / 2;
-			int centerY = (y1 + y2) / 2;
-
-			// 确保中心点在马赛克区域内
-			if (centerX >= startX && centerX < endX && centerY >= startY && centerY < endY) {
-				cv::Vec3b centerPixel = src.at<cv::Vec3b>(centerY, centerX);
-
-				// 将马赛克块内的像素值设置为中心像素值
-				for (int i = y1; i < y2; ++i) {
-					for (int j = x1; j < x2; ++j) {
-						dst.at<cv::Vec3b>(i, j) = centerPixel;
-					}
-				}
+// 一行格子：band为该行格子覆盖的像素行，sum为其积分图（行数band.rows+1）
+template <typename T>
+static void mosaicBand(cv::Mat& band, const cv::Mat& sum, int cellSize)
+{
+	const int cn = band.channels();
+	const T* top = sum.ptr<T>(0);
+	const T* bottom = sum.ptr<T>(band.rows);
+	for (int x = 0; x < band.cols; x += cellSize) {
+		int x2 = cv::min(x + cellSize, band.cols);
+		double area = (double)(x2 - x) * band.rows;
+
+		cv::Scalar avg;
+		for (int c = 0; c < cn; ++c) {
+			double s = (double)bottom[x2 * cn + c] - bottom[x * cn + c] - top[x2 * cn + c] + top[x * cn + c];
+			avg[c] = s / area;
+		}
+		band(cv::Rect(x, 0, x2 - x, band.rows)).setTo(avg);
+	}
+}
+
+// 单个区域的块均值马赛克：按格子行分带求积分图得到每块像素和，再整块填充均值。
+// 一带的像素和不超过255*cellSize*宽度，放得下时用CV_32S，超宽区域改用CV_64F，不会溢出
+static void mosaicOneRegion(cv::Mat& img, const cv::Rect& region, int cellSize)
+{
+	cv::Mat roi = img(region);
+	const bool fitsInt = 255.0 * cellSize * roi.cols <= INT_MAX;
+
+	cv::Mat sum;
+	for (int y = 0; y < roi.rows; y += cellSize) {
+		int y2 = cv::min(y + cellSize, roi.rows);
+		cv::Mat band = roi.rowRange(y, y2);
+		cv::integral(band, sum, fitsInt ? CV_32S : CV_64F);
+		if (fitsInt) {
+			mosaicBand<int>(band, sum, cellSize);
+		}
+		else {
+			mosaicBand<double>(band, sum, cellSize);
+		}
+	}
+}
+
+void CvTranslator::applyMosaicRegions(cv::Mat& img, const std::vector<cv::Rect>& regions, int cellSize)
+{
+	if (img.empty() || img.depth() != CV_8U || cellSize <= 0) {
+		return;
+	}
+
+	// 裁剪到图像范围内，丢弃空区域
+	std::vector<cv::Rect> valid;
+	const cv::Rect bounds(0, 0, img.cols, img.rows);
+	for (const cv::Rect& r : regions) {
+		cv::Rect clipped = r & bounds;
+		if (!clipped.empty()) {
+			valid.push_back(clipped);
+		}
+	}
+	if (valid.empty()) {
+		return;
+	}
+
+	// 区域互不重叠时并行处理；有重叠则按顺序处理，保证结果与区域顺序一致
+	bool overlap = false;
+	for (size_t i = 0; i < valid.size() && !overlap; ++i) {
+		for (size_t j = i + 1; j < valid.size(); ++j) {
+			if (!(valid[i] & valid[j]).empty()) {
+				overlap = true;
+				break;
 			}
 		}
 	}
 
-	return dst;
+	if (overlap || valid.size() == 1) {
+		for (const cv::Rect& r : valid) {
+			mosaicOneRegion(img, r, cellSize);
+		}
+		return;
+	}
+
+	cv::parallel_for_(cv::Range(0, (int)valid.size()), [&](const cv::Range& range) {
+		for (int i = range.start; i < range.end; ++i) {
+			mosaicOneRegion(img, valid[i], cellSize);
+		}
+	});
+}
+
+std::vector<cv::Rect> CvTranslator::parseRegions(const char* text)
+{
+	std::vector<cv::Rect> regions;
+	if (!text) {
+		return regions;
+	}
+
+	// 格式："x,y,w,h;x,y,w,h;..."
+	const char* p = text;
+	while (*p) {
+		int x = 0, y = 0, w = 0, h = 0;
+		int consumed = 0;
+		if (sscanf(p, " %d , %d , %d , %d %n", &x, &y, &w, &h, &consumed) != 4) {
+			break;
+		}
+		if (w > 0 && h > 0) {
+			regions.push_back(cv::Rect(x, y, w, h));
+		}
+		p += consumed;
+		if (*p != ';') {
+			break;
+		}
+		++p;
+	}
+	return regions;
+}
+
+// 基于计数器的哈希随机数：同一(seed,行,列)总得到同一个值，与线程划分无关
+static inline uint32_t frostedGlassHash(uint32_t seed, uint32_t row, uint32_t col)
+{
+	uint32_t h = seed ^ (row * 0x9E3779B1u) ^ (col * 0x85EBCA77u);
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+	return h;
 }
 
-cv::Mat CvTranslator::FrostedGlass(const cv::Mat & imageSource)
+cv::Mat CvTranslator::FrostedGlass(const cv::Mat & imageSource, unsigned int seed, const cv::Point& origin)
 {
+	if (imageSource.empty() || imageSource.type() != CV_8UC3) {
+		return imageSource.clone();
+	}
+
 	cv::Mat imageResult = imageSource.clone();
-	cv::RNG rng;
-	int randomNum;
-	int Number = 5;
+	const int Number = 5;
+	const int rows = imageSource.rows - Number;
+	const int cols = imageSource.cols - Number;
+	if (rows <= 0 || cols <= 0) {
+		return imageResult;
+	}
+
+	// 按行分块并行，每个像素从右下方[0,Number)的对角偏移处取样
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		std::vector<uint8_t> offsets(cols);
+		for (int i = range.start; i < range.end; i++) {
+			// 先整行生成偏移，循环无依赖便于编译器向量化
+			for (int j = 0; j < cols; j++) {
+				offsets[j] = (uint8_t)(((uint64_t)frostedGlassHash(seed, i + origin.y, j + origin.x) * Number) >> 32);
+			}
 
-	for (int i = 0; i < imageSource.rows - Number; i++)
-		for (int j = 0; j < imageSource.cols - Number; j++)
-		{
-			randomNum = rng.uniform(0, Number);
-			imageResult.at<cv::Vec3b>(i, j)[0] = imageSource.at<cv::Vec3b>(i + randomNum, j + randomNum)[0];
-			imageResult.at<cv::Vec3b>(i, j)[1] = imageSource.at<cv::Vec3b>(i + randomNum, j + randomNum)[1];
-			imageResult.at<cv::Vec3b>(i, j)[2] = imageSource.at<cv::Vec3b>(i + randomNum, j + randomNum)[2];
+			uchar* dst = imageResult.ptr<uchar>(i);
+			for (int j = 0; j < cols; j++) {
+				int r = offsets[j];
+				const uchar* src = imageSource.ptr<uchar>(i + r) + (j + r) * 3;
+				dst[j * 3] = src[0];
+				dst[j * 3 + 1] = src[1];
+				dst[j * 3 + 2] = src[2];
+			}
 		}
+	});
 	return imageResult;
 }
 
 
-cv::Mat CvTranslator::simpleSkinSmoothing(const cv::Mat& inputImage) {
+cv::Mat CvTranslator::simpleSkinSmoothing(const cv::Mat& inputImage, int mode, const cv::Size& fullSize) {
 	int d = 15; double sigmaColor = 150; double sigmaSpace = 15;
 	if (inputImage.empty()) {
 		std::cerr << "skinsmooth: input is null" << std::endl;
 		return inputImage;
 	}
 
+	if (mode == 1) {
+		// 比例取自整图，各块按同一比例缩放
+		return fastSkinSmoothing(inputImage, d, sigmaColor, sigmaSpace,
+			skinSmoothingScale(fullSize.area() > 0 ? fullSize : inputImage.size()));
+	}
+
 	cv::Mat smoothedImage;
 	bilateralFilter(inputImage, smoothedImage, d, sigmaColor, sigmaSpace);
 
 	return smoothedImage;
 }
+
+double CvTranslator::skinSmoothingScale(const cv::Size& fullSize)
+{
+	// 短边缩到360左右再滤波，双边滤波的代价随d^2下降
+	const int shortSide = cv::min(fullSize.width, fullSize.height);
+	if (shortSide <= 0) {
+		return 1.0;
+	}
+	return cv::min(1.0, cv::max(0.25, 360.0 / shortSide));
+}
+
+cv::Mat CvTranslator::fastSkinSmoothing(const cv::Mat& src, int d, double sigmaColor, double sigmaSpace, double scale)
+{
+	if (scale >= 1.0) {
+		cv::Mat dst;
+		cv::bilateralFilter(src, dst, d, sigmaColor, sigmaSpace);
+		return dst;
+	}
+
+	cv::Mat mSmall;
+	cv::resize(src, mSmall, cv::Size(), scale, scale, cv::INTER_AREA);
+
+	// 空间参数按缩放比例同步缩小，保证滤波覆盖的原图范围不变
+	int dSmall = cv::max(3, (int)(d * scale + 0.5)) | 1;
+	cv::Mat blurSmall;
+	cv::bilateralFilter(mSmall, blurSmall, dSmall, sigmaColor, sigmaSpace * scale);
+
+	// 上采样得到平滑底图；同样缩放原图得到低频，二者之差即缩放丢失的细节
+	cv::Mat base, lowFreq;
+	cv::resize(blurSmall, base, src.size(), 0, 0, cv::INTER_LINEAR);
+	cv::resize(mSmall, lowFreq, src.size(), 0, 0, cv::INTER_LINEAR);
+
+	// 细节回叠：保留少量高频，避免放大后边缘发虚
+	const double detailGain = 0.3;
+	cv::Mat detail;
+	cv::addWeighted(src, detailGain, lowFreq, -detailGain, 0, detail, CV_16S);
+
+	cv::Mat dst;
+	cv::add(base, detail, dst, cv::noArray(), src.depth());
+	return dst;
+}
 /*
 cv::Mat CvTranslator::addTextWatermark(const cv::Mat& src, const std::string& text) {
 	//初始化
@@ -173,72 +334,109 @@ cv::Mat CvTranslator::addTextWatermark(const cv::Mat& src, const std::string& te
 	return dst;
 }
 */
-cv::Mat CvTranslator::Whitening(const cv::Mat& src) {
-	if (src.empty()) return cv::Mat();
+// 美白2的映射曲线，下标为原通道值
+static const int kWhitening2Curve[256] = {
+	1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 31, 33, 35, 37,
+	39, 41, 43, 44, 46, 48, 50, 52, 53, 55, 57, 59, 60, 62, 64, 66, 67, 69, 71, 73,
+	74, 76, 78, 79, 81, 83, 84, 86, 87, 89, 91, 92, 94, 95, 97, 99, 100, 102, 103, 105,
+	106, 108, 109, 111, 112, 114, 115, 117, 118, 120, 121, 123, 124, 126, 127, 128, 130, 131, 133, 134,
+	135, 137, 138, 139, 141, 142, 143, 145, 146, 147, 149, 150, 151, 153, 154, 155, 156, 158, 159, 160,
+	161, 162, 164, 165, 166, 167, 168, 170, 171, 172, 173, 174, 175, 176, 178, 179, 180, 181, 182, 183,
+	184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203,
+	204, 205, 205, 206, 207, 208, 209, 210, 211, 211, 212, 213, 214, 215, 215, 216, 217, 218, 219, 219,
+	220, 221, 222, 222, 223, 224, 224, 225, 226, 226, 227, 228, 228, 229, 230, 230, 231, 232, 232, 233,
+	233, 234, 235, 235, 236, 236, 237, 237, 238, 238, 239, 239, 240, 240, 241, 241, 242, 242, 243, 243,
+	244, 244, 244, 245, 245, 246, 246, 246, 247, 247, 248, 248, 248, 249, 249, 249, 250, 250, 250, 250,
+	251, 251, 251, 251, 252, 252, 252, 252, 253, 253, 253, 253, 253, 254, 254, 254, 254, 254, 254, 254,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 256
+};
+
+// 美白：dst = src * 1.3 + 30，只在首次使用时生成一次。
+// 表由原实现的同一串运算（转CV_32F、乘加、convertTo截断）作用于0~255的灰阶得到，舍入与原结果逐值一致
+static const cv::Mat& whiteningLut()
+{
+	static const cv::Mat lut = []() {
+		cv::Mat ramp(1, 256, CV_8UC1);
+		uchar* p = ramp.ptr<uchar>(0);
+		for (int i = 0; i < 256; ++i) {
+			p[i] = static_cast<uchar>(i);
+		}
+		cv::Mat f;
+		ramp.convertTo(f, CV_32F);
+		f = f * 1.3 + 30;
+		cv::Mat m;
+		f.convertTo(m, CV_8U);
+		return m;
+	}();
+	return lut;
+}
 
-	cv::Mat dst = src.clone();
-	// 转换为浮点型以避免运算溢出（中间过程使用更高精度）
-	src.convertTo(dst, CV_32F);
+// 美白2：曲线末项为256，截断到255
+static const cv::Mat& whitening2Lut()
+{
+	static const cv::Mat lut = []() {
+		cv::Mat m(1, 256, CV_8UC1);
+		uchar* p = m.ptr<uchar>(0);
+		for (int i = 0; i < 256; ++i) {
+			p[i] = cv::saturate_cast<uchar>(kWhitening2Curve[i]);
+		}
+		return m;
+	}();
+	return lut;
+}
 
-	// 定义美白参数（与原逻辑保持一致）
-	double alpha = 1.3;    // 比例系数
-	int beta = 30;         // 偏移量
+cv::Mat CvTranslator::Whitening(const cv::Mat& src) {
+	if (src.empty()) return cv::Mat();
 
-	// 矩阵运算：dst = src * alpha + beta（替代双重循环）
-	dst = dst * alpha + beta;
+	// 查表一次完成，表由原先转CV_32F再乘加的运算生成，结果一致
+	return applyLut(src, whiteningLut());
+}
 
-	// 转换回原类型，并自动截断超出[0,255]的像素值（替代saturate_cast）
-	dst.convertTo(dst, src.type(), 1.0, 0.0);
+cv::Mat CvTranslator::Whitening2(const cv::Mat &src) {
+	if (src.empty()) return cv::Mat();
 
-	return dst;
+	return applyLut(src, whitening2Lut());
 }
 
-cv::Mat CvTranslator::Whitening2(const cv::Mat &src) {
-	std::vector<int> Color_list = {
-	1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 31, 33, 35, 37, 39,
-	41, 43, 44, 46, 48, 50, 52, 53, 55, 57, 59, 60, 62, 64, 66, 67, 69, 71, 73, 74,
-	76, 78, 79, 81, 83, 84, 86, 87, 89, 91, 92, 94, 95, 97, 99, 100, 102, 103, 105,
-	106, 108, 109, 111, 112, 114, 115, 117, 118, 120, 121, 123, 124, 126, 127, 128,
-	130, 131, 133, 134, 135, 137, 138, 139, 141, 142, 143, 145, 146, 147, 149, 150,
-	151, 153, 154, 155, 156, 158, 159, 160, 161, 162, 164, 165, 166, 167, 168, 170,
-	171, 172, 173, 174, 175, 176, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187,
-	188, 189, 190, 191, 192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203,
-	204, 205, 205, 206, 207, 208, 209, 210, 211, 211, 212, 213, 214, 215, 215, 216,
-	217, 218, 219, 219, 220, 221, 222, 222, 223, 224, 224, 225, 226, 226, 227, 228,
-	228, 229, 230, 230, 231, 232, 232, 233, 233, 234, 235, 235, 236, 236, 237, 237,
-	238, 238, 239, 239, 240, 240, 241, 241, 242, 242, 243, 243, 244, 244, 244, 245,
-	245, 246, 246, 246, 247, 247, 248, 248, 248, 249, 249, 249, 250, 250, 250, 250,
-	251, 251, 251, 251, 252, 252, 252, 252, 253, 253, 253, 253, 253, 254, 254, 254,
-	254, 254, 254, 254, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-	255, 255, 255, 256 };
-	cv::Mat dst = src.clone();
-	// 转换为浮点型以避免运算溢出（中间过程使用更高精度）
+bool CvTranslator::isValidLut(const cv::Mat& lut, int channels)
+{
+	if (lut.total() != 256 || lut.depth() != CV_8U) {
+		return false;
+	}
+	return lut.channels() == 1 || lut.channels() == channels;
+}
 
-	if (Color_list.size() <= 255) {
-		std::cerr << "错误：Color_list长度不足，无法覆盖0~255索引" << std::endl;
+cv::Mat CvTranslator::applyLut(const cv::Mat& src, const cv::Mat& lut)
+{
+	if (src.empty() || src.depth() != CV_8U || !isValidLut(lut, src.channels())) {
 		return cv::Mat();
 	}
+	cv::Mat dst;
+	cv::LUT(src, lut, dst);
+	return dst;
+}
 
-	// 遍历像素进行颜色映射（使用指针访问提升效率）
-	for (int i = 0; i < dst.rows; ++i) {
-		// 获取第i行的指针（CV_8UC3对应cv::Vec3b）
-		cv::Vec3b* row_ptr = dst.ptr<cv::Vec3b>(i);
-		for (int j = 0; j < dst.cols; ++j) {
-			// 分别对B、G、R通道进行映射（注意OpenCV默认是BGR顺序）
-			int b = row_ptr[j][0];  // 原B通道值（0~255）
-			int g = row_ptr[j][1];  // 原G通道值
-			int r = row_ptr[j][2];  // 原R通道值
-
-			// 映射到Color_list中的值（确保索引在有效范围）
-			row_ptr[j][0] = static_cast<uchar>(Color_list[b]);  // 新B通道
-			row_ptr[j][1] = static_cast<uchar>(Color_list[g]);  // 新G通道
-			row_ptr[j][2] = static_cast<uchar>(Color_list[r]);  // 新R通道
-		}
+bool CvTranslator::applyLutInPlace(cv::Mat& img, const cv::Mat& lut)
+{
+	if (img.empty() || img.depth() != CV_8U || !isValidLut(lut, img.channels())) {
+		return false;
 	}
+	// LUT逐元素处理，源和目标相同也安全
+	cv::LUT(img, lut, img);
+	return true;
+}
 
-	// 转换回原类型，并自动截断超出[0,255]的像素值（替代saturate_cast）
-
-	return dst;
+cv::Mat CvTranslator::gammaLut(double gamma)
+{
+	cv::Mat lut(1, 256, CV_8UC1);
+	uchar* p = lut.ptr<uchar>(0);
+	if (gamma <= 0) {
+		gamma = 1.0;
+	}
+	for (int i = 0; i < 256; ++i) {
+		p[i] = cv::saturate_cast<uchar>(std::pow(i / 255.0, 1.0 / gamma) * 255.0);
+	}
+	return lut;
 }
 
 
@@ -267,6 +465,110 @@ cv::Mat CvTranslator::invertImage(cv::Mat src)
 	return invertedImage;
 }
 
+bool CvTranslator::supportsYUV(func fun)
+{
+	// func枚举与成员函数同名，需加::限定
+	switch (fun) {
+	case ::grayImage:
+	case ::invertImage:
+	case ::Whitening:
+	case ::Whitening2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// 按帧的色彩范围生成Y/UV两张查找表，公式与BGR版本在全范围下等价
+static void buildYuvLuts(func fun, bool fullRange, cv::Mat& lutY, cv::Mat& lutUV)
+{
+	const double yLo = fullRange ? 0.0 : 16.0;
+	const double yScale = fullRange ? 1.0 : 219.0 / 255.0;  // 全范围亮度 -> 当前范围
+	const double yMax = fullRange ? 255.0 : 235.0;
+	const double cMin = fullRange ? 0.0 : 16.0;
+	const double cMax = fullRange ? 255.0 : 240.0;
+
+	lutY.create(1, 256, CV_8U);
+	lutUV.create(1, 256, CV_8U);
+	uchar* ly = lutY.ptr<uchar>(0);
+	uchar* lc = lutUV.ptr<uchar>(0);
+	for (int i = 0; i < 256; ++i) {
+		double y = i;
+		double c = i;
+		switch (fun) {
+		case invertImage:
+			// 255-RGB：亮度关于范围中点翻转，色度关于128翻转
+			y = yLo + yMax - i;
+			c = 256 - i;
+			break;
+		case Whitening:
+			// RGB*1.3+30：亮度同样仿射，色度只做缩放
+			y = yLo + 1.3 * (i - yLo) + 30.0 * yScale;
+			c = 128 + 1.3 * (i - 128);
+			break;
+		case Whitening2:
+		{
+			double full = (i - yLo) / yScale;
+			int idx = cv::saturate_cast<uchar>(full);
+			y = yLo + std::min(kWhitening2Curve[idx], 255) * yScale;
+			break;
+		}
+		default:
+			break;
+		}
+		ly[i] = cv::saturate_cast<uchar>(std::min(std::max(y, yLo), yMax));
+		lc[i] = cv::saturate_cast<uchar>(std::min(std::max(c, cMin), cMax));
+	}
+}
+
+bool CvTranslator::applyEffectYUV(AVFrame* frame, func fun)
+{
+	if (!frame || !supportsYUV(fun) || frame->format != AV_PIX_FMT_YUV420P ||
+		frame->width <= 0 || frame->height <= 0) {
+		return false;
+	}
+
+	// 直接包装frame各平面，不做拷贝
+	const int cw = (frame->width + 1) / 2;
+	const int ch = (frame->height + 1) / 2;
+	cv::Mat y(frame->height, frame->width, CV_8UC1, frame->data[0], frame->linesize[0]);
+	cv::Mat u(ch, cw, CV_8UC1, frame->data[1], frame->linesize[1]);
+	cv::Mat v(ch, cw, CV_8UC1, frame->data[2], frame->linesize[2]);
+
+	if (fun == ::grayImage) {
+		// 亮度即灰度，去掉色度即可
+		u.setTo(cv::Scalar(128));
+		v.setTo(cv::Scalar(128));
+		return true;
+	}
+
+	// 表只取决于特效和色彩范围，首次使用时生成全部组合，之后逐帧只查表
+	struct YuvLutSet {
+		cv::Mat y[3][2];
+		cv::Mat uv[3][2];
+	};
+	static const YuvLutSet luts = []() {
+		YuvLutSet set;
+		const func funs[3] = { ::invertImage, ::Whitening, ::Whitening2 };
+		for (int f = 0; f < 3; ++f) {
+			for (int r = 0; r < 2; ++r) {
+				buildYuvLuts(funs[f], r == 1, set.y[f][r], set.uv[f][r]);
+			}
+		}
+		return set;
+	}();
+	const int f = fun == ::invertImage ? 0 : (fun == ::Whitening ? 1 : 2);
+	const int r = frame->color_range == AVCOL_RANGE_JPEG ? 1 : 0;
+	const cv::Mat& lutY = luts.y[f][r];
+	const cv::Mat& lutUV = luts.uv[f][r];
+	cv::LUT(y, lutY, y);
+	if (fun != ::Whitening2) {
+		cv::LUT(u, lutUV, u);
+		cv::LUT(v, lutUV, v);
+	}
+	return true;
+}
+
 // -------------------- CvTranslator C API --------------------
 static bool cvtranslator_imread(const char* path, cv::Mat& out)
 {
@@ -337,6 +639,220 @@ extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_FrostedGlass_File(void* trans
 	}
 }
 
+// ---- 毛玻璃自检：固定种子的参考校验和 + 与原串行实现的耗时对比
+
+// 自检输入：testPattern生成的320x240确定性图案，种子固定；校验和为输出字节的FNV-1a 64
+static const unsigned int kFrostedGlassSeed = 20261017u;
+static const uint64_t kFrostedGlassChecksum = 0xA1528E62B55229E9ULL;
+
+static cv::Mat testPattern(int width, int height)
+{
+	cv::Mat img(height, width, CV_8UC3);
+	for (int i = 0; i < height; i++) {
+		uchar* row = img.ptr<uchar>(i);
+		for (int j = 0; j < width; j++) {
+			for (int c = 0; c < 3; c++) {
+				row[j * 3 + c] = static_cast<uchar>((i * 7 + j * 13 + c * 29 + ((i * j) >> 3)) & 255);
+			}
+		}
+	}
+	return img;
+}
+
+static uint64_t matChecksum(const cv::Mat& m)
+{
+	uint64_t h = 1469598103934665603ULL;
+	const size_t rowBytes = m.cols * m.elemSize();
+	for (int i = 0; i < m.rows; i++) {
+		const uchar* row = m.ptr<uchar>(i);
+		for (size_t k = 0; k < rowBytes; k++) {
+			h ^= row[k];
+			h *= 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+// 改写前的实现（逐像素at<>、共享的串行cv::RNG），只作为耗时基准
+static cv::Mat frostedGlassSerial(const cv::Mat& imageSource)
+{
+	cv::Mat imageResult = imageSource.clone();
+	cv::RNG rng;
+	const int Number = 5;
+	for (int i = 0; i < imageSource.rows - Number; i++) {
+		for (int j = 0; j < imageSource.cols - Number; j++) {
+			int randomNum = rng.uniform(0, Number);
+			imageResult.at<cv::Vec3b>(i, j) = imageSource.at<cv::Vec3b>(i + randomNum, j + randomNum);
+		}
+	}
+	return imageResult;
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_FrostedGlass_SelfTest(void* translator, double* before_ms, double* after_ms)
+{
+	try {
+		if (!translator) return false;
+		CvTranslator* t = static_cast<CvTranslator*>(translator);
+
+		// 逐像素一致：固定种子的输出与存档的校验和比对
+		uint64_t sum = matChecksum(t->FrostedGlass(testPattern(320, 240), kFrostedGlassSeed));
+		bool ok = sum == kFrostedGlassChecksum;
+		if (!ok) {
+			std::cerr << "FrostedGlass self test fair: checksum " << std::hex << sum
+				<< " expected " << kFrostedGlassChecksum << std::dec << std::endl;
+		}
+
+		// 1080p各跑3次取最快
+		cv::Mat src = testPattern(1920, 1080);
+		auto bestOf = [&](const std::function<cv::Mat()>& run) {
+			double best = 0;
+			for (int k = 0; k < 3; k++) {
+				auto begin = std::chrono::steady_clock::now();
+				run();
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+				best = k == 0 ? ms : std::min(best, ms);
+			}
+			return best;
+		};
+		double before = bestOf([&]() { return frostedGlassSerial(src); });
+		double after = bestOf([&]() { return t->FrostedGlass(src, kFrostedGlassSeed); });
+		std::cout << "FrostedGlass 1920x1080 | before:" << before << "ms | after:" << after << "ms | speedup:"
+			<< (after > 0 ? before / after : 0.0) << "x | checksum:" << (ok ? "ok" : "fair") << std::endl;
+		if (before_ms) *before_ms = before;
+		if (after_ms) *after_ms = after;
+		return ok;
+	}
+	catch (...) {
+		return false;
+	}
+}
+
+// YUV直通与BGR路径对比：同一合成帧分别走 YUV->BGR->特效->YUV 和 applyEffectYUV，各跑frames次得到fps；
+// 两条路径的输出都转回BGR，以BGR路径为参考计算YUV路径的PSNR（美白/美白2只是近似）
+extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_BenchmarkYUV(void* translator, int effect_type, int width, int height,
+	int frames, double* bgr_fps, double* yuv_fps, double* psnr)
+{
+	AVFrame* work = nullptr;
+	try {
+		func fun = static_cast<func>(effect_type);
+		if (!translator || width <= 0 || height <= 0 || width % 2 != 0 || height % 2 != 0 || !CvTranslator::supportsYUV(fun)) {
+			return false;
+		}
+		if (frames <= 0) frames = 100;
+		CvTranslator* t = static_cast<CvTranslator*>(translator);
+		COpenCVTools tools;
+
+		cv::Mat pattern = testPattern(width, height);
+		AVFrame* src = tools.CVMatToAVFrame(pattern);
+		work = av_frame_alloc();
+		if (!src || !work) {
+			tools.recycleFrame(src);
+			av_frame_free(&work);
+			return false;
+		}
+		work->format = src->format;
+		work->width = width;
+		work->height = height;
+		if (av_frame_get_buffer(work, 32) < 0) {
+			tools.recycleFrame(src);
+			av_frame_free(&work);
+			return false;
+		}
+
+		const param p = param();
+		cv::Mat mat, reference;
+		auto begin = std::chrono::steady_clock::now();
+		for (int k = 0; k < frames; ++k) {
+			tools.AVFrameToCVMat(src, mat);
+			cv::Mat out = EffectChain::applyStage(*t, fun, p, mat);
+			AVFrame* encoded = tools.CVMatToAVFrame(out);
+			if (k == 0 && encoded) {
+				tools.AVFrameToCVMat(encoded, reference);
+				reference = reference.clone();
+			}
+			tools.recycleFrame(encoded);
+		}
+		double bgrSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		// YUV路径每次从源帧复制一份再原地处理，复制计入耗时
+		begin = std::chrono::steady_clock::now();
+		for (int k = 0; k < frames; ++k) {
+			av_frame_copy(work, src);
+			t->applyEffectYUV(work, fun);
+		}
+		double yuvSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		cv::Mat yuvResult;
+		tools.AVFrameToCVMat(work, yuvResult);
+		double quality = reference.empty() ? 0.0 : cv::PSNR(reference, yuvResult);
+		double bgr = bgrSeconds > 0 ? frames / bgrSeconds : 0.0;
+		double yuv = yuvSeconds > 0 ? frames / yuvSeconds : 0.0;
+		std::cout << "BenchmarkYUV effect:" << effect_type << " " << width << "x" << height << " frames:" << frames
+			<< " | bgr:" << bgr << "fps | yuv:" << yuv << "fps | speedup:" << (bgr > 0 ? yuv / bgr : 0.0)
+			<< "x | psnr:" << quality << "dB" << std::endl;
+		if (bgr_fps) *bgr_fps = bgr;
+		if (yuv_fps) *yuv_fps = yuv;
+		if (psnr) *psnr = quality;
+
+		tools.recycleFrame(src);
+		av_frame_free(&work);
+		return true;
+	}
+	catch (...) {
+		av_frame_free(&work);
+		return false;
+	}
+}
+
+// 磨皮快速模式与原图双边滤波对比：各跑runs次取平均耗时，以原图双边滤波为参考计算快速模式的PSNR
+extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_BenchmarkSkinSmoothing(void* translator, const char* image_path, int runs,
+	double* exact_ms, double* fast_ms, double* psnr)
+{
+	try {
+		if (!translator) return false;
+		CvTranslator* t = static_cast<CvTranslator*>(translator);
+		cv::Mat image;
+		if (image_path && *image_path) {
+			if (!cvtranslator_imread(image_path, image)) return false;
+		}
+		if (runs <= 0) runs = 5;
+
+		// 720p / 1080p / 4K 各一行；给了图片时缩放到各尺寸，否则用同一合成图案
+		static const cv::Size sizes[] = { cv::Size(1280, 720), cv::Size(1920, 1080), cv::Size(3840, 2160) };
+		for (int i = 0; i < 3; ++i) {
+			cv::Mat src;
+			if (image.empty()) {
+				src = testPattern(sizes[i].width, sizes[i].height);
+			}
+			else {
+				cv::resize(image, src, sizes[i], 0, 0, sizes[i].area() < image.size().area() ? cv::INTER_AREA : cv::INTER_LINEAR);
+			}
+
+			auto average = [&](int mode, cv::Mat& result) {
+				auto begin = std::chrono::steady_clock::now();
+				for (int k = 0; k < runs; ++k) {
+					result = t->simpleSkinSmoothing(src, mode);
+				}
+				return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / runs;
+			};
+			cv::Mat exact, fast;
+			double exactMs = average(0, exact);
+			double fastMs = average(1, fast);
+			double quality = cv::PSNR(exact, fast);
+			std::cout << "BenchmarkSkinSmoothing " << src.cols << "x" << src.rows << " runs:" << runs
+				<< " | exact:" << exactMs << "ms | fast:" << fastMs << "ms | speedup:" << (fastMs > 0 ? exactMs / fastMs : 0.0)
+				<< "x | psnr:" << quality << "dB" << std::endl;
+			if (exact_ms) exact_ms[i] = exactMs;
+			if (fast_ms) fast_ms[i] = fastMs;
+			if (psnr) psnr[i] = quality;
+		}
+		return true;
+	}
+	catch (...) {
+		return false;
+	}
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_SkinSmoothing_File(void* translator, const char* input_path, const char* output_path)
 {
 	try {
@@ -409,6 +925,40 @@ extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_Mosaic_File(void* translator,
 	}
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_ApplyLut_File(void* translator, const char* input_path, const char* output_path, const unsigned char* lut)
+{
+	try {
+		if (!translator || !lut) return false;
+		cv::Mat img;
+		if (!cvtranslator_imread(input_path, img)) return false;
+		cv::Mat table(1, 256, CV_8UC1, const_cast<unsigned char*>(lut));
+		if (!static_cast<CvTranslator*>(translator)->applyLutInPlace(img, table)) return false;
+		return cvtranslator_imwrite(output_path, img);
+	}
+	catch (...) {
+		return false;
+	}
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_MosaicRegions_File(void* translator, const char* input_path, const char* output_path, const int* rects, int count, int cellSize)
+{
+	try {
+		if (!translator || !rects || count <= 0) return false;
+		if (cellSize <= 0) return false;
+		cv::Mat img;
+		if (!cvtranslator_imread(input_path, img)) return false;
+		std::vector<cv::Rect> regions;
+		for (int i = 0; i < count; ++i) {
+			regions.push_back(cv::Rect(rects[i * 4], rects[i * 4 + 1], rects[i * 4 + 2], rects[i * 4 + 3]));
+		}
+		static_cast<CvTranslator*>(translator)->applyMosaicRegions(img, regions, cellSize);
+		return cvtranslator_imwrite(output_path, img);
+	}
+	catch (...) {
+		return false;
+	}
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API bool CvTranslator_AddTextWatermark_File(void* translator, const char* input_path, const char* output_path, const char* text)
 {
 	try {
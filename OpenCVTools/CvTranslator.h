@@ -19,6 +19,7 @@
 
 #include "OpenCVFFMpegTools.h"
 
+struct AVFrame;
 
 class OPENCVFFMPEGTOOLS_API CvTranslator
 {
@@ -56,13 +57,31 @@ public:
 	* @return 目标mat
 	*/
 	cv::Mat applyMosaic(const cv::Mat &src, const cv::Rect &mosaicRegion, int cellSize);
+	/**
+	 * @brief 多区域马赛克，原地修改，每块填充块内像素均值.
+	 *
+	 * 区域互不重叠时并行处理，超出图像的部分自动裁剪
+	 * @param img 8位图像，直接在其上修改
+	 * @param regions 区域列表
+	 * @param cellSize 马赛克块的大小
+	 */
+	void applyMosaicRegions(cv::Mat &img, const std::vector<cv::Rect> &regions, int cellSize);
+	/**
+	 * @brief 解析区域列表文本 "x,y,w,h;x,y,w,h;...".
+	 *
+	 * \param text
+	 * \return 遇到格式错误时返回已解析的部分
+	 */
+	static std::vector<cv::Rect> parseRegions(const char* text);
 	/**
 	 * .
 	 * 
 	 * \param imageSource 源文件
+	 * \param seed 随机种子，相同种子输出逐像素一致（与线程数无关）
+	 * \param origin imageSource左上角在整图中的坐标，分块处理时用整图坐标取随机数
  	 * \return 毛玻璃效果的mat 
 	 */
-	cv::Mat FrostedGlass(const cv::Mat &imageSource);
+	cv::Mat FrostedGlass(const cv::Mat &imageSource, unsigned int seed = 0, const cv::Point& origin = cv::Point(0, 0));
 	/**
 	 * @brief. 文字水印
 	 * 
@@ -77,9 +96,13 @@ public:
 	 * @brief 磨皮.
 	 * 
 	 * \param inputImage
+	 * \param mode 0为原图双边滤波；1为快速模式（缩小滤波后放大并回叠细节），1080p约快一个数量级
+	 * \param fullSize 分块处理时的整图尺寸，快速模式按它确定缩放比例；为空时取inputImage尺寸
 	 * \return 
 	 */
-	cv::Mat simpleSkinSmoothing(const cv::Mat& inputImage);
+	cv::Mat simpleSkinSmoothing(const cv::Mat& inputImage, int mode = 0, const cv::Size& fullSize = cv::Size());
+	// 快速磨皮的缩放比例：短边缩到360左右，不小于1/4
+	static double skinSmoothingScale(const cv::Size& fullSize);
 	/**
 	 * @brief 美白.
 	 * 
@@ -94,6 +117,27 @@ public:
 	 * \return
 	 */
 	cv::Mat Whitening2(const cv::Mat &src);
+	/**
+	 * @brief 查表变换（色调曲线、gamma等），美白/美白2也走这里.
+	 *
+	 * \param src 8位图像
+	 * \param lut 256项CV_8U表，单通道表作用于所有通道，或与src通道数相同
+	 * \return 参数不合法时返回空Mat
+	 */
+	cv::Mat applyLut(const cv::Mat& src, const cv::Mat& lut);
+	/**
+	 * @brief 原地查表，省去输出分配.
+	 *
+	 * \return 参数不合法时返回false
+	 */
+	bool applyLutInPlace(cv::Mat& img, const cv::Mat& lut);
+	/**
+	 * @brief 生成gamma校正表 out = 255 * (in/255)^(1/gamma).
+	 *
+	 * \param gamma 大于1提亮，小于1压暗
+	 * \return 1x256 CV_8UC1
+	 */
+	static cv::Mat gammaLut(double gamma);
 	/**
 	 * @brief 水印.
 	 * 
@@ -119,5 +163,27 @@ public:
 	 * \return 
 	 */
 	cv::Mat invertImage(cv::Mat src);
+	/**
+	 * @brief 该特效能否直接在YUV平面上处理（灰度/反色/美白/美白2）.
+	 * 
+	 * \param fun
+	 * \return 
+	 */
+	static bool supportsYUV(func fun);
+	/**
+	 * @brief 在YUV420P帧上原地处理，省去YUV->BGR->YUV两次转换.
+	 * 
+	 * 灰度只保留Y并把UV置128；反色/美白按平面查表；美白2的曲线只作用于亮度。
+	 * 灰度/反色与BGR路径等价（只差舍入）；美白/美白2只是近似：BGR路径在各通道上分别偏移、截断和走曲线，
+	 * 饱和色与高光处与BGR结果有偏差，可用CvTranslator_BenchmarkYUV查看PSNR
+	 * \param frame 可写的YUV420P帧
+	 * \param fun
+	 * \return 不支持的特效或格式返回false，frame不变
+	 */
+	bool applyEffectYUV(AVFrame* frame, func fun);
+
+private:
+	static bool isValidLut(const cv::Mat& lut, int channels);
+	cv::Mat fastSkinSmoothing(const cv::Mat& src, int d, double sigmaColor, double sigmaSpace, double scale);
 };
 
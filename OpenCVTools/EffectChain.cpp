@@ -0,0 +1,378 @@
+#include "pch.h"
+#include "EffectChain.h"
+#include "CvTranslator.h"
+#include <algorithm>
+
+EffectChain::EffectChain()
+{
+}
+
+EffectChain::EffectChain(const EffectChain& other)
+	: m_stages(other.m_stages)
+	, m_funcs(other.m_funcs)
+	, m_time(other.m_time)
+{
+}
+
+EffectChain& EffectChain::operator=(const EffectChain& other)
+{
+	if (this != &other) {
+		m_stages = other.m_stages;
+		m_funcs = other.m_funcs;
+		m_time = other.m_time;
+		m_lutBuf.release();
+	}
+	return *this;
+}
+
+bool EffectChain::isPointOp(func fun)
+{
+	switch (fun) {
+	case invertImage:
+	case Whitening:
+	case Whitening2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+cv::Mat EffectChain::buildLut(func fun, const param& p)
+{
+	// 三个通道取同一灰阶，这几个特效对各通道的变换相同，取第0通道即可
+	cv::Mat ramp(1, 256, CV_8UC3);
+	cv::Vec3b* row = ramp.ptr<cv::Vec3b>(0);
+	for (int i = 0; i < 256; ++i) {
+		row[i] = cv::Vec3b((uchar)i, (uchar)i, (uchar)i);
+	}
+
+	CvTranslator translator;
+	cv::Mat mapped = applyStage(translator, fun, p, ramp);
+
+	cv::Mat lut(1, 256, CV_8UC1);
+	const cv::Vec3b* src = mapped.ptr<cv::Vec3b>(0);
+	uchar* dst = lut.ptr<uchar>(0);
+	for (int i = 0; i < 256; ++i) {
+		dst[i] = src[i][0];
+	}
+	return lut;
+}
+
+void EffectChain::add(func fun, const param& p)
+{
+	m_funcs.push_back(fun);
+
+	if (fun == addTextWatermark) {
+		// 文字和位置对整段视频不变，只栅格化一次，逐帧只混合文字覆盖的区域
+		std::shared_ptr<WatermarkEngine> engine = std::make_shared<WatermarkEngine>();
+		int id = engine->addText(p.arr);
+		if (id >= 0) {
+			engine->setPosition(id, p.iparam1, p.iparam2);
+		}
+		Stage stage = { fun, p, cv::Mat(), engine };
+		m_stages.push_back(stage);
+		return;
+	}
+
+	if (!isPointOp(fun)) {
+		Stage stage = { fun, p, cv::Mat() };
+		m_stages.push_back(stage);
+		return;
+	}
+
+	pushLut(fun, p, buildLut(fun, p));
+}
+
+void EffectChain::addLut(const cv::Mat& lut)
+{
+	if (lut.total() != 256 || lut.type() != CV_8UC1) {
+		return;
+	}
+	// 记为noAction，使supportsYUV()为假：自定义表定义在BGR上，不能直接套到YUV平面
+	m_funcs.push_back(noAction);
+	param p;
+	memset(&p, 0, sizeof(p));
+	pushLut(noAction, p, lut.clone().reshape(1, 1));
+}
+
+void EffectChain::addWatermark(const WatermarkEngine& engine)
+{
+	// 记为文字水印：不能走YUV直通
+	m_funcs.push_back(addTextWatermark);
+	param p;
+	memset(&p, 0, sizeof(p));
+	Stage stage = { addTextWatermark, p, cv::Mat(), std::make_shared<WatermarkEngine>(engine) };
+	m_stages.push_back(stage);
+}
+
+void EffectChain::pushLut(func fun, const param& p, const cv::Mat& lut)
+{
+	if (!m_stages.empty() && !m_stages.back().lut.empty()) {
+		// 与前一个查表阶段合并：merged[i] = lut[prev[i]]；写到新Mat，避免改到拷贝共享的数据
+		cv::Mat& prev = m_stages.back().lut;
+		cv::Mat merged(1, 256, CV_8UC1);
+		const uchar* pp = prev.ptr<uchar>(0);
+		const uchar* lp = lut.ptr<uchar>(0);
+		uchar* mp = merged.ptr<uchar>(0);
+		for (int i = 0; i < 256; ++i) {
+			mp[i] = lp[pp[i]];
+		}
+		prev = merged;
+		return;
+	}
+
+	Stage stage = { fun, p, lut };
+	m_stages.push_back(stage);
+}
+
+void EffectChain::clear()
+{
+	m_stages.clear();
+	m_funcs.clear();
+}
+
+size_t EffectChain::size() const
+{
+	return m_funcs.size();
+}
+
+bool EffectChain::empty() const
+{
+	return m_funcs.empty();
+}
+
+bool EffectChain::supportsYUV() const
+{
+	if (m_funcs.empty()) {
+		return false;
+	}
+	for (func fun : m_funcs) {
+		if (!CvTranslator::supportsYUV(fun)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool EffectChain::applyYUV(CvTranslator& translator, AVFrame* frame) const
+{
+	if (!supportsYUV()) {
+		return false;
+	}
+	// YUV下每个特效本身就是平面查表，逐个执行即可
+	for (func fun : m_funcs) {
+		if (!translator.applyEffectYUV(frame, fun)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+cv::Mat EffectChain::apply(CvTranslator& translator, const cv::Mat& src)
+{
+	return run(translator, src, cv::Point(0, 0), cv::Size(), false);
+}
+
+cv::Mat EffectChain::applyInPlace(CvTranslator& translator, cv::Mat& frame)
+{
+	return run(translator, frame, cv::Point(0, 0), cv::Size(), true);
+}
+
+cv::Mat EffectChain::applyTile(CvTranslator& translator, const cv::Mat& tile, const cv::Point& origin,
+	const cv::Size& fullSize)
+{
+	return run(translator, tile, origin, fullSize, false);
+}
+
+cv::Mat EffectChain::run(CvTranslator& translator, const cv::Mat& tile, const cv::Point& origin,
+	const cv::Size& fullSize, bool writable)
+{
+	cv::Mat cur = tile;
+	for (const Stage& stage : m_stages) {
+		// 水印和区域马赛克原地改写；cur仍是调用方的数据（可能是解码器的帧缓冲）时先复制一次
+		const bool inPlace = stage.watermark || (stage.lut.empty() && stage.fun == applyMosaicRegions);
+		if (inPlace && !writable && cur.datastart == tile.datastart) {
+			cur = tile.clone();
+		}
+		if (!stage.lut.empty()) {
+			// 单通道LUT对任意通道数适用；cur指向m_lutBuf时为原地查表
+			cv::LUT(cur, stage.lut, m_lutBuf);
+			cur = m_lutBuf;
+		}
+		else if (stage.watermark) {
+			// 原地混合；灰度等单通道结果先转回BGR
+			if (cur.type() != CV_8UC3) {
+				cv::Mat bgr;
+				cv::cvtColor(cur, bgr, cur.channels() == 1 ? cv::COLOR_GRAY2BGR : cv::COLOR_BGRA2BGR);
+				cur = bgr;
+			}
+			stage.watermark->apply(cur, m_time, origin, fullSize);
+		}
+		else {
+			cur = applyStage(translator, stage.fun, stage.p, cur, origin, fullSize);
+		}
+		if (cur.empty()) {
+			break;
+		}
+	}
+	return cur;
+}
+
+int EffectChain::haloRadius() const
+{
+	int halo = 0;
+	for (const Stage& stage : m_stages) {
+		if (stage.lut.empty()) {
+			halo += stageHalo(stage.fun, stage.p);
+		}
+	}
+	// 油画先缩小一半再放大，块起点取偶数才能与整图的采样网格对齐
+	return (halo + 1) & ~1;
+}
+
+int EffectChain::stageHalo(func fun, const param& p)
+{
+	switch (fun) {
+		case FrostedGlass:
+			return 5; // 从右下方[0,5)的偏移处取样
+		case simpleSkinSmoothing:
+			// 双边滤波d=15，原图上半径8；快速模式另有缩放核（最小1/4，原图上约8像素），
+			// 且块与整图的缩放网格不对齐，取32留余量使接缝不可见
+			return p.iparam1 == 1 ? 32 : 8;
+		case customOilPaintApprox:
+		case applyOilPainting:
+			return 16; // 半分辨率d=9的双边滤波 + 三次插值 + 3x3锐化
+		case applyMosaic:
+		case applyMosaicRegions:
+			return std::max(0, p.iparam5); // 覆盖到块边的马赛克格要完整取到
+		default:
+			return 0;
+	}
+}
+
+// 把整图坐标的马赛克区域换算到块内：与块相交的部分向外扩到所在格子的边界，
+// 使块内每个格子的均值取自完整的格子，与整图处理一致
+static std::vector<cv::Rect> mosaicRegionsInTile(const std::vector<cv::Rect>& regions, const cv::Point& origin,
+	const cv::Size& size, int cellSize)
+{
+	std::vector<cv::Rect> local;
+	const cv::Rect tileRect(origin, size);
+	for (const cv::Rect& r : regions) {
+		cv::Rect hit = r & tileRect;
+		if (hit.empty()) {
+			continue;
+		}
+		int x1 = r.x + (hit.x - r.x) / cellSize * cellSize;
+		int y1 = r.y + (hit.y - r.y) / cellSize * cellSize;
+		int x2 = std::min(r.x + r.width, r.x + (hit.x + hit.width - r.x + cellSize - 1) / cellSize * cellSize);
+		int y2 = std::min(r.y + r.height, r.y + (hit.y + hit.height - r.y + cellSize - 1) / cellSize * cellSize);
+		local.push_back(cv::Rect(x1 - origin.x, y1 - origin.y, x2 - x1, y2 - y1));
+	}
+	return local;
+}
+
+cv::Mat EffectChain::applyStage(CvTranslator& translator, func fun, const param& mParem, const cv::Mat& mat)
+{
+	return applyStage(translator, fun, mParem, mat, cv::Point(0, 0));
+}
+
+// 根据func参数对单帧应用图像处理
+cv::Mat EffectChain::applyStage(CvTranslator& translator, func fun, const param& mParem, const cv::Mat& mat, const cv::Point& origin,
+	const cv::Size& fullSize)
+{
+	const bool tiled = origin != cv::Point(0, 0);
+	switch (fun) {
+		case grayImage:
+			return translator.grayImage(mat);
+
+		case customOilPaintApprox:
+			return translator.customOilPaintApprox(mat, mParem.iparam1, mParem.dparam1);
+
+		case applyOilPainting:
+			return translator.applyOilPainting(mat, mParem.iparam1, mParem.dparam1);
+
+		case applyMosaic:
+			{
+				cv::Rect mosaicRegion(mParem.iparam1, mParem.iparam2, mParem.iparam3, mParem.iparam4); // 示例区域
+				if (tiled && mParem.iparam5 > 0) {
+					cv::Mat dst = mat.clone();
+					translator.applyMosaicRegions(dst, mosaicRegionsInTile(std::vector<cv::Rect>(1, mosaicRegion),
+						origin, mat.size(), mParem.iparam5), mParem.iparam5);
+					return dst;
+				}
+				return translator.applyMosaic(mat, mosaicRegion, mParem.iparam5);
+			}
+
+		case FrostedGlass:
+			return translator.FrostedGlass(mat, static_cast<unsigned int>(mParem.iparam1), origin); // iparam1为随机种子
+
+		case simpleSkinSmoothing:
+			return translator.simpleSkinSmoothing(mat, mParem.iparam1, fullSize); // iparam1=1为快速模式
+
+		case Whitening:
+			return translator.Whitening(mat);
+
+		case Whitening2:
+			return translator.Whitening2(mat);
+
+		case addTextWatermark:
+			return translator.addTextWatermark(mat, mParem.arr, cv::Point(mParem.iparam1, mParem.iparam2) - origin);
+
+		case invertImage:
+			return translator.invertImage(mat);
+
+		case applyMosaicRegions:
+			{
+				// 经applyTile/apply调用时mat已保证可写，直接原地打码，省去整帧clone
+				cv::Mat dst = mat;
+				std::vector<cv::Rect> regions = CvTranslator::parseRegions(mParem.arr);
+				if (tiled && mParem.iparam5 > 0) {
+					regions = mosaicRegionsInTile(regions, origin, mat.size(), mParem.iparam5);
+				}
+				translator.applyMosaicRegions(dst, regions, mParem.iparam5);
+				return dst;
+			}
+
+		default:
+			return mat.clone(); // 不处理，直接复制
+	}
+}
+
+// -------------------- EffectChain C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API void* EffectChain_Create()
+{
+	return new EffectChain();
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void EffectChain_Destroy(void* chain)
+{
+	delete static_cast<EffectChain*>(chain);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int EffectChain_Add(void* chain, int effect_type, param m)
+{
+	if (!chain) return -1;
+	static_cast<EffectChain*>(chain)->add(static_cast<func>(effect_type), m);
+	return static_cast<int>(static_cast<EffectChain*>(chain)->size());
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int EffectChain_AddLut(void* chain, const unsigned char* lut)
+{
+	if (!chain || !lut) return -1;
+	cv::Mat table(1, 256, CV_8UC1, const_cast<unsigned char*>(lut));
+	static_cast<EffectChain*>(chain)->addLut(table);
+	return static_cast<int>(static_cast<EffectChain*>(chain)->size());
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int EffectChain_AddWatermark(void* chain, void* watermark)
+{
+	if (!chain || !watermark) return -1;
+	static_cast<EffectChain*>(chain)->addWatermark(*static_cast<WatermarkEngine*>(watermark));
+	return static_cast<int>(static_cast<EffectChain*>(chain)->size());
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void EffectChain_Clear(void* chain)
+{
+	if (!chain) return;
+	static_cast<EffectChain*>(chain)->clear();
+}
@@ -0,0 +1,132 @@
+/*****************************************************************//**
+ * \file   EffectChain.h
+ * \brief  特效链：一次解码/编码内按顺序执行多个特效
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+
+#include "OpenCVFFMpegTools.h"
+#include "Watermark.h"
+
+struct AVFrame;
+class CvTranslator;
+
+class EffectChain
+{
+public:
+	EffectChain();
+	// 拷贝时不共享m_lutBuf，各线程的副本互不干扰
+	EffectChain(const EffectChain& other);
+	EffectChain& operator=(const EffectChain& other);
+
+	/**
+	 * @brief 在链尾追加一个特效.
+	 *
+	 * 相邻的逐像素查表类特效（反色/美白/美白2）会在追加时合并为一张LUT
+	 * \param fun 特效类型
+	 * \param p 特效参数，含义与单特效处理一致
+	 */
+	void add(func fun, const param& p);
+	/**
+	 * @brief 追加自定义查表阶段（色调曲线、gamma等）.
+	 *
+	 * \param lut 1x256 CV_8UC1，与相邻查表阶段合并
+	 */
+	void addLut(const cv::Mat& lut);
+	/**
+	 * @brief 追加水印阶段.
+	 *
+	 * 拷贝一份engine（小图只读共享），之后修改engine不影响已加入的阶段
+	 */
+	void addWatermark(const WatermarkEngine& engine);
+	// 当前帧的时间（秒），移动的水印按它计算位置；视频逐帧处理前设置
+	void setTime(double seconds) { m_time = seconds; }
+	void clear();
+	// 用户添加的特效个数（合并前）
+	size_t size() const;
+	bool empty() const;
+
+	// 链上每个特效都能直接在YUV平面上处理
+	bool supportsYUV() const;
+
+	/**
+	 * @brief 在YUV420P帧上原地执行整条链.
+	 *
+	 * \return 任一特效不支持时返回false，此时frame可能已被部分修改，仅在supportsYUV()为真时调用
+	 */
+	bool applyYUV(CvTranslator& translator, AVFrame* frame) const;
+
+	/**
+	 * @brief 对BGR图像执行整条链.
+	 *
+	 * 不改写src：原地处理的特效（水印、区域马赛克）第一次写入前复制一份；
+	 * 返回值可能引用内部缓冲，下次apply前有效。多线程时每个线程各持一份拷贝
+	 * \param translator
+	 * \param src
+	 * \return
+	 */
+	cv::Mat apply(CvTranslator& translator, const cv::Mat& src);
+	/**
+	 * @brief 同apply，但frame归调用方所有且可写，原地处理的特效直接改写它，省去整帧复制.
+	 *
+	 * 不要传入包装解码器/外部内存的Mat
+	 */
+	cv::Mat applyInPlace(CvTranslator& translator, cv::Mat& frame);
+
+	/**
+	 * @brief 对大图中的一块执行整条链.
+	 *
+	 * 与位置有关的特效（马赛克区域、水印坐标、毛玻璃的随机数）按origin换算到整图坐标，
+	 * 块四周留出haloRadius()的重叠时，各块拼起来与整图处理一致；
+	 * 快速磨皮按整图尺寸定缩放比例，但缩小图的采样网格随块起点变化，接缝附近只近似整图结果
+	 * \param tile 含重叠边的块
+	 * \param origin tile左上角在整图中的坐标
+	 * \param fullSize 整图尺寸，水印按右/下边缘定位和移动时需要，为空时取tile尺寸
+	 */
+	cv::Mat applyTile(CvTranslator& translator, const cv::Mat& tile, const cv::Point& origin,
+		const cv::Size& fullSize = cv::Size());
+
+	// 分块处理时每块四周需要的重叠像素数（各特效核半径之和，取偶数）
+	int haloRadius() const;
+
+	/**
+	 * @brief 单个特效.
+	 *
+	 * \return
+	 */
+	static cv::Mat applyStage(CvTranslator& translator, func fun, const param& p, const cv::Mat& mat);
+	// origin为mat左上角在整图中的坐标，fullSize为整图尺寸（为空时取mat尺寸）
+	static cv::Mat applyStage(CvTranslator& translator, func fun, const param& p, const cv::Mat& mat, const cv::Point& origin,
+		const cv::Size& fullSize = cv::Size());
+	// 单个特效读取的邻域半径，逐像素特效为0
+	static int stageHalo(func fun, const param& p);
+
+	// 是否为与通道无关的逐像素查表类特效
+	static bool isPointOp(func fun);
+
+private:
+	struct Stage {
+		func fun;
+		param p;
+		cv::Mat lut; // 非空时表示合并后的查表阶段（1x256 CV_8UC1）
+		std::shared_ptr<const WatermarkEngine> watermark; // 非空时表示水印阶段，原地混合
+	};
+
+	// writable为false时，原地处理的阶段遇到仍指向tile数据的输入先复制
+	cv::Mat run(CvTranslator& translator, const cv::Mat& tile, const cv::Point& origin,
+		const cv::Size& fullSize, bool writable);
+	// 用特效处理0~255的灰阶得到其LUT
+	static cv::Mat buildLut(func fun, const param& p);
+	// 追加查表阶段，能与上一个查表阶段合并则合并
+	void pushLut(func fun, const param& p, const cv::Mat& lut);
+
+	std::vector<Stage> m_stages;
+	std::vector<func> m_funcs; // 合并前的原始特效列表
+	cv::Mat m_lutBuf;          // 查表阶段的输出缓冲，跨帧复用
+	double m_time = 0;
+};
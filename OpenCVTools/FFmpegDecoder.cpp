@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "FFmpegDecoder.h"
+#include "MediaIndex.h"
 
 
 FFmpegDecoder::FFmpegDecoder()
@@ -10,6 +11,7 @@ FFmpegDecoder::FFmpegDecoder()
 
 FFmpegDecoder::~FFmpegDecoder()
 {
+	cancel_index();
 	if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
 	if (ctx->codec_ctx) avcodec_free_context(&ctx->codec_ctx);
 	if (ctx->fmt_ctx) avformat_close_input(&ctx->fmt_ctx);
@@ -28,6 +30,7 @@ int FFmpegDecoder::ffplayer_open(const std::string &inputPath, bool isDevice)
 
 	if (avformat_find_stream_info(ctx->fmt_ctx, nullptr) < 0) return -1;
 
+	ctx->video_stream_index = -1;
 	for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
 		if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
 			ctx->video_stream_index = i;
@@ -45,9 +48,86 @@ int FFmpegDecoder::ffplayer_open(const std::string &inputPath, bool isDevice)
 	if (avcodec_open2(ctx->codec_ctx, codec, nullptr) < 0) return -1;
 
 	ctx->frame = av_frame_alloc();
+
+	// 后台建立关键帧索引（MediaIndex按文件缓存，同一文件只扫描一次），建好前跳转走普通路径；
+	// 线程由close/析构取消并join，不会在解码器释放后继续读文件
+	if (!isDevice) {
+		cancel_index();
+		std::shared_ptr<KeyframeIndex> index = std::make_shared<KeyframeIndex>();
+		m_index = index;
+		m_index_abort = false;
+		m_index_thread = std::thread([this, index, path]() {
+			std::vector<double> times;
+			std::vector<int64_t> pos;
+			if (!MediaIndex::instance().getKeyframes(path, times, &pos, &m_index_abort)) {
+				if (!m_index_abort.load()) {
+					std::cerr << "[FFmpegDecoder] keyframe index build fair: " << path << std::endl;
+				}
+				return;
+			}
+			MediaIndex::instance().flush();
+			std::lock_guard<std::mutex> lock(index->mtx);
+			index->times.swap(times);
+			index->pos.swap(pos);
+			index->ready = true;
+		});
+	}
 	return 0;
 }
 
+void FFmpegDecoder::seek(int64_t timestamp_ms)
+{
+	std::lock_guard<std::mutex> lock(m_ctrl_mtx);
+	m_seek_target = timestamp_ms < 0 ? 0 : timestamp_ms;
+	m_seek_req = true;
+}
+
+void FFmpegDecoder::do_seek()
+{
+	AVStream* st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+	int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+	int64_t target_ts = start + av_rescale_q(m_seek_target, { 1, 1000 }, st->time_base);
+
+	bool done = false;
+	if (m_index) {
+		std::lock_guard<std::mutex> lock(m_index->mtx);
+		int k = m_index->ready ? MediaIndex::keyframeBefore(m_index->times, m_seek_target / 1000.0) : -1;
+		if (k >= 0) {
+			const AVInputFormat* ifmt = ctx->fmt_ctx->iformat;
+			int64_t pos = k < static_cast<int>(m_index->pos.size()) ? m_index->pos[k] : -1;
+			// TS/PS这类时间戳不连续、没有内建索引的格式按字节位置跳，其余按关键帧的准确时间戳跳
+			if (pos >= 0 && (ifmt->flags & AVFMT_TS_DISCONT) && !(ifmt->flags & AVFMT_NO_BYTE_SEEK)) {
+				done = av_seek_frame(ctx->fmt_ctx, ctx->video_stream_index, pos, AVSEEK_FLAG_BYTE) >= 0;
+			}
+			if (!done) {
+				int64_t key_ts = start + static_cast<int64_t>(llround(m_index->times[k] / av_q2d(st->time_base)));
+				done = av_seek_frame(ctx->fmt_ctx, ctx->video_stream_index, key_ts, AVSEEK_FLAG_BACKWARD) >= 0;
+			}
+		}
+	}
+	if (!done) {
+		done = av_seek_frame(ctx->fmt_ctx, ctx->video_stream_index, target_ts, AVSEEK_FLAG_BACKWARD) >= 0;
+	}
+	if (done) {
+		avcodec_flush_buffers(ctx->codec_ctx);
+		m_skip_until = target_ts;
+	}
+}
+
+bool FFmpegDecoder::drop_before_target()
+{
+	if (m_skip_until == AV_NOPTS_VALUE) {
+		return false;
+	}
+	int64_t pts = ctx->frame->best_effort_timestamp;
+	if (pts == AV_NOPTS_VALUE) pts = ctx->frame->pts;
+	if (pts != AV_NOPTS_VALUE && pts < m_skip_until) {
+		return true;
+	}
+	m_skip_until = AV_NOPTS_VALUE;
+	return false;
+}
+
 void FFmpegDecoder::ffplayer_read_frame()
 {
 	if (m_paused && !m_seek_req) {
@@ -57,10 +137,7 @@ void FFmpegDecoder::ffplayer_read_frame()
 	{
 		std::lock_guard<std::mutex> lock(m_ctrl_mtx);
 		if (m_seek_req) {
-			int64_t seek_target = av_rescale_q(m_seek_target * 1000, { 1, AV_TIME_BASE }, ctx->fmt_ctx->streams[ctx->video_stream_index]->time_base);
-			if (av_seek_frame(ctx->fmt_ctx, ctx->video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD) >= 0) {
-				avcodec_flush_buffers(ctx->codec_ctx);
-			}
+			do_seek();
 			m_seek_req = false;
 		}
 	}
@@ -75,6 +152,10 @@ void FFmpegDecoder::ffplayer_read_frame()
 		if (pkt.stream_index == ctx->video_stream_index) {
 			if (avcodec_send_packet(ctx->codec_ctx, &pkt) == 0) {
 				while (avcodec_receive_frame(ctx->codec_ctx, ctx->frame) == 0) {
+					// 跳转后到达目标之前的帧不做颜色转换
+					if (drop_before_target()) {
+						continue;
+					}
 
 					int dw = ctx->codec_ctx->width;
 					int dh = ctx->codec_ctx->height;
@@ -116,15 +197,38 @@ void FFmpegDecoder::ffplayer_read_frame()
 	}
 }
 
+int64_t FFmpegDecoder::getVideoStartTime() const
+{
+	if (!ctx || !ctx->fmt_ctx || ctx->video_stream_index < 0) {
+		return 0;
+	}
+	AVStream* st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+	if (st->start_time != AV_NOPTS_VALUE) {
+		return av_rescale_q(st->start_time, st->time_base, AV_TIME_BASE_Q);
+	}
+	return ctx->fmt_ctx->start_time != AV_NOPTS_VALUE ? ctx->fmt_ctx->start_time : 0;
+}
+
+int64_t FFmpegDecoder::getFrameTime(const AVFrame* frame) const
+{
+	if (!ctx || !ctx->fmt_ctx || ctx->video_stream_index < 0 || !frame) {
+		return AV_NOPTS_VALUE;
+	}
+	int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+	if (pts == AV_NOPTS_VALUE) {
+		return AV_NOPTS_VALUE;
+	}
+	AVStream* st = ctx->fmt_ctx->streams[ctx->video_stream_index];
+	int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+	return av_rescale_q(pts - start, st->time_base, AV_TIME_BASE_Q);
+}
+
 int FFmpegDecoder::read_frame_for_trans()
 {
 	{
 		std::lock_guard<std::mutex> lock(m_ctrl_mtx);
 		if (m_seek_req) {
-			int64_t seek_target = av_rescale_q(m_seek_target * 1000, { 1, AV_TIME_BASE }, ctx->fmt_ctx->streams[ctx->video_stream_index]->time_base);
-			if (av_seek_frame(ctx->fmt_ctx, ctx->video_stream_index, seek_target, AVSEEK_FLAG_BACKWARD) >= 0) {
-				avcodec_flush_buffers(ctx->codec_ctx);
-			}
+			do_seek();
 			m_seek_req = false;
 		}
 	}
@@ -135,6 +239,9 @@ int FFmpegDecoder::read_frame_for_trans()
 	pkt.size = 0;
 	while (av_read_frame(ctx->fmt_ctx, &pkt) >= 0) {
 		if (pkt.stream_index != ctx->video_stream_index) {
+			if (m_packet_sink) {
+				m_packet_sink(&pkt); // 音频/字幕直通到输出
+			}
 			av_packet_unref(&pkt);
 			continue; // 跳过非视频流
 		}
@@ -143,6 +250,9 @@ int FFmpegDecoder::read_frame_for_trans()
 		if (sendRet == 0) {
 			while (true) {
 				int ret = avcodec_receive_frame(ctx->codec_ctx, ctx->frame);
+				if (ret == 0 && drop_before_target()) {
+					continue;
+				}
 				if (ret == 0) {
 					av_packet_unref(&pkt);
 					return 1; // 成功读取到一帧
@@ -159,7 +269,7 @@ int FFmpegDecoder::read_frame_for_trans()
 
 		if (sendRet == AVERROR(EAGAIN)) {
 			int ret = avcodec_receive_frame(ctx->codec_ctx, ctx->frame);
-			if (ret == 0) {
+			if (ret == 0 && !drop_before_target()) {
 				av_packet_unref(&pkt);
 				return 1;
 			}
@@ -184,9 +294,30 @@ int FFmpegDecoder::read_frame_for_trans()
 	return 0; // EOF
 }
 
+// 关闭输入并释放解码器，之后可再次ffplayer_open（videoTrans::reset/initialize依赖这一点）
 void FFmpegDecoder::ffplayer_close()
 {
+	cancel_index();
+	m_index.reset();
+	if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
+	ctx->sws_ctx = nullptr;
+	if (ctx->codec_ctx) avcodec_free_context(&ctx->codec_ctx);
+	if (ctx->fmt_ctx) avformat_close_input(&ctx->fmt_ctx);
+	if (ctx->frame) av_frame_free(&ctx->frame);
+	ctx->video_stream_index = -1;
+	{
+		std::lock_guard<std::mutex> lock(m_ctrl_mtx);
+		m_seek_req = false;
+	}
+	m_skip_until = AV_NOPTS_VALUE;
+}
 
+void FFmpegDecoder::cancel_index()
+{
+	m_index_abort = true;
+	if (m_index_thread.joinable()) {
+		m_index_thread.join();
+	}
 }
 
 int64_t FFmpegDecoder::getDuration() const
@@ -234,6 +365,20 @@ int FFmpegDecoder::getFPS() const
 	return 30; // 默认帧率
 }
 
+AVRational FFmpegDecoder::getFrameRate() const
+{
+	if (ctx && ctx->fmt_ctx && ctx->video_stream_index >= 0) {
+		AVStream* video_stream = ctx->fmt_ctx->streams[ctx->video_stream_index];
+		if (video_stream) {
+			AVRational fps = av_guess_frame_rate(ctx->fmt_ctx, video_stream, nullptr);
+			if (fps.num > 0 && fps.den > 0) {
+				return fps;
+			}
+		}
+	}
+	return av_make_q(30, 1);
+}
+
 // C接口实现
 extern "C" OPENCVFFMPEGTOOLS_API void* Decoder_Create()
 {
@@ -266,6 +411,12 @@ extern "C" OPENCVFFMPEGTOOLS_API void Decoder_FFPlayerClose(void* decoder)
 	static_cast<FFmpegDecoder*>(decoder)->ffplayer_close();
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API void Decoder_Seek(void* decoder, int64_t timestamp_ms)
+{
+	if (!decoder) return;
+	static_cast<FFmpegDecoder*>(decoder)->seek(timestamp_ms);
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API int64_t Decoder_GetDuration(void* decoder)
 {
 	if (!decoder) return 0;
@@ -3,6 +3,8 @@
 
 #include "pch.h"
 #include "OpenCVFFMpegTools.h"
+#include <functional>
+#include <memory>
 
 
 
@@ -17,6 +19,8 @@ public:
 	void ffplayer_read_frame();
 	int read_frame_for_trans();
 	void ffplayer_close();
+	// 请求跳转到timestamp_ms，下一次读帧时生效
+	void seek(int64_t timestamp_ms);
 
 	SharedFrameBuffer* getSharedBuffer() { return &ctx->shared_buf; }
 	int64_t getDuration() const;
@@ -26,17 +30,47 @@ public:
 	int getWidth() const;
 	int getHeight() const;
 	int getFPS() const;
+	// 视频流帧率（有理数，29.97等非整数帧率不截断），未知时为30/1
+	AVRational getFrameRate() const;
 	AVCodecContext* getCodecContext() const { return ctx ? ctx->codec_ctx : nullptr; }
 	AVFrame* getCurrentAVFrame() const { return ctx ? ctx->frame : nullptr; }
+	AVFormatContext* getFormatContext() const { return ctx ? ctx->fmt_ctx : nullptr; }
+	// 视频流起始时间（AV_TIME_BASE单位），未知为0
+	int64_t getVideoStartTime() const;
+	// 帧时间（AV_TIME_BASE单位，相对视频流起始时间，与seek一致），无时间戳返回AV_NOPTS_VALUE
+	int64_t getFrameTime(const AVFrame* frame) const;
+
+	// read_frame_for_trans读到的非视频包交给sink（调用后包会被unref），不设置则丢弃
+	void setPacketSink(std::function<void(AVPacket*)> sink) { m_packet_sink = sink; }
 
 
 
 private:
+	// 关键帧索引，由后台线程m_index_thread填充
+	struct KeyframeIndex {
+		std::mutex mtx;
+		bool ready = false;
+		std::vector<double> times;  // 秒，相对视频流起始时间
+		std::vector<int64_t> pos;   // 字节位置，未知为-1
+	};
+
+	// 取消并等待后台索引线程，close/析构/重新打开前调用
+	void cancel_index();
+	// 在持有m_ctrl_mtx时执行跳转：有索引时定位到目标前的关键帧，否则按时间向前查找
+	void do_seek();
+	// 跳转后目标时间之前的帧只解码不输出，返回true表示当前帧应丢弃
+	bool drop_before_target();
+
 	FFPlayerContext *ctx;
 	bool m_paused = false;
 	bool m_seek_req = false;
 	int64_t m_seek_target = 0;
 	std::mutex m_ctrl_mtx;
+	std::shared_ptr<KeyframeIndex> m_index;
+	std::thread m_index_thread;
+	std::atomic<bool> m_index_abort{ false };
+	int64_t m_skip_until = AV_NOPTS_VALUE; // 视频流时间基
+	std::function<void(AVPacket*)> m_packet_sink;
 
 
 	int64_t m_frame_count = 0;
@@ -15,6 +15,7 @@ void FFmpegEncoder::video_muxer_set_defaults()
 	mCtx->fmt_ctx = nullptr;
 	mCtx->codec_ctx = nullptr;
 	mCtx->video_stream = nullptr;
+	mCtx->last_pts = -1;
 	mCtx->is_init = 0; // ʼΪδʼ״̬
 }
 
@@ -50,8 +51,9 @@ int FFmpegEncoder::video_muxer_init_codec()
 		return -1;
 	}
 	// ʱ֡
-	mCtx->video_stream->time_base = av_make_q(1, mCtx->fps);
-	mCtx->video_stream->r_frame_rate = av_make_q(mCtx->fps, 1);
+	mCtx->video_stream->time_base = av_inv_q(mCtx->frame_rate);
+	mCtx->video_stream->r_frame_rate = mCtx->frame_rate;
+	mCtx->video_stream->avg_frame_rate = mCtx->frame_rate;
 
 	// 
 	mCtx->codec_ctx = avcodec_alloc_context3(codec);
@@ -110,11 +112,24 @@ int FFmpegEncoder::video_muxer_init_codec()
 
 
 int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int height, int fps)
+{
+	return video_muxer_create(output_path, width, height, fps, nullptr, 0);
+}
+
+int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int height, int fps,
+	AVFormatContext *input, int64_t input_offset)
+{
+	return video_muxer_create(output_path, width, height, av_make_q(fps, 1), input, input_offset);
+}
+
+int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int height, AVRational frame_rate,
+	AVFormatContext *input, int64_t input_offset)
 {
 	
-	if (!output_path || width % 2 != 0 || height % 2 != 0 || fps <= 0)
+	if (!output_path || width % 2 != 0 || height % 2 != 0 || frame_rate.num <= 0 || frame_rate.den <= 0)
 	{
-		av_log(NULL, AV_LOG_ERROR, "Ƿ·Ϊ/ֱʷżǰ%dx%d/֡<=0ǰ%d\n", width, height, fps);
+		av_log(NULL, AV_LOG_ERROR, "Ƿ·Ϊ/ֱʷżǰ%dx%d/֡<=0ǰ%d/%d\n",
+			width, height, frame_rate.num, frame_rate.den);
 		std::cout << "!output_path || width % 2 != 0 || height % 2 != 0 illlegal param\n" << std::endl;
 		return -1; // intֵNULL
 	}
@@ -133,7 +148,8 @@ int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int he
 	mCtx->output_path = av_strdup(output_path); // ·ⲿָʧЧ
 	mCtx->width = width;
 	mCtx->height = height;
-	mCtx->fps = fps;
+	mCtx->frame_rate = frame_rate;
+	mCtx->fps = static_cast<int>(lround(av_q2d(frame_rate)));
 	video_muxer_set_defaults(); // mCtxѸֵɰȫ
 
 	int ret = -1;
@@ -159,6 +175,15 @@ int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int he
 		goto fail;
 	}
 
+	// Ƶ/Ļдļͷ֮ǰ
+	if (input)
+	{
+		mPassthrough.reset(new StreamPassthrough());
+		mPassthrough->addStreams(input, mCtx->fmt_ctx, input_offset);
+		av_log(NULL, AV_LOG_INFO, "Ƶ/Ļֱͨ%d·ر%d·\n",
+			mPassthrough->copiedStreams(), mPassthrough->transcodedStreams());
+	}
+
 	
 	if (!(mCtx->fmt_ctx->oformat->flags & AVFMT_NOFILE))
 	{
@@ -185,12 +210,13 @@ int FFmpegEncoder::video_muxer_create(const char *output_path, int width, int he
 
 	
 	mCtx->is_init = 1;
-	av_log(NULL, AV_LOG_INFO, "Ƶװʼɹ%s%dx%d%dfps%dMbps\n",
-		output_path, width, height, fps, mCtx->bit_rate / 1000000);
+	av_log(NULL, AV_LOG_INFO, "Ƶװʼɹ%s%dx%d%.3ffps%dMbps\n",
+		output_path, width, height, av_q2d(frame_rate), mCtx->bit_rate / 1000000);
 	return 0; // ͳһ0ʾɹ
 
 
 fail:
+	mPassthrough.reset();
 	if (mCtx)
 	{
 		if (mCtx->output_path) av_free((void *)mCtx->output_path);
@@ -230,8 +256,9 @@ int FFmpegEncoder::video_muxer_write_frame(AVFrame *frame, int frame_idx)
 	AVPacket pkt = { 0 };
 	char err_buf[64] = { 0 };
 
-	// ֡PTSʱ,ڱʱ 1/fpsֱ֡
+	// ֡PTSʱ,ڱʱ 1/֡ʣֱ֡
 	frame->pts = frame_idx;
+	mCtx->last_pts = frame_idx;
 	frame->pict_type = AV_PICTURE_TYPE_NONE; // ɱԶж֡ͣI/P֡
 
 	// ֡
@@ -264,8 +291,8 @@ int FFmpegEncoder::video_muxer_write_frame(AVFrame *frame, int frame_idx)
 		av_packet_rescale_ts(&pkt, mCtx->codec_ctx->time_base, mCtx->video_stream->time_base);
 		pkt.stream_index = mCtx->video_stream->index;
 
-		// дװ,av_interleaved_write_frameд룬ֺ֧չƵ
-		ret = av_interleaved_write_frame(mCtx->fmt_ctx, &pkt);
+		// дװ,av_interleaved_write_frameֱͨƵ/Ļdtsд
+		ret = video_muxer_write_packet(&pkt);
 		if (ret < 0)
 		{
 			av_strerror(ret, err_buf, sizeof(err_buf));
@@ -280,6 +307,61 @@ int FFmpegEncoder::video_muxer_write_frame(AVFrame *frame, int frame_idx)
 	return 0;
 }
 
+int FFmpegEncoder::video_muxer_write_frame_at(AVFrame *frame, int64_t time_us)
+{
+	if (!mCtx || !mCtx->is_init)
+	{
+		av_log(NULL, AV_LOG_ERROR, "д֡ʧܣδʼ\n");
+		return -1;
+	}
+	// ʱ任㵽ʱ֡ʲ㶨ʱȱʧʱ˳ӣ֤ptsϸ
+	int64_t pts = mCtx->last_pts + 1;
+	if (time_us != AV_NOPTS_VALUE)
+	{
+		int64_t t = av_rescale_q_rnd(time_us, AV_TIME_BASE_Q, mCtx->codec_ctx->time_base,
+			static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
+		if (t > mCtx->last_pts) pts = t;
+	}
+	if (pts > INT_MAX)
+	{
+		av_log(NULL, AV_LOG_ERROR, "д֡ʧܣptsΧ%lld\n", (long long)pts);
+		return -1;
+	}
+	return video_muxer_write_frame(frame, static_cast<int>(pts));
+}
+
+// ƵдװֱͨʱƵ/Ļд빲һ
+int FFmpegEncoder::video_muxer_write_packet(AVPacket *pkt)
+{
+	if (!mPassthrough)
+	{
+		return av_interleaved_write_frame(mCtx->fmt_ctx, pkt);
+	}
+	std::lock_guard<std::mutex> lock(mPassthrough->muxMutex());
+	return av_interleaved_write_frame(mCtx->fmt_ctx, pkt);
+}
+
+int FFmpegEncoder::video_muxer_write_input_packet(AVPacket *pkt)
+{
+	if (!mCtx || !mCtx->is_init || !pkt)
+	{
+		return -1;
+	}
+	if (!mPassthrough)
+	{
+		av_packet_unref(pkt);
+		return 0;
+	}
+	int ret = mPassthrough->write(pkt);
+	if (ret < 0)
+	{
+		char err_buf[64] = { 0 };
+		av_strerror(ret, err_buf, sizeof(err_buf));
+		av_log(NULL, AV_LOG_ERROR, "дֱͨʧܣ%s\n", err_buf);
+	}
+	return ret;
+}
+
 // ˢ±沢дļβ
 int FFmpegEncoder::video_muxer_flush()
 {
@@ -322,7 +404,7 @@ int FFmpegEncoder::video_muxer_flush()
 		av_packet_rescale_ts(&pkt, mCtx->codec_ctx->time_base, mCtx->video_stream->time_base);
 		pkt.stream_index = mCtx->video_stream->index;
 
-		ret = av_interleaved_write_frame(mCtx->fmt_ctx, &pkt);
+		ret = video_muxer_write_packet(&pkt);
 		if (ret < 0)
 		{
 			av_strerror(ret, err_buf, sizeof(err_buf));
@@ -334,7 +416,11 @@ int FFmpegEncoder::video_muxer_flush()
 		av_packet_unref(&pkt);
 	}
 
-	// дļβ
+	// ˢƵرдļβ
+	if (mPassthrough)
+	{
+		mPassthrough->flush();
+	}
 	av_write_trailer(mCtx->fmt_ctx);
 	av_log(NULL, AV_LOG_INFO, "Ƶװβɣļβд룺%s\n", mCtx->output_path);
 	return 0;
@@ -352,6 +438,7 @@ void FFmpegEncoder::video_muxer_destroy()
 		avcodec_free_context(&c->codec_ctx);
 		c->codec_ctx = nullptr;
 	}
+	mPassthrough.reset();
 	if (c->fmt_ctx)
 	{
 		if (!(c->fmt_ctx->oformat->flags & AVFMT_NOFILE))
@@ -1,10 +1,13 @@
 #pragma once  
 #include "pch.h"
 #include "OpenCVFFMpegTools.h"
+#include "StreamPassthrough.h"
+#include <memory>
 struct AVFormatContext;
 struct AVCodecContext;
 struct AVStream;
 struct AVFrame;
+struct AVPacket;
 
 // ƵװĽṹ
 typedef struct {
@@ -16,7 +19,9 @@ typedef struct {
 	const char      *output_path;// Ƶ·
 	int             width;       // Ƶȣż
 	int             height;      // Ƶ߶ȣż
-	int             fps;         // ֡
+	int             fps;         // ֡ʣȡ־
+	AVRational      frame_rate;  // ֡ʣʱȡ䵹
+	int64_t         last_pts;    // һ֡ptsʱ֤ϸ
 	int             bit_rate;    // ʣĬ4Mbps
 	int             gop_size;    // ؼ֡Ĭ25
 	// ״̬ʶ
@@ -29,7 +34,31 @@ public:
 	FFmpegEncoder();  
 	
 	int video_muxer_create(const char *output_path, int width, int height, int fps);
+	/**
+	 * @brief װinputеƵ/Ļֱͨ.
+	 *
+	 * \param input װΪʱֻƵ
+	 * \param input_offset ʱмȥAV_TIME_BASEλƵ֡Ŵ0ʱʱƵʼʱ
+	 * \return ɹ0
+	 */
+	int video_muxer_create(const char *output_path, int width, int height, int fps,
+		AVFormatContext *input, int64_t input_offset);
+	/**
+	 * @brief ͬϣ֡ȡ֡ʣ30000/1001ʱΪ䵹.
+	 */
+	int video_muxer_create(const char *output_path, int width, int height, AVRational frame_rate,
+		AVFormatContext *input, int64_t input_offset);
+	// дһƵ/Ļᱻunrefvideo_muxer_write_frameڲ̵ͬ߳
+	int video_muxer_write_input_packet(AVPacket *pkt);
 	int video_muxer_write_frame(AVFrame *frame, int frame_idx);
+	/**
+	 * @brief ֡ʱд룬ֱͨƵʹͬһʱᣬ֡ۻƯ.
+	 *
+	 * \param time_us Ƶʱ䣨AV_TIME_BASEλFFmpegDecoder::getFrameTime
+	 *        AV_NOPTS_VALUEʱ˳һ֡󲻴һ֡pts˳Ϊһ֡+1
+	 * \return ɹ0
+	 */
+	int video_muxer_write_frame_at(AVFrame *frame, int64_t time_us);
 	int video_muxer_flush();
 	void video_muxer_destroy();
 
@@ -37,6 +66,8 @@ private:
 	
 	int video_muxer_init_codec();
 	void video_muxer_set_defaults();
+	int video_muxer_write_packet(AVPacket *pkt);
 	
 	VideoMuxerCtx* mCtx = nullptr;  // C++11ֱӳʼҰָ
+	std::unique_ptr<StreamPassthrough> mPassthrough; // Ƶ/ĻֱͨδΪ
 };
\ No newline at end of file
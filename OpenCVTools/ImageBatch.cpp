@@ -0,0 +1,315 @@
+#include "pch.h"
+#include "ImageBatch.h"
+#include "CvTranslator.h"
+#include "BoundedQueue.h"
+#include "AvJob.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// 流水线中的一张图片，从读入到写完由同一个对象承载
+struct ImageBatchItem {
+	int index = 0;
+	int status = CvBatchOk;
+	bool eos = false;
+	std::vector<uchar> bytes; // 读入时为原始文件，处理后为编码结果
+};
+
+static bool read_file(const std::string& path, std::vector<uchar>& out)
+{
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		return false;
+	}
+	std::streamoff size = in.tellg();
+	if (size <= 0) {
+		return false;
+	}
+	out.resize(static_cast<size_t>(size));
+	in.seekg(0);
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(out.data()), size));
+}
+
+static bool write_file(const std::string& path, const std::vector<uchar>& data)
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	return static_cast<bool>(out);
+}
+
+// 取文件扩展名（含点，小写），imencode按它选择编码器
+static std::string file_extension(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return std::string();
+	}
+	std::string ext = path.substr(dot);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return ext;
+}
+
+ImageBatch::ImageBatch(const EffectChain& chain, int threads, int maxInFlight)
+	: m_chain(chain)
+	, m_threads(threads)
+	, m_maxInFlight(maxInFlight)
+{
+	if (m_threads <= 0) {
+		m_threads = avjob_threads();
+		if (m_threads <= 0) {
+			m_threads = static_cast<int>(std::thread::hardware_concurrency());
+		}
+		if (m_threads <= 0) {
+			m_threads = 1;
+		}
+	}
+	if (m_maxInFlight <= 0) {
+		m_maxInFlight = m_threads * 2;
+	}
+	// 每个处理线程至少要能拿到一张图
+	m_maxInFlight = std::max(m_maxInFlight, m_threads);
+}
+
+std::vector<std::string> ImageBatch::expand(const std::string& pattern)
+{
+	std::vector<cv::String> found;
+	try {
+		cv::glob(pattern, found, false);
+	}
+	catch (const cv::Exception& e) {
+		std::cerr << "cv::glob fair: " << e.what() << std::endl;
+	}
+	std::vector<std::string> paths(found.begin(), found.end());
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+std::string ImageBatch::outputPath(const std::string& input, const std::string& outputDir)
+{
+	size_t slash = input.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+	if (outputDir.empty()) {
+		return name;
+	}
+	char last = outputDir.back();
+	return (last == '/' || last == '\\') ? outputDir + name : outputDir + "/" + name;
+}
+
+int ImageBatch::run(const std::vector<std::string>& inputs, const std::string& outputDir,
+	CvBatchCallback callback, void* user, CvBatchStats& stats)
+{
+	memset(&stats, 0, sizeof(stats));
+	const int total = static_cast<int>(inputs.size());
+	stats.total = total;
+	if (total == 0) {
+		return 0;
+	}
+
+	std::vector<std::string> outputs;
+	outputs.reserve(inputs.size());
+	for (const std::string& input : inputs) {
+		outputs.push_back(outputPath(input, outputDir));
+	}
+
+	const size_t queueCapacity = static_cast<size_t>(m_maxInFlight);
+	BoundedQueue<ImageBatchItem*> readQueue(queueCapacity);
+	BoundedQueue<ImageBatchItem*> doneQueue(queueCapacity);
+	std::atomic<bool> abort(false);
+	std::atomic<int> written(0);
+	std::atomic<int64_t> bytesRead(0);
+	int readCount = 0;
+	auto beginTime = std::chrono::steady_clock::now();
+
+	// 读文件线程：只做IO，解码交给处理线程；已读未写的图片数不超过m_maxInFlight
+	std::thread readThread([&]() {
+		for (int i = 0; i < total && !abort.load(); ++i) {
+			while (readCount - written.load() >= m_maxInFlight && !abort.load()) {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+
+			ImageBatchItem* item = new ImageBatchItem();
+			item->index = i;
+			if (outputs[i] == inputs[i]) {
+				// 不覆盖原图
+				item->status = CvBatchWriteFailed;
+			}
+			else if (!read_file(inputs[i], item->bytes)) {
+				item->status = CvBatchReadFailed;
+			}
+			else {
+				bytesRead.fetch_add(static_cast<int64_t>(item->bytes.size()));
+			}
+			if (!readQueue.push(item, abort)) {
+				delete item;
+				break;
+			}
+			readCount++;
+		}
+
+		// 每个处理线程一个结束标记
+		for (int i = 0; i < m_threads; ++i) {
+			ImageBatchItem* eos = new ImageBatchItem();
+			eos->eos = true;
+			if (!readQueue.push(eos, abort)) {
+				delete eos;
+				break;
+			}
+		}
+	});
+
+	// 处理线程：解码、执行特效链、按输出扩展名编码，每个线程独立的CvTranslator和特效链副本
+	std::vector<std::thread> workers;
+	for (int t = 0; t < m_threads; ++t) {
+		workers.emplace_back([&]() {
+			CvTranslator translator;
+			EffectChain chain = m_chain;
+			ImageBatchItem* item = nullptr;
+			while (readQueue.pop(item, abort)) {
+				if (item->eos || item->status != CvBatchOk) {
+					if (!doneQueue.push(item, abort)) {
+						delete item;
+						return;
+					}
+					if (item->eos) {
+						return;
+					}
+					continue;
+				}
+
+				try {
+					cv::Mat src = cv::imdecode(item->bytes, cv::IMREAD_COLOR);
+					if (src.empty()) {
+						item->status = CvBatchDecodeFailed;
+					}
+					else {
+						cv::Mat dst = chain.applyInPlace(translator, src); // src是本项独有的解码结果
+						if (dst.empty()) {
+							item->status = CvBatchProcessFailed;
+						}
+						else if (!cv::imencode(file_extension(outputs[item->index]), dst, item->bytes)) {
+							item->status = CvBatchEncodeFailed;
+						}
+					}
+				}
+				catch (const cv::Exception& e) {
+					std::cerr << "image batch fair, " << inputs[item->index] << ": " << e.what() << std::endl;
+					item->status = CvBatchProcessFailed;
+				}
+
+				if (!doneQueue.push(item, abort)) {
+					delete item;
+					return;
+				}
+			}
+		});
+	}
+
+	// 当前线程写文件，完成顺序与输入顺序无关
+	std::vector<char> reported(inputs.size(), 0);
+	int finishedWorkers = 0;
+	ImageBatchItem* item = nullptr;
+	while (finishedWorkers < m_threads && doneQueue.pop(item, abort)) {
+		if (item->eos) {
+			finishedWorkers++;
+			delete item;
+			continue;
+		}
+		if (item->status == CvBatchOk) {
+			if (write_file(outputs[item->index], item->bytes)) {
+				stats.bytes_written += static_cast<int64_t>(item->bytes.size());
+			}
+			else {
+				item->status = CvBatchWriteFailed;
+			}
+		}
+
+		if (item->status == CvBatchOk) {
+			stats.succeeded++;
+		}
+		else {
+			stats.failed++;
+		}
+		reported[item->index] = 1;
+		if (callback) {
+			callback(item->index, inputs[item->index].c_str(), outputs[item->index].c_str(), item->status, user);
+		}
+		delete item;
+
+		int done = written.fetch_add(1) + 1;
+		avjob_report(done, 0);
+		// 作业取消：停止读入，已在流水线中的图片照常写完
+		if (avjob_cancelled()) {
+			abort.store(true);
+		}
+	}
+
+	abort.store(true);
+	readThread.join();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// 释放中止时残留在队列中的图片
+	while (readQueue.tryPop(item)) {
+		delete item;
+	}
+	while (doneQueue.tryPop(item)) {
+		delete item;
+	}
+
+	// 没有走到写文件的输入按跳过处理
+	for (int i = 0; i < total; ++i) {
+		if (!reported[i]) {
+			stats.failed++;
+			if (callback) {
+				callback(i, inputs[i].c_str(), outputs[i].c_str(), CvBatchSkipped, user);
+			}
+		}
+	}
+
+	stats.bytes_read = bytesRead.load();
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+	stats.images_per_sec = stats.seconds > 0 ? stats.succeeded / stats.seconds : 0;
+	std::cout << "[info] image batch total:" << stats.total << " ok:" << stats.succeeded << " fair:" << stats.failed
+		<< " threads:" << m_threads << " inflight:" << m_maxInFlight
+		<< " seconds:" << stats.seconds << " images/s:" << stats.images_per_sec << std::endl;
+	return stats.failed;
+}
+
+// -------------------- 批量处理 C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessBatch(const char** input_paths, int count, const char* output_dir,
+	void* chain, int threads, int max_inflight, CvBatchCallback callback, void* user, CvBatchStats* stats)
+{
+	if (!input_paths || count <= 0 || !output_dir || !chain) return -1;
+	std::vector<std::string> inputs;
+	inputs.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		inputs.push_back(input_paths[i] ? input_paths[i] : "");
+	}
+
+	CvBatchStats local;
+	ImageBatch batch(*static_cast<EffectChain*>(chain), threads, max_inflight);
+	return batch.run(inputs, output_dir, callback, user, stats ? *stats : local);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessBatchGlob(const char* pattern, const char* output_dir,
+	void* chain, int threads, int max_inflight, CvBatchCallback callback, void* user, CvBatchStats* stats)
+{
+	if (!pattern || !output_dir || !chain) return -1;
+	std::vector<std::string> inputs = ImageBatch::expand(pattern);
+	if (inputs.empty()) {
+		std::cerr << "no input matches " << pattern << std::endl;
+		return -2;
+	}
+
+	CvBatchStats local;
+	ImageBatch batch(*static_cast<EffectChain*>(chain), threads, max_inflight);
+	return batch.run(inputs, output_dir, callback, user, stats ? *stats : local);
+}
@@ -0,0 +1,49 @@
+/*****************************************************************//**
+ * \file   ImageBatch.h
+ * \brief  批量图片处理：读文件、解码+特效+编码、写文件三段流水线
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "EffectChain.h"
+#include "OpenCVFFMpegTools.h"
+
+class ImageBatch
+{
+public:
+	/**
+	 * @brief 创建批处理.
+	 *
+	 * \param chain 特效链，每个处理线程各拷贝一份
+	 * \param threads 解码/特效/编码线程数，<=0时取调度器分到的线程数或CPU核数
+	 * \param maxInFlight 已读入但未写完的图片数上限，<=0时取threads*2，用于限制内存
+	 */
+	ImageBatch(const EffectChain& chain, int threads, int maxInFlight);
+
+	/**
+	 * @brief 处理一批文件，输出与输入同名，写到outputDir下.
+	 *
+	 * 读文件和写文件各一个线程，与处理线程重叠；callback在写文件线程中逐个调用。
+	 * 作业被取消时停止读入，未处理的文件以CvBatchSkipped回调
+	 * \param inputs 输入路径
+	 * \param outputDir 已存在的输出目录
+	 * \param stats 汇总结果
+	 * \return 失败（含跳过）的文件数
+	 */
+	int run(const std::vector<std::string>& inputs, const std::string& outputDir,
+		CvBatchCallback callback, void* user, CvBatchStats& stats);
+
+	// 按通配符展开输入，例如 "D:/photos/*.jpg"，结果按路径排序
+	static std::vector<std::string> expand(const std::string& pattern);
+	// 输出路径：outputDir + 输入的文件名
+	static std::string outputPath(const std::string& input, const std::string& outputDir);
+
+private:
+	EffectChain m_chain;
+	int m_threads;
+	int m_maxInFlight;
+};
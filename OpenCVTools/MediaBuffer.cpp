@@ -0,0 +1,254 @@
+#include "pch.h"
+#include "MediaBuffer.h"
+#include "OpenCVFFMpegTools.h"
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/samplefmt.h>
+}
+
+static std::atomic<int64_t> g_alloc_count(0);
+
+int64_t media_buffer_alloc_count()
+{
+	return g_alloc_count.load();
+}
+
+void media_buffer_note_alloc()
+{
+	g_alloc_count++;
+}
+
+AllocSteadyCheck::AllocSteadyCheck(const char* name, int64_t warmupFrames)
+	: m_name(name), m_warmup(warmupFrames)
+{
+}
+
+void AllocSteadyCheck::frameDone()
+{
+	if (++m_frames == m_warmup) {
+		m_base = media_buffer_alloc_count();
+	}
+}
+
+bool AllocSteadyCheck::report() const
+{
+	if (m_base < 0) {
+		std::cout << "[alloc check] " << m_name << " | frames:" << m_frames
+			<< " | shorter than warm-up (" << m_warmup << "), skipped" << std::endl;
+		return true;
+	}
+	int64_t steadyFrames = m_frames - m_warmup;
+	int64_t allocs = media_buffer_alloc_count() - m_base;
+	if (allocs != 0) {
+		std::cerr << "[alloc check] " << m_name << " steady state fair | frames:" << steadyFrames
+			<< " | buffer allocs:" << allocs << " (" << (steadyFrames > 0 ? (double)allocs / steadyFrames : 0.0)
+			<< "/frame)" << std::endl;
+		return false;
+	}
+	std::cout << "[alloc check] " << m_name << " | steady frames:" << steadyFrames << " | buffer allocs:0" << std::endl;
+	return true;
+}
+
+static AVPacket* counted_packet_alloc()
+{
+	g_alloc_count++;
+	return av_packet_alloc();
+}
+
+static AVFrame* counted_frame_alloc()
+{
+	g_alloc_count++;
+	return av_frame_alloc();
+}
+
+// av_buffer_pool只在池里没有空闲缓冲区时调用
+static AVBufferRef* counted_buffer_alloc(int size)
+{
+	g_alloc_count++;
+	return av_buffer_alloc(size);
+}
+
+// ---------------- PacketRef / FrameRef ----------------
+
+PacketRef::PacketRef()
+	: m_pkt(counted_packet_alloc())
+{
+}
+
+PacketRef::~PacketRef()
+{
+	av_packet_free(&m_pkt);
+}
+
+void PacketRef::unref()
+{
+	av_packet_unref(m_pkt);
+}
+
+FrameRef::FrameRef()
+	: m_frame(counted_frame_alloc())
+{
+}
+
+FrameRef::~FrameRef()
+{
+	av_frame_free(&m_frame);
+}
+
+void FrameRef::unref()
+{
+	av_frame_unref(m_frame);
+}
+
+// ---------------- PacketPool ----------------
+
+PacketPool::~PacketPool()
+{
+	for (AVPacket* pkt : m_free) {
+		av_packet_free(&pkt);
+	}
+}
+
+AVPacket* PacketPool::clone(const AVPacket* src)
+{
+	AVPacket* pkt = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (!m_free.empty()) {
+			pkt = m_free.back();
+			m_free.pop_back();
+		}
+	}
+	if (!pkt) {
+		pkt = counted_packet_alloc();
+		if (!pkt) return nullptr;
+	}
+	if (av_packet_ref(pkt, src) < 0) {
+		recycle(pkt);
+		return nullptr;
+	}
+	return pkt;
+}
+
+void PacketPool::recycle(AVPacket*& pkt)
+{
+	if (!pkt) return;
+	av_packet_unref(pkt);
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_free.push_back(pkt);
+	pkt = nullptr;
+}
+
+// ---------------- FramePool ----------------
+
+FramePool::~FramePool()
+{
+	for (AVFrame* frame : m_free) {
+		av_frame_free(&frame);
+	}
+	// 仍被编码器等持有的缓冲区归还后池才真正释放
+	av_buffer_pool_uninit(&m_pool);
+}
+
+AVFrame* FramePool::take()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (!m_free.empty()) {
+			AVFrame* frame = m_free.back();
+			m_free.pop_back();
+			return frame;
+		}
+	}
+	return counted_frame_alloc();
+}
+
+AVBufferRef* FramePool::buffer(int size)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (!m_pool || m_poolSize != size) {
+		// 参数变化：旧池在其缓冲区全部归还后自行释放
+		av_buffer_pool_uninit(&m_pool);
+		m_pool = av_buffer_pool_init(size, counted_buffer_alloc);
+		m_poolSize = size;
+		if (!m_pool) return nullptr;
+	}
+	return av_buffer_pool_get(m_pool);
+}
+
+AVFrame* FramePool::ref(const AVFrame* src)
+{
+	AVFrame* frame = take();
+	if (!frame) return nullptr;
+	if (av_frame_ref(frame, src) < 0) {
+		recycle(frame);
+		return nullptr;
+	}
+	return frame;
+}
+
+AVFrame* FramePool::video(int width, int height, int pix_fmt)
+{
+	AVPixelFormat fmt = static_cast<AVPixelFormat>(pix_fmt);
+	int size = av_image_get_buffer_size(fmt, width, height, 32);
+	if (size < 0) return nullptr;
+
+	AVFrame* frame = take();
+	if (!frame) return nullptr;
+	// 末尾留出余量，sws的SIMD写行尾时不会越界
+	frame->buf[0] = buffer(size + 64);
+	if (!frame->buf[0] ||
+		av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, fmt, width, height, 32) < 0) {
+		recycle(frame);
+		return nullptr;
+	}
+	frame->extended_data = frame->data;
+	frame->format = pix_fmt;
+	frame->width = width;
+	frame->height = height;
+	return frame;
+}
+
+AVFrame* FramePool::audio(int nb_samples, int sample_fmt, int channels, uint64_t channel_layout, int sample_rate)
+{
+	AVSampleFormat fmt = static_cast<AVSampleFormat>(sample_fmt);
+	// 平面格式的声道数超过data[]时需要extended_data另行分配，这里不处理
+	if (channels <= 0 || (av_sample_fmt_is_planar(fmt) && channels > AV_NUM_DATA_POINTERS)) {
+		return nullptr;
+	}
+	int linesize = 0;
+	int size = av_samples_get_buffer_size(&linesize, channels, nb_samples, fmt, 0);
+	if (size < 0) return nullptr;
+
+	AVFrame* frame = take();
+	if (!frame) return nullptr;
+	frame->buf[0] = buffer(size);
+	if (!frame->buf[0] ||
+		av_samples_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, channels, nb_samples, fmt, 0) < 0) {
+		recycle(frame);
+		return nullptr;
+	}
+	frame->extended_data = frame->data;
+	frame->format = sample_fmt;
+	frame->nb_samples = nb_samples;
+	frame->channels = channels;
+	frame->channel_layout = channel_layout;
+	frame->sample_rate = sample_rate;
+	return frame;
+}
+
+void FramePool::recycle(AVFrame*& frame)
+{
+	if (!frame) return;
+	av_frame_unref(frame);
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_free.push_back(frame);
+	frame = nullptr;
+}
+
+// -------------------- MediaBuffer C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API int64_t MediaBuffer_GetAllocCount()
+{
+	return media_buffer_alloc_count();
+}
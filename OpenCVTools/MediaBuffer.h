@@ -0,0 +1,125 @@
+/*****************************************************************//**
+ * \file   MediaBuffer.h
+ * \brief  AVPacket/AVFrame复用层：结构体回收、数据缓冲区来自av_buffer_pool，并统计实际分配次数
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct AVPacket;
+struct AVFrame;
+struct AVBufferPool;
+struct AVBufferRef;
+
+// 本层向系统申请内存的累计次数（AVPacket/AVFrame结构体和帧数据缓冲区）。
+// 稳态下逐帧处理不应再增长，各流程结束时按帧数打印
+int64_t media_buffer_alloc_count();
+// 记一次池外组件（如COpenCVTools的帧缓存）的实际分配，计入同一计数
+void media_buffer_note_alloc();
+
+/**
+ * @brief 稳态零分配自检：前warmupFrames帧（池预热）不计，之后每帧的分配增量应为0.
+ *
+ * 计数是进程全局的，同时运行的其它作业会计入，只在单个作业运行时可据此判定回退
+ */
+class AllocSteadyCheck
+{
+public:
+	explicit AllocSteadyCheck(const char* name, int64_t warmupFrames = 30);
+	// 每处理完一帧调用一次（单线程调用）
+	void frameDone();
+	// 打印预热后的帧数与分配数；预热后有分配返回false
+	bool report() const;
+
+private:
+	const char* m_name;
+	int64_t m_warmup;
+	int64_t m_frames = 0;
+	int64_t m_base = -1; // 预热结束时的计数
+};
+
+// 单个可复用的AVPacket，离开作用域释放；每次使用后unref即可再次读包/收包
+class PacketRef
+{
+public:
+	PacketRef();
+	~PacketRef();
+	PacketRef(const PacketRef&) = delete;
+	PacketRef& operator=(const PacketRef&) = delete;
+
+	AVPacket* get() const { return m_pkt; }
+	AVPacket* operator->() const { return m_pkt; }
+	void unref();
+
+private:
+	AVPacket* m_pkt;
+};
+
+// 单个可复用的AVFrame（用法同PacketRef）
+class FrameRef
+{
+public:
+	FrameRef();
+	~FrameRef();
+	FrameRef(const FrameRef&) = delete;
+	FrameRef& operator=(const FrameRef&) = delete;
+
+	AVFrame* get() const { return m_frame; }
+	AVFrame* operator->() const { return m_frame; }
+	void unref();
+
+private:
+	AVFrame* m_frame;
+};
+
+// AVPacket结构体池，替代逐包的av_packet_clone/av_packet_free（例如缓存一个GOP）
+// 线程安全；池析构前须归还所有取出的包
+class PacketPool
+{
+public:
+	PacketPool() {}
+	~PacketPool();
+	PacketPool(const PacketPool&) = delete;
+	PacketPool& operator=(const PacketPool&) = delete;
+
+	// 引用src的数据，失败返回nullptr
+	AVPacket* clone(const AVPacket* src);
+	// unref后放回池中，pkt置空
+	void recycle(AVPacket*& pkt);
+
+private:
+	std::mutex m_mtx;
+	std::vector<AVPacket*> m_free;
+};
+
+// AVFrame池：结构体回收，视频/音频数据缓冲区取自av_buffer_pool；
+// 帧参数不变时稳态零分配。线程安全，可在一个线程取、另一个线程归还
+class FramePool
+{
+public:
+	FramePool() {}
+	~FramePool();
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	// 替代av_frame_clone：共享src的数据引用
+	AVFrame* ref(const AVFrame* src);
+	// 替代av_frame_alloc + av_frame_get_buffer（行对齐32字节）
+	AVFrame* video(int width, int height, int pix_fmt);
+	AVFrame* audio(int nb_samples, int sample_fmt, int channels, uint64_t channel_layout, int sample_rate);
+	// unref后放回池中，frame置空
+	void recycle(AVFrame*& frame);
+
+private:
+	AVFrame* take();
+	AVBufferRef* buffer(int size);
+
+	std::mutex m_mtx;
+	std::vector<AVFrame*> m_free;
+	AVBufferPool* m_pool = nullptr; // 当前数据缓冲区大小对应的池
+	int m_poolSize = 0;
+};
@@ -0,0 +1,465 @@
+#include "pch.h"
+#include "MediaIndex.h"
+#include "AvWorker.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// 索引文件格式：魔数 + 版本 + 条目数，后接各条目；字段变动时提升版本号，旧文件直接丢弃
+static const uint32_t kIndexMagic = 0x5844494D; // "MIDX"
+static const uint32_t kIndexVersion = 1;
+
+MediaIndex& MediaIndex::instance()
+{
+	static MediaIndex index;
+	return index;
+}
+
+bool MediaIndex::statFile(const std::string& path, int64_t& size, int64_t& mtime)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(path.c_str(), &st) != 0) {
+		return false;
+	}
+#else
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		return false;
+	}
+#endif
+	size = static_cast<int64_t>(st.st_size);
+	mtime = static_cast<int64_t>(st.st_mtime);
+	return true;
+}
+
+// ---------------- 序列化 ----------------
+
+template <typename T>
+static void write_pod(std::ostream& os, const T& v)
+{
+	os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool read_pod(std::istream& is, T& v)
+{
+	return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+template <typename T>
+static void write_vec(std::ostream& os, const std::vector<T>& v)
+{
+	write_pod(os, static_cast<uint32_t>(v.size()));
+	if (!v.empty()) {
+		os.write(reinterpret_cast<const char*>(v.data()), sizeof(T) * v.size());
+	}
+}
+
+template <typename T>
+static bool read_vec(std::istream& is, std::vector<T>& v)
+{
+	uint32_t n = 0;
+	if (!read_pod(is, n) || n > (1u << 28)) {
+		return false;
+	}
+	v.resize(n);
+	return n == 0 || static_cast<bool>(is.read(reinterpret_cast<char*>(v.data()), sizeof(T) * n));
+}
+
+static void write_str(std::ostream& os, const std::string& s)
+{
+	write_pod(os, static_cast<uint32_t>(s.size()));
+	os.write(s.data(), s.size());
+}
+
+static bool read_str(std::istream& is, std::string& s)
+{
+	uint32_t n = 0;
+	if (!read_pod(is, n) || n > 65536) {
+		return false;
+	}
+	s.resize(n);
+	return n == 0 || static_cast<bool>(is.read(&s[0], n));
+}
+
+bool MediaIndex::open(const std::string& indexPath)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_indexPath = indexPath;
+	m_entries.clear();
+	m_dirty = false;
+
+	std::ifstream is(indexPath, std::ios::binary);
+	if (!is) {
+		return true; // 首次使用
+	}
+	uint32_t magic = 0, version = 0, count = 0;
+	if (!read_pod(is, magic) || !read_pod(is, version) || !read_pod(is, count) ||
+		magic != kIndexMagic || version != kIndexVersion) {
+		std::cerr << "[MediaIndex] index file invalid, rebuild: " << indexPath << std::endl;
+		return false;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		std::string path;
+		Entry entry;
+		uint8_t hasKeyframes = 0;
+		if (!read_str(is, path) || !read_pod(is, entry.fileSize) || !read_pod(is, entry.fileMtime) ||
+			!read_pod(is, entry.info) || !read_pod(is, hasKeyframes) ||
+			!read_vec(is, entry.keyframes) || !read_vec(is, entry.keyframePos) || !read_vec(is, entry.thumbnail)) {
+			std::cerr << "[MediaIndex] index file truncated at entry " << i << std::endl;
+			m_entries.clear();
+			return false;
+		}
+		entry.hasKeyframes = hasKeyframes != 0;
+		m_entries[path] = std::move(entry);
+	}
+	std::cout << "[MediaIndex] loaded " << m_entries.size() << " entries" << std::endl;
+	return true;
+}
+
+bool MediaIndex::flush()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (!m_dirty || m_indexPath.empty()) {
+		return true;
+	}
+
+	// 先写临时文件再替换，中途失败不破坏原索引
+	std::string tmpPath = m_indexPath + ".tmp";
+	{
+		std::ofstream os(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!os) {
+			std::cerr << "[MediaIndex] open index file fair: " << tmpPath << std::endl;
+			return false;
+		}
+		write_pod(os, kIndexMagic);
+		write_pod(os, kIndexVersion);
+		write_pod(os, static_cast<uint32_t>(m_entries.size()));
+		for (const auto& it : m_entries) {
+			const Entry& entry = it.second;
+			write_str(os, it.first);
+			write_pod(os, entry.fileSize);
+			write_pod(os, entry.fileMtime);
+			write_pod(os, entry.info);
+			write_pod(os, static_cast<uint8_t>(entry.hasKeyframes ? 1 : 0));
+			write_vec(os, entry.keyframes);
+			write_vec(os, entry.keyframePos);
+			write_vec(os, entry.thumbnail);
+		}
+		if (!os) {
+			std::cerr << "[MediaIndex] write index file fair: " << tmpPath << std::endl;
+			return false;
+		}
+	}
+	std::remove(m_indexPath.c_str()); // Windows下rename不覆盖已存在的文件
+	if (std::rename(tmpPath.c_str(), m_indexPath.c_str()) != 0) {
+		std::cerr << "[MediaIndex] rename index file fair: " << m_indexPath << std::endl;
+		return false;
+	}
+	m_dirty = false;
+	return true;
+}
+
+bool MediaIndex::lookup(const std::string& mediaPath, int64_t size, int64_t mtime, Entry& entry)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_entries.find(mediaPath);
+	if (it == m_entries.end()) {
+		return false;
+	}
+	if (it->second.fileSize != size || it->second.fileMtime != mtime) {
+		m_entries.erase(it);
+		m_dirty = true;
+		return false;
+	}
+	entry = it->second;
+	return true;
+}
+
+void MediaIndex::store(const std::string& mediaPath, const Entry& entry)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_entries[mediaPath] = entry;
+	m_dirty = true;
+}
+
+void MediaIndex::invalidate(const std::string& mediaPath)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	if (m_entries.erase(mediaPath) > 0) {
+		m_dirty = true;
+	}
+}
+
+void MediaIndex::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_entries.clear();
+	m_dirty = true;
+}
+
+// ---------------- 探测 ----------------
+
+bool MediaIndex::probe(const std::string& mediaPath, AvMediaInfo& info)
+{
+	memset(&info, 0, sizeof(info));
+	info.duration = -1.0;
+
+	AVFormatContext* fmt_ctx = nullptr;
+	if (avformat_open_input(&fmt_ctx, mediaPath.c_str(), nullptr, nullptr) < 0) {
+		std::cerr << "[MediaIndex] open file fair: " << mediaPath << std::endl;
+		return false;
+	}
+	if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+		std::cerr << "[MediaIndex] avformat_find_stream_info fair: " << mediaPath << std::endl;
+		avformat_close_input(&fmt_ctx);
+		return false;
+	}
+
+	if (fmt_ctx->duration != AV_NOPTS_VALUE) {
+		info.duration = fmt_ctx->duration / static_cast<double>(AV_TIME_BASE);
+	}
+	info.bit_rate = fmt_ctx->bit_rate;
+	info.nb_streams = static_cast<int>(fmt_ctx->nb_streams);
+
+	int video_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_idx >= 0) {
+		AVStream* st = fmt_ctx->streams[video_idx];
+		info.width = st->codecpar->width;
+		info.height = st->codecpar->height;
+		AVRational rate = av_guess_frame_rate(fmt_ctx, st, nullptr);
+		info.fps = rate.den > 0 ? av_q2d(rate) : 0.0;
+		snprintf(info.video_codec, sizeof(info.video_codec), "%s", avcodec_get_name(st->codecpar->codec_id));
+	}
+	int audio_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+	if (audio_idx >= 0) {
+		AVStream* st = fmt_ctx->streams[audio_idx];
+		info.sample_rate = st->codecpar->sample_rate;
+		info.channels = st->codecpar->channels;
+		snprintf(info.audio_codec, sizeof(info.audio_codec), "%s", avcodec_get_name(st->codecpar->codec_id));
+	}
+
+	avformat_close_input(&fmt_ctx);
+	return true;
+}
+
+bool MediaIndex::scanKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>& pos,
+	const std::atomic<bool>* abort)
+{
+	times.clear();
+	pos.clear();
+
+	AVFormatContext* fmt_ctx = nullptr;
+	if (avformat_open_input(&fmt_ctx, mediaPath.c_str(), nullptr, nullptr) < 0) {
+		return false;
+	}
+	if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+		avformat_close_input(&fmt_ctx);
+		return false;
+	}
+	int video_idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (video_idx < 0) {
+		avformat_close_input(&fmt_ctx);
+		return false;
+	}
+	// 只读视频包，不解码
+	for (unsigned int i = 0; i < fmt_ctx->nb_streams; ++i) {
+		if (static_cast<int>(i) != video_idx) {
+			fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+		}
+	}
+	AVStream* st = fmt_ctx->streams[video_idx];
+	int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+
+	AVPacket pkt = { 0 };
+	while (av_read_frame(fmt_ctx, &pkt) >= 0) {
+		if (abort && abort->load()) {
+			av_packet_unref(&pkt);
+			avformat_close_input(&fmt_ctx);
+			return false;
+		}
+		if (pkt.stream_index == video_idx && (pkt.flags & AV_PKT_FLAG_KEY)) {
+			int64_t ts = pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+			if (ts != AV_NOPTS_VALUE) {
+				times.push_back((ts - start) * av_q2d(st->time_base));
+				pos.push_back(pkt.pos);
+			}
+		}
+		av_packet_unref(&pkt);
+	}
+	avformat_close_input(&fmt_ctx);
+	return true;
+}
+
+// ---------------- 查询 ----------------
+
+bool MediaIndex::getInfo(const std::string& mediaPath, AvMediaInfo& info)
+{
+	int64_t size = 0, mtime = 0;
+	if (!statFile(mediaPath, size, mtime)) {
+		return false;
+	}
+	Entry entry;
+	if (lookup(mediaPath, size, mtime, entry)) {
+		info = entry.info;
+		return true;
+	}
+
+	entry = Entry();
+	entry.fileSize = size;
+	entry.fileMtime = mtime;
+	if (!probe(mediaPath, entry.info)) {
+		return false;
+	}
+	store(mediaPath, entry);
+	info = entry.info;
+	return true;
+}
+
+bool MediaIndex::getKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>* pos,
+	const std::atomic<bool>* abort)
+{
+	int64_t size = 0, mtime = 0;
+	if (!statFile(mediaPath, size, mtime)) {
+		return false;
+	}
+	Entry entry;
+	bool found = lookup(mediaPath, size, mtime, entry);
+	if (!found || !entry.hasKeyframes) {
+		if (!found) {
+			entry = Entry();
+			entry.fileSize = size;
+			entry.fileMtime = mtime;
+			if (!probe(mediaPath, entry.info)) {
+				return false;
+			}
+		}
+		if (!scanKeyframes(mediaPath, entry.keyframes, entry.keyframePos, abort)) {
+			return false;
+		}
+		entry.hasKeyframes = true;
+		store(mediaPath, entry);
+	}
+	times = entry.keyframes;
+	if (pos) {
+		*pos = entry.keyframePos;
+	}
+	return true;
+}
+
+bool MediaIndex::cachedKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>* pos)
+{
+	int64_t size = 0, mtime = 0;
+	if (!statFile(mediaPath, size, mtime)) {
+		return false;
+	}
+	Entry entry;
+	if (!lookup(mediaPath, size, mtime, entry) || !entry.hasKeyframes) {
+		return false;
+	}
+	times = entry.keyframes;
+	if (pos) {
+		*pos = entry.keyframePos;
+	}
+	return true;
+}
+
+int MediaIndex::keyframeBefore(const std::vector<double>& times, double seconds)
+{
+	// 表按读包顺序排列，带B帧的流不保证严格递增，逐个比较
+	int best = -1;
+	for (size_t i = 0; i < times.size(); ++i) {
+		if (times[i] <= seconds + 1e-6 && (best < 0 || times[i] >= times[best])) {
+			best = static_cast<int>(i);
+		}
+	}
+	return best;
+}
+
+bool MediaIndex::getThumbnail(const std::string& mediaPath, std::vector<uint8_t>& jpeg)
+{
+	int64_t size = 0, mtime = 0;
+	if (!statFile(mediaPath, size, mtime)) {
+		return false;
+	}
+	Entry entry;
+	bool found = lookup(mediaPath, size, mtime, entry);
+	if (found && !entry.thumbnail.empty()) {
+		jpeg = entry.thumbnail;
+		return true;
+	}
+	if (!found) {
+		entry = Entry();
+		entry.fileSize = size;
+		entry.fileMtime = mtime;
+		if (!probe(mediaPath, entry.info)) {
+			return false;
+		}
+	}
+
+	AvWorker worker;
+	int w = 0, h = 0;
+	if (!worker.GetVideoThumbnail(mediaPath, 120, 80, ThumbFormatJpeg, 0, entry.thumbnail, w, h, false)) {
+		return false;
+	}
+	store(mediaPath, entry);
+	jpeg = entry.thumbnail;
+	return true;
+}
+
+// -------------------- MediaIndex C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API bool MediaIndex_Open(const char* index_path)
+{
+	if (!index_path) return false;
+	return MediaIndex::instance().open(index_path);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool MediaIndex_Flush()
+{
+	return MediaIndex::instance().flush();
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool MediaIndex_GetInfo(const char* media_path, AvMediaInfo* info)
+{
+	if (!media_path || !info) return false;
+	return MediaIndex::instance().getInfo(media_path, *info);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int MediaIndex_GetKeyframes(const char* media_path, double* times, int max_count)
+{
+	if (!media_path) return -1;
+	std::vector<double> keyframes;
+	if (!MediaIndex::instance().getKeyframes(media_path, keyframes)) {
+		return -1;
+	}
+	if (times && max_count > 0) {
+		int n = std::min(max_count, static_cast<int>(keyframes.size()));
+		std::copy(keyframes.begin(), keyframes.begin() + n, times);
+	}
+	return static_cast<int>(keyframes.size());
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool MediaIndex_GetThumbnail(const char* media_path, unsigned char** out_data, int* out_size)
+{
+	if (!media_path || !out_data || !out_size) return false;
+	*out_data = nullptr;
+	*out_size = 0;
+	std::vector<uint8_t> jpeg;
+	if (!MediaIndex::instance().getThumbnail(media_path, jpeg) || jpeg.empty()) {
+		return false;
+	}
+	*out_data = static_cast<unsigned char*>(av_malloc(jpeg.size()));
+	if (!*out_data) return false;
+	memcpy(*out_data, jpeg.data(), jpeg.size());
+	*out_size = static_cast<int>(jpeg.size());
+	return true;
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void MediaIndex_Invalidate(const char* media_path)
+{
+	if (!media_path) return;
+	MediaIndex::instance().invalidate(media_path);
+}
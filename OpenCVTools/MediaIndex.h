@@ -0,0 +1,89 @@
+/*****************************************************************//**
+ * \file   MediaIndex.h
+ * \brief  媒体元数据索引：时长、流参数、关键帧位置、缩略图，按文件大小/修改时间失效
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OpenCVFFMpegTools.h"
+
+// 进程内共享的索引，所有页面/工具经同一实例查询；Open/Flush时与磁盘文件同步
+class MediaIndex
+{
+public:
+	struct Entry {
+		int64_t fileSize = 0;
+		int64_t fileMtime = 0;
+		AvMediaInfo info;                 // 探测得到的元数据
+		bool hasKeyframes = false;        // keyframes是否已建立（需要整文件读包，按需建立）
+		std::vector<double> keyframes;    // 视频关键帧时间（秒，已减去起始时间）
+		std::vector<int64_t> keyframePos; // 对应数据包在文件中的字节位置，未知为-1
+		std::vector<uint8_t> thumbnail;   // JPEG缩略图，按需生成
+	};
+
+	static MediaIndex& instance();
+
+	/**
+	 * @brief 载入索引文件，之后Flush写回同一路径.
+	 *
+	 * 文件不存在视为空索引
+	 * \return 文件格式错误返回false（此时索引为空）
+	 */
+	bool open(const std::string& indexPath);
+	// 有改动时写回磁盘
+	bool flush();
+
+	/**
+	 * @brief 取元数据，未命中或文件已变化时重新探测.
+	 *
+	 * \return 文件无法访问或探测失败返回false
+	 */
+	bool getInfo(const std::string& mediaPath, AvMediaInfo& info);
+	/**
+	 * @brief 取关键帧时间表，首次调用时扫描全部数据包（不解码）.
+	 *
+	 * \param pos 可为nullptr
+	 * \param abort 可为nullptr；扫描中置为true时放弃，返回false且不写入索引
+	 */
+	bool getKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>* pos = nullptr,
+		const std::atomic<bool>* abort = nullptr);
+	// 只取已建立的关键帧时间表，未建立或文件已变化时返回false，不扫描
+	bool cachedKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>* pos = nullptr);
+	// 取JPEG缩略图（不超过120x80），首次调用时生成
+	bool getThumbnail(const std::string& mediaPath, std::vector<uint8_t>& jpeg);
+
+	void invalidate(const std::string& mediaPath);
+	void clear();
+
+	// 在关键帧时间表中找不晚于seconds的最后一个关键帧，返回下标；没有返回-1
+	static int keyframeBefore(const std::vector<double>& times, double seconds);
+
+	// 读取文件大小和修改时间
+	static bool statFile(const std::string& path, int64_t& size, int64_t& mtime);
+
+private:
+	MediaIndex() {}
+	MediaIndex(const MediaIndex&) = delete;
+	MediaIndex& operator=(const MediaIndex&) = delete;
+
+	// 返回有效条目的拷贝；文件已变化时删除旧条目
+	bool lookup(const std::string& mediaPath, int64_t size, int64_t mtime, Entry& entry);
+	void store(const std::string& mediaPath, const Entry& entry);
+
+	static bool probe(const std::string& mediaPath, AvMediaInfo& info);
+	static bool scanKeyframes(const std::string& mediaPath, std::vector<double>& times, std::vector<int64_t>& pos,
+		const std::atomic<bool>* abort);
+
+	std::mutex m_mtx;
+	std::unordered_map<std::string, Entry> m_entries;
+	std::string m_indexPath;
+	bool m_dirty = false;
+};
@@ -26,6 +26,117 @@ struct param {
 };
 
 
+// 多段分割的一个分段
+struct AvSplitSegment {
+	const char* output_url;
+	double start_seconds;
+	double duration_seconds; // 0表示到结尾
+};
+
+// 码率阶梯中的一档输出
+struct AvRendition {
+	const char* output_url;
+	int width;    // 须为偶数
+	int height;   // 须为偶数
+	int bit_rate; // 0表示由编码器按质量控制
+};
+
+// 媒体元数据（MediaIndex），字段未知时为0，duration未知为-1
+struct AvMediaInfo {
+	double duration; // 秒
+	int64_t bit_rate;
+	int nb_streams;
+	int width;
+	int height;
+	double fps;
+	char video_codec[32];
+	int sample_rate;
+	int channels;
+	char audio_codec[32];
+};
+
+// 异步作业状态
+enum AvJobState {
+	AvJobQueued,
+	AvJobRunning,
+	AvJobSucceeded,
+	AvJobFailed,
+	AvJobCancelled
+};
+
+// 异步作业进度，可轮询也可在回调中读取
+struct AvJobProgress {
+	int state;           // AvJobState
+	int64_t frames;      // 已处理的帧/包数
+	int64_t pts_ms;      // 已处理到的时间（毫秒，相对输出起点）
+	int64_t bytes;       // 已读取的输入字节数
+	int64_t duration_ms; // 预计总时长（毫秒），未知为0
+	int64_t wait_ms;     // 在队列中等待派发的时间（毫秒）
+};
+
+// 作业优先级：交互作业（预览、缩略图、单张图片）先于批处理作业派发
+enum AvJobPriority {
+	AvJobInteractive,
+	AvJobBatch
+};
+
+// 调度器状态
+struct AvSchedulerStats {
+	int thread_limit;       // 线程上限
+	int threads_in_use;     // 运行中作业占用的线程数
+	int running;            // 运行中的作业数
+	int queued_interactive; // 排队中的交互作业
+	int queued_batch;       // 排队中的批处理作业
+	int64_t started;        // 累计派发的作业数
+	int64_t avg_wait_ms;    // 平均排队时间
+	int64_t max_wait_ms;    // 最长排队时间
+};
+
+// 通用作业：在调度线程中执行，返回0表示成功；可用AvJob_CurrentCancelled检查取消
+typedef int (*AvJobTask)(void* user);
+
+// 在作业线程中调用，状态变化时必调，运行中约每200毫秒一次；不要在回调里阻塞
+typedef void (*AvJobCallback)(int job_id, const AvJobProgress* progress, void* user);
+
+// 批量图片处理中单个文件的结果
+enum CvBatchStatus {
+	CvBatchOk = 0,
+	CvBatchReadFailed = -1,    // 读取文件失败
+	CvBatchDecodeFailed = -2,  // 不是可识别的图片
+	CvBatchProcessFailed = -3, // 特效处理异常
+	CvBatchEncodeFailed = -4,  // 输出扩展名不支持或编码失败
+	CvBatchWriteFailed = -5,   // 写入失败，输出与输入为同一文件时也返回该值
+	CvBatchSkipped = -6        // 作业取消后未处理
+};
+
+// 批量图片处理的汇总
+struct CvBatchStats {
+	int total;
+	int succeeded;
+	int failed;
+	double seconds;
+	double images_per_sec;
+	int64_t bytes_read;
+	int64_t bytes_written;
+};
+
+// 每处理完一个文件调用一次（在写文件线程中），index为输入序号，status为CvBatchStatus
+typedef void (*CvBatchCallback)(int index, const char* input_path, const char* output_path, int status, void* user);
+
+// 缩略图输出格式
+enum AvThumbFormat {
+	ThumbFormatJpeg,
+	ThumbFormatPng,
+	ThumbFormatBgr24 // 紧密排列的BGR24原始像素，行长为width*3
+};
+
+// resize_video的速度/质量档位
+enum AvResizePreset {
+	ResizePresetFast,     // x264 veryfast + 快速双线性
+	ResizePresetBalanced, // x264 medium + 双线性（默认）
+	ResizePresetQuality   // x264 slow + lanczos
+};
+
 enum func {
 	grayImage,
 	customOilPaintApprox,
@@ -37,7 +148,8 @@ enum func {
 	Whitening2,
 	addTextWatermark,
 	invertImage,
-	noAction
+	noAction,
+	applyMosaicRegions // 多区域马赛克：arr为"x,y,w,h;x,y,w,h"，iparam5为块大小
 };
 
 
@@ -56,16 +168,88 @@ OPENCVFFMPEGTOOLS_API int fnOpenCVTools(void);
 OPENCVFFMPEGTOOLS_API void* AvWorker_Create();
 OPENCVFFMPEGTOOLS_API void AvWorker_Destroy(void* worker);
 OPENCVFFMPEGTOOLS_API bool AvWorker_GetVideoFirstFrame(void* worker, const char* input_url, const char* output_bmp, bool is_rtsp);
+// 内存缩略图：按比例缩放到不超过max_width x max_height，format取AvThumbFormat，seek_seconds>0时取该时间前的关键帧
+// 成功时*out_data由DLL分配，用AvWorker_FreeBuffer释放
+OPENCVFFMPEGTOOLS_API bool AvWorker_GetVideoThumbnail(void* worker, const char* input_url, int max_width, int max_height, int format,
+	double seek_seconds, unsigned char** out_data, int* out_size, int* out_width, int* out_height, bool is_rtsp);
+OPENCVFFMPEGTOOLS_API void AvWorker_FreeBuffer(unsigned char* data);
 OPENCVFFMPEGTOOLS_API bool AvWorker_SpliceAV(void* worker, const char* input_url1, const char* input_url2, const char* output_url, bool is_rtsp);
+// N路拼接：input_urls为count个输入路径（count>=2），按数组顺序拼接，每个输入只保留第一个视频流和第一个音频流
+OPENCVFFMPEGTOOLS_API bool AvWorker_SpliceAVMulti(void* worker, const char** input_urls, int count, const char* output_url, bool is_rtsp);
 OPENCVFFMPEGTOOLS_API bool AvWorker_resize_video(void* worker, const char* input_url, const char* output_url, int dst_width, int dst_height);
+// preset取AvResizePreset
+OPENCVFFMPEGTOOLS_API bool AvWorker_resize_video_preset(void* worker, const char* input_url, const char* output_url, int dst_width, int dst_height, int preset);
+// 一次解码输出多档分辨率，返回成功输出的路数
+OPENCVFFMPEGTOOLS_API int AvWorker_resize_video_ladder(void* worker, const char* input_url, const AvRendition* renditions, int count, int preset);
+// 缩放段吞吐（如3840x2160 -> 1920x1080）：单条带与条带并行各跑frames帧，输出两者fps，返回预热后的缓冲区分配次数（应为0），失败返回-1
+OPENCVFFMPEGTOOLS_API int AvWorker_BenchmarkScale(int src_width, int src_height, int dst_width, int dst_height,
+	int preset, int frames, double* single_fps, double* sliced_fps);
+// 整条resize_video流水线吞吐（如4K输入 -> 1920x1080）：串行基线与多线程/条带并行各完整跑一遍，输出两者fps；成功返回0
+OPENCVFFMPEGTOOLS_API int AvWorker_BenchmarkResize(void* worker, const char* input_url, const char* output_url,
+	int dst_width, int dst_height, double* serial_fps, double* threaded_fps);
 OPENCVFFMPEGTOOLS_API bool AvWorker_split_video(
 	void* worker,
 	const char* input_url,
 	const char* output_url,
 	double start_seconds,
 	double duration_seconds);
+// 帧精确分割：只重编码起点所在GOP的剩余部分，其余数据包直接复制（H.264），其它编码从关键帧起复制
+OPENCVFFMPEGTOOLS_API bool AvWorker_split_video_smart(
+	void* worker,
+	const char* input_url,
+	const char* output_url,
+	double start_seconds,
+	double duration_seconds);
+// 单次读取输入写出多个分段，返回成功的分段数，失败返回-1
+OPENCVFFMPEGTOOLS_API int AvWorker_split_video_multi(
+	void* worker,
+	const char* input_url,
+	const AvSplitSegment* segments,
+	int count);
 OPENCVFFMPEGTOOLS_API double AvWorker_getDuration(void* worker, const char* input_url);
 
+// ---- 异步作业 C API ----
+// 提交后立即返回作业id（失败返回-1），由进程内统一的调度器派发；callback可为NULL，改为AvJob_GetProgress轮询。
+// 取消通过FFmpeg中断回调生效，读到下一个包时即停止，已写出的不完整输出文件会被删除
+OPENCVFFMPEGTOOLS_API int AvJob_SubmitResize(const char* input_url, const char* output_url, int dst_width, int dst_height, int preset,
+	AvJobCallback callback, void* user);
+OPENCVFFMPEGTOOLS_API int AvJob_SubmitSpliceMulti(const char** input_urls, int count, const char* output_url,
+	AvJobCallback callback, void* user);
+OPENCVFFMPEGTOOLS_API int AvJob_SubmitSplitSmart(const char* input_url, const char* output_url, double start_seconds, double duration_seconds,
+	AvJobCallback callback, void* user);
+OPENCVFFMPEGTOOLS_API bool AvJob_GetProgress(int job_id, AvJobProgress* progress);
+OPENCVFFMPEGTOOLS_API void AvJob_Cancel(int job_id);
+// 提交任意任务（例如formatChange的AVProcessor转换），threads为任务自身会用到的线程数，0表示全部核
+OPENCVFFMPEGTOOLS_API int AvJob_SubmitTask(AvJobTask task, void* task_user, int priority, int threads,
+	AvJobCallback callback, void* user);
+// 在作业线程中调用：当前作业是否已被取消、分到的线程数（不在作业中返回0）
+OPENCVFFMPEGTOOLS_API bool AvJob_CurrentCancelled();
+OPENCVFFMPEGTOOLS_API int AvJob_CurrentThreads();
+// 线程上限，<=0恢复为CPU核数
+OPENCVFFMPEGTOOLS_API void AvJob_SetThreadLimit(int limit);
+OPENCVFFMPEGTOOLS_API bool AvJob_GetSchedulerStats(AvSchedulerStats* stats);
+// 阻塞到作业结束，返回最终状态；id无效返回-1
+OPENCVFFMPEGTOOLS_API int AvJob_Wait(int job_id);
+// 释放已结束作业的记录，之后该id失效
+OPENCVFFMPEGTOOLS_API void AvJob_Release(int job_id);
+// 退出前调用：排队中的作业按取消结束，等待运行中的作业（cancel_running为true时先取消）并回收工作线程
+OPENCVFFMPEGTOOLS_API void AvJob_Shutdown(bool cancel_running);
+
+// ---- MediaIndex C API ----
+// 进程内共享的元数据索引，按文件大小/修改时间自动失效
+// 载入索引文件（不存在则新建），Flush时写回
+OPENCVFFMPEGTOOLS_API bool MediaIndex_Open(const char* index_path);
+OPENCVFFMPEGTOOLS_API bool MediaIndex_Flush();
+OPENCVFFMPEGTOOLS_API bool MediaIndex_GetInfo(const char* media_path, AvMediaInfo* info);
+// 返回关键帧总数（秒），最多写入max_count个到times；times可为NULL只取数量；失败返回-1
+OPENCVFFMPEGTOOLS_API int MediaIndex_GetKeyframes(const char* media_path, double* times, int max_count);
+// JPEG缩略图，*out_data用AvWorker_FreeBuffer释放
+OPENCVFFMPEGTOOLS_API bool MediaIndex_GetThumbnail(const char* media_path, unsigned char** out_data, int* out_size);
+OPENCVFFMPEGTOOLS_API void MediaIndex_Invalidate(const char* media_path);
+
+// ---- 媒体缓冲区复用层统计：累计实际分配次数，稳态逐帧处理时不应增长
+OPENCVFFMPEGTOOLS_API int64_t MediaBuffer_GetAllocCount();
+
 // ---- CvTranslator C API
 OPENCVFFMPEGTOOLS_API void* CvTranslator_Create();
 OPENCVFFMPEGTOOLS_API void CvTranslator_Destroy(void* translator);
@@ -73,13 +257,66 @@ OPENCVFFMPEGTOOLS_API void CvTranslator_Destroy(void* translator);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_GrayImage_File(void* translator, const char* input_path, const char* output_path);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_Invert_File(void* translator, const char* input_path, const char* output_path);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_FrostedGlass_File(void* translator, const char* input_path, const char* output_path);
+// 毛玻璃自检：固定种子输出与存档校验和比对（不一致返回false），并测1080p下改写前后的耗时（毫秒，可为NULL）
+OPENCVFFMPEGTOOLS_API bool CvTranslator_FrostedGlass_SelfTest(void* translator, double* before_ms, double* after_ms);
+// YUV直通对比：effect_type为灰度/反色/美白/美白2，width/height为偶数，frames<=0取100；
+// 输出BGR路径与YUV路径的fps，以及YUV路径相对BGR路径的PSNR（dB），指针可为NULL
+OPENCVFFMPEGTOOLS_API bool CvTranslator_BenchmarkYUV(void* translator, int effect_type, int width, int height,
+	int frames, double* bgr_fps, double* yuv_fps, double* psnr);
+// 磨皮快速模式对比：依次在1280x720、1920x1080、3840x2160上测，image_path给出时缩放到各尺寸，为NULL时用合成图；runs<=0取5。
+// 每个尺寸打印一行，输出数组各3项（按上述顺序）：原图双边滤波与快速模式的单帧平均耗时（毫秒），以及快速模式相对原图滤波的PSNR（dB），指针可为NULL
+OPENCVFFMPEGTOOLS_API bool CvTranslator_BenchmarkSkinSmoothing(void* translator, const char* image_path, int runs,
+	double* exact_ms, double* fast_ms, double* psnr);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_SkinSmoothing_File(void* translator, const char* input_path, const char* output_path);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_Whitening_File(void* translator, const char* input_path, const char* output_path);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_Whitening2_File(void* translator, const char* input_path, const char* output_path);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_OilPainting_File(void* translator, const char* input_path, const char* output_path, int radius, double sigma_color);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_Mosaic_File(void* translator, const char* input_path, const char* output_path, int x, int y, int w, int h, int cellSize);
+// lut为256字节的映射表，对所有通道生效
+OPENCVFFMPEGTOOLS_API bool CvTranslator_ApplyLut_File(void* translator, const char* input_path, const char* output_path, const unsigned char* lut);
+// rects为count组{x,y,w,h}，各块填充块内均值
+OPENCVFFMPEGTOOLS_API bool CvTranslator_MosaicRegions_File(void* translator, const char* input_path, const char* output_path, const int* rects, int count, int cellSize);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_AddTextWatermark_File(void* translator, const char* input_path, const char* output_path, const char* text);
 OPENCVFFMPEGTOOLS_API bool CvTranslator_AddTextWatermarkEx_File(void* translator, const char* input_path, const char* output_path, const char* text, int x, int y, double fontScale, int b, int g, int r, int thickness);
+// 批量处理：读文件、解码+特效链+编码、写文件三段流水线重叠执行，输出与输入同名写到output_dir（须已存在）下。
+// threads<=0取CPU核数（在作业中取分到的线程数）；max_inflight为已读入未写完的图片数上限，<=0取threads*2。
+// 返回失败的文件数，参数错误返回-1，通配符没有匹配返回-2
+OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessBatch(const char** input_paths, int count, const char* output_dir,
+	void* chain, int threads, int max_inflight, CvBatchCallback callback, void* user, CvBatchStats* stats);
+// pattern如 "D:/photos/*.jpg"
+OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessBatchGlob(const char* pattern, const char* output_dir,
+	void* chain, int threads, int max_inflight, CvBatchCallback callback, void* user, CvBatchStats* stats);
+// 超大图分块处理：按tile_size见方的块（四周按特效核半径重叠）读入、多线程处理、逐块写出，tile_size<=0取512。
+// 未压缩BMP和PGM/PPM按块读写，峰值内存与块大小成正比；其它格式整图解码/编码，只省去特效内部的整图拷贝。
+// 返回0成功；-1参数错误，-2打开输入失败，-3创建输出失败，-4处理失败，-5读写失败，-6已取消
+OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessTiled(const char* input_path, const char* output_path,
+	void* chain, int tile_size, int threads);
+
+// ---- 水印 C API ----
+// 文字/台标只栅格化一次为预乘alpha小图，逐帧只混合覆盖区域，开销与帧尺寸无关；可叠加多个，支持移动
+OPENCVFFMPEGTOOLS_API void* Watermark_Create();
+OPENCVFFMPEGTOOLS_API void Watermark_Destroy(void* watermark);
+// 返回水印id，失败返回-1；opacity为0~1
+OPENCVFFMPEGTOOLS_API int Watermark_AddText(void* watermark, const char* text, double font_scale,
+	int b, int g, int r, int thickness, double opacity);
+// 图片带alpha通道（PNG）时按其透明度混合
+OPENCVFFMPEGTOOLS_API int Watermark_AddImage(void* watermark, const char* image_path, double scale, double opacity);
+// 文字为基线左端，图片为左上角；负数表示距右/下边缘
+OPENCVFFMPEGTOOLS_API bool Watermark_SetPosition(void* watermark, int id, int x, int y);
+// 速度单位像素/秒；bounce为true时碰边反弹，否则移出后从另一侧进入
+OPENCVFFMPEGTOOLS_API bool Watermark_SetMotion(void* watermark, int id, double vx, double vy, bool bounce);
+
+// ---- EffectChain C API ----
+// 特效链：按添加顺序执行，相邻的反色/美白/美白2会合并为一次查表
+OPENCVFFMPEGTOOLS_API void* EffectChain_Create();
+OPENCVFFMPEGTOOLS_API void EffectChain_Destroy(void* chain);
+// 返回链上特效个数，失败返回-1
+OPENCVFFMPEGTOOLS_API int EffectChain_Add(void* chain, int effect_type, param m);
+// 追加自定义查表阶段（256字节），与相邻查表类特效合并
+OPENCVFFMPEGTOOLS_API int EffectChain_AddLut(void* chain, const unsigned char* lut);
+// 追加水印阶段，拷贝watermark的当前设置，之后可销毁watermark
+OPENCVFFMPEGTOOLS_API int EffectChain_AddWatermark(void* chain, void* watermark);
+OPENCVFFMPEGTOOLS_API void EffectChain_Clear(void* chain);
 
 // ---- FFmpegEncoder C API ----
 OPENCVFFMPEGTOOLS_API void* Encoder_Create();
@@ -94,6 +331,8 @@ OPENCVFFMPEGTOOLS_API void Decoder_Destroy(void* decoder);
 OPENCVFFMPEGTOOLS_API int Decoder_FFPlayerOpen(void* decoder, const char* input_path, int is_device);
 OPENCVFFMPEGTOOLS_API void Decoder_FFPlayerReadFrame(void* decoder);
 OPENCVFFMPEGTOOLS_API void Decoder_FFPlayerClose(void* decoder);
+// 跳转到指定毫秒，文件关键帧索引建好后定位到目标前的关键帧再解码到目标
+OPENCVFFMPEGTOOLS_API void Decoder_Seek(void* decoder, int64_t timestamp_ms);
 OPENCVFFMPEGTOOLS_API int64_t Decoder_GetDuration(void* decoder);
 OPENCVFFMPEGTOOLS_API int64_t Decoder_GetCurrentTime(void* decoder);
 OPENCVFFMPEGTOOLS_API int Decoder_GetWidth(void* decoder);
@@ -109,6 +348,17 @@ OPENCVFFMPEGTOOLS_API int VideoTrans_GetHeight(void* trans);
 OPENCVFFMPEGTOOLS_API int VideoTrans_GetFPS(void* trans);
 OPENCVFFMPEGTOOLS_API int64_t VideoTrans_GetDuration(void* trans);
 OPENCVFFMPEGTOOLS_API int VideoTrans_Process(void* trans, int effect_type, param m);
+// 多线程流水线版本：解码/特效/编码并行，threads<=0 时使用CPU核数
+OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessParallel(void* trans, int effect_type, param m, int threads);
+// 执行特效链，threads==1 为单线程，否则走流水线（threads<=0 时使用CPU核数）
+OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessChain(void* trans, void* chain, int threads);
+// 可续跑的特效链处理：每segment_seconds秒（<=0时为10秒）一个分段并写检查点，中断后重新初始化再调用即从检查点继续
+OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessResumable(void* trans, void* chain, int segment_seconds);
+// 线程数扫描：对thread_counts中的每个值（1为单线程，其余走流水线）各完整处理一遍并打印fps，fps可为NULL；
+// 须先Initialize，输出文件为最后一轮的结果
+OPENCVFFMPEGTOOLS_API int VideoTrans_BenchmarkThreads(void* trans, void* chain, const int* thread_counts, int count, double* fps);
+// 开关YUV直通路径（灰度/反色/美白/美白2），默认开启；关闭后走BGR路径，便于对比日志中的fps
+OPENCVFFMPEGTOOLS_API void VideoTrans_SetYuvFastPath(void* trans, bool enable);
 OPENCVFFMPEGTOOLS_API int VideoTrans_Reset(void* trans);
 OPENCVFFMPEGTOOLS_API void VideoTrans_Cleanup(void* trans);
 
@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "SliceScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+SliceScaler::SliceScaler()
+{
+}
+
+SliceScaler::~SliceScaler()
+{
+	release();
+}
+
+void SliceScaler::release()
+{
+	for (Band& band : m_bands) {
+		if (band.sws) sws_freeContext(band.sws);
+		if (band.scratch) av_frame_free(&band.scratch);
+	}
+	m_bands.clear();
+}
+
+int SliceScaler::sliceCount() const
+{
+	return static_cast<int>(m_bands.size());
+}
+
+bool SliceScaler::isBoundary(int d) const
+{
+	if (d <= 0 || d >= m_dstH) {
+		return true;
+	}
+	int64_t scaled = static_cast<int64_t>(d) * m_srcH;
+	if (scaled % m_dstH != 0) {
+		return false;
+	}
+	int s = static_cast<int>(scaled / m_dstH);
+	return (d & ((1 << m_dstChromaShift) - 1)) == 0 && (s & ((1 << m_srcChromaShift) - 1)) == 0;
+}
+
+int SliceScaler::boundaryAtOrBelow(int d) const
+{
+	d = std::max(0, std::min(d, m_dstH));
+	while (!isBoundary(d)) {
+		--d;
+	}
+	return d;
+}
+
+int SliceScaler::boundaryAtOrAbove(int d) const
+{
+	d = std::max(0, std::min(d, m_dstH));
+	while (!isBoundary(d)) {
+		++d;
+	}
+	return d;
+}
+
+// 按行偏移平面指针时，色度平面要按色度高度换算
+static bool is_chroma_plane(const AVPixFmtDescriptor* desc, int plane)
+{
+	return (plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+}
+
+// 能否按行切开：硬件帧、调色板格式的平面含义不同，不切
+static bool sliceable_format(const AVPixFmtDescriptor* desc)
+{
+	return desc && !(desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM));
+}
+
+bool SliceScaler::init(int srcW, int srcH, int srcFmt, int dstW, int dstH, int dstFmt, int flags, int slices)
+{
+	release();
+	if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) {
+		return false;
+	}
+	m_srcW = srcW;
+	m_srcH = srcH;
+	m_srcFmt = srcFmt;
+	m_dstW = dstW;
+	m_dstH = dstH;
+	m_dstFmt = dstFmt;
+
+	const AVPixFmtDescriptor* srcDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(srcFmt));
+	const AVPixFmtDescriptor* dstDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dstFmt));
+	m_srcChromaShift = srcDesc ? srcDesc->log2_chroma_h : 0;
+	m_dstChromaShift = dstDesc ? dstDesc->log2_chroma_h : 0;
+
+	if (slices <= 0) {
+		slices = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	// 条带过薄时余量占比太大，得不偿失
+	slices = std::max(1, std::min(slices, dstH / 32));
+	if (!sliceable_format(srcDesc) || !sliceable_format(dstDesc)) {
+		slices = 1;
+	}
+
+	std::vector<int> cuts;
+	cuts.push_back(0);
+	for (int k = 1; k < slices; ++k) {
+		int cut = boundaryAtOrBelow(static_cast<int>(static_cast<int64_t>(k) * dstH / slices));
+		if (cut > cuts.back()) {
+			cuts.push_back(cut);
+		}
+	}
+	cuts.push_back(dstH);
+
+	// 余量取滤波器支撑范围（以目标行计），放大时按源行间距换算
+	const int margin = static_cast<int>(std::ceil(4.0 * std::max(1.0, static_cast<double>(dstH) / srcH)));
+
+	for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+		Band band = { 0 };
+		band.dstBegin = cuts[i];
+		band.dstEnd = cuts[i + 1];
+		if (cuts.size() == 2) {
+			band.regionBegin = 0;
+			band.regionEnd = dstH;
+		}
+		else {
+			band.regionBegin = boundaryAtOrBelow(band.dstBegin - margin);
+			band.regionEnd = boundaryAtOrAbove(band.dstEnd + margin);
+		}
+		band.srcBegin = static_cast<int>(static_cast<int64_t>(band.regionBegin) * srcH / dstH);
+		band.srcEnd = static_cast<int>(static_cast<int64_t>(band.regionEnd) * srcH / dstH);
+
+		band.sws = sws_getContext(srcW, band.srcEnd - band.srcBegin, static_cast<AVPixelFormat>(srcFmt),
+			dstW, band.regionEnd - band.regionBegin, static_cast<AVPixelFormat>(dstFmt),
+			flags, nullptr, nullptr, nullptr);
+		if (!band.sws) {
+			m_bands.push_back(band);
+			release();
+			return false;
+		}
+
+		if (cuts.size() > 2) {
+			band.scratch = av_frame_alloc();
+			if (band.scratch) {
+				band.scratch->width = dstW;
+				band.scratch->height = band.regionEnd - band.regionBegin;
+				band.scratch->format = dstFmt;
+			}
+			if (!band.scratch || av_frame_get_buffer(band.scratch, 32) < 0) {
+				m_bands.push_back(band);
+				release();
+				return false;
+			}
+		}
+		m_bands.push_back(band);
+	}
+	return true;
+}
+
+bool SliceScaler::scale(const AVFrame* src, AVFrame* dst)
+{
+	if (m_bands.empty() || !src || !dst) {
+		return false;
+	}
+
+	// 单条带：与直接调用sws_scale相同
+	if (m_bands.size() == 1) {
+		return sws_scale(m_bands[0].sws, src->data, src->linesize, 0, m_srcH, dst->data, dst->linesize) > 0;
+	}
+
+	const AVPixFmtDescriptor* srcDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(m_srcFmt));
+	const AVPixFmtDescriptor* dstDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(m_dstFmt));
+	const int dstPlanes = av_pix_fmt_count_planes(static_cast<AVPixelFormat>(m_dstFmt));
+	int rowBytes[4] = { 0 };
+	av_image_fill_linesizes(rowBytes, static_cast<AVPixelFormat>(m_dstFmt), m_dstW);
+
+	std::atomic<bool> ok(true);
+	cv::parallel_for_(cv::Range(0, static_cast<int>(m_bands.size())), [&](const cv::Range& range) {
+		for (int i = range.start; i < range.end; ++i) {
+			Band& band = m_bands[i];
+
+			const uint8_t* srcPlanes[4] = { nullptr };
+			for (int p = 0; p < 4 && src->data[p]; ++p) {
+				int row = is_chroma_plane(srcDesc, p) ? (band.srcBegin >> m_srcChromaShift) : band.srcBegin;
+				srcPlanes[p] = src->data[p] + static_cast<ptrdiff_t>(row) * src->linesize[p];
+			}
+			if (sws_scale(band.sws, srcPlanes, src->linesize, 0, band.srcEnd - band.srcBegin,
+				band.scratch->data, band.scratch->linesize) <= 0) {
+				ok.store(false);
+				continue;
+			}
+
+			// 只拷回本条带负责的行，余量行丢弃
+			for (int p = 0; p < dstPlanes; ++p) {
+				int shift = is_chroma_plane(dstDesc, p) ? m_dstChromaShift : 0;
+				int begin = band.dstBegin >> shift;
+				int end = -((-band.dstEnd) >> shift);
+				int offset = (band.dstBegin - band.regionBegin) >> shift;
+				av_image_copy_plane(dst->data[p] + static_cast<ptrdiff_t>(begin) * dst->linesize[p], dst->linesize[p],
+					band.scratch->data[p] + static_cast<ptrdiff_t>(offset) * band.scratch->linesize[p], band.scratch->linesize[p],
+					rowBytes[p], end - begin);
+			}
+		}
+	});
+	return ok.load();
+}
@@ -0,0 +1,74 @@
+/*****************************************************************//**
+ * \file   SliceScaler.h
+ * \brief  按水平条带并行的sws缩放
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <vector>
+
+struct AVFrame;
+struct SwsContext;
+
+// 把一帧按目标行切成若干条带，每个条带独立的SwsContext并行缩放。
+// 条带边界取在源/目标行严格成比例的位置，并向两侧多缩放几行再裁掉，
+// 拼缝处滤波取到的是真实相邻像素而不是边缘复制
+class SliceScaler
+{
+public:
+	SliceScaler();
+	~SliceScaler();
+	SliceScaler(const SliceScaler&) = delete;
+	SliceScaler& operator=(const SliceScaler&) = delete;
+
+	/**
+	 * @brief 初始化.
+	 *
+	 * 找不到合适的切分位置（比例除不尽、非平面格式）时退化为单条带
+	 * \param slices 期望条带数，<=0 时使用CPU核数
+	 * \param flags SWS_BILINEAR等
+	 * \return 成功返回true
+	 */
+	bool init(int srcW, int srcH, int srcFmt, int dstW, int dstH, int dstFmt, int flags, int slices);
+	void release();
+
+	/**
+	 * @brief 缩放一帧.
+	 *
+	 * \param src 尺寸/格式须与init一致
+	 * \param dst 已分配好缓冲区的目标帧
+	 * \return 成功返回true
+	 */
+	bool scale(const AVFrame* src, AVFrame* dst);
+
+	// 实际条带数
+	int sliceCount() const;
+
+private:
+	struct Band {
+		int dstBegin;    // 本条带负责写出的目标行 [dstBegin, dstEnd)
+		int dstEnd;
+		int regionBegin; // 实际缩放的目标行范围（含上下余量）
+		int regionEnd;
+		int srcBegin;    // 对应的源行范围
+		int srcEnd;
+		SwsContext* sws;
+		AVFrame* scratch; // 含余量的条带输出，裁剪后拷入dst
+	};
+
+	// 目标行d能否作为切分点：源行与之严格成比例，且两侧色度行对齐
+	bool isBoundary(int d) const;
+	int boundaryAtOrBelow(int d) const;
+	int boundaryAtOrAbove(int d) const;
+
+	std::vector<Band> m_bands;
+	int m_srcW = 0;
+	int m_srcH = 0;
+	int m_srcFmt = -1;
+	int m_dstW = 0;
+	int m_dstH = 0;
+	int m_dstFmt = -1;
+	int m_srcChromaShift = 0;
+	int m_dstChromaShift = 0;
+};
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "StreamPassthrough.h"
+#include "AudioTranscoder.h"
+
+StreamPassthrough::StreamPassthrough()
+{
+}
+
+StreamPassthrough::~StreamPassthrough()
+{
+}
+
+// 以输入的采样率/声道构造容器默认音频编码的目标参数
+static bool target_audio_params(const AVCodecParameters* in, AVCodecID codec_id, AVCodecParameters* ref)
+{
+	AVCodec* encoder = avcodec_find_encoder(codec_id);
+	if (!encoder) return false;
+	ref->codec_type = AVMEDIA_TYPE_AUDIO;
+	ref->codec_id = codec_id;
+	ref->format = encoder->sample_fmts ? encoder->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+	ref->sample_rate = in->sample_rate;
+	if (encoder->supported_samplerates) {
+		// 编码器不支持原采样率时取最接近的
+		int best = encoder->supported_samplerates[0];
+		for (const int* r = encoder->supported_samplerates; *r; ++r) {
+			if (std::abs(*r - in->sample_rate) < std::abs(best - in->sample_rate)) best = *r;
+		}
+		ref->sample_rate = best;
+	}
+	ref->channels = in->channels > 0 ? in->channels : 2;
+	ref->channel_layout = in->channel_layout ? in->channel_layout : av_get_default_channel_layout(ref->channels);
+	ref->bit_rate = 128000;
+	ref->profile = FF_PROFILE_UNKNOWN;
+	return ref->sample_rate > 0;
+}
+
+int StreamPassthrough::addStreams(AVFormatContext* in, AVFormatContext* out, int64_t offset)
+{
+	m_out = out;
+	m_offset = offset;
+	m_routes.clear();
+	m_routes.resize(in->nb_streams);
+	const bool global_header = (out->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+	int added = 0;
+	for (unsigned int i = 0; i < in->nb_streams; ++i) {
+		AVStream* in_stream = in->streams[i];
+		AVCodecParameters* par = in_stream->codecpar;
+		if (par->codec_type != AVMEDIA_TYPE_AUDIO && par->codec_type != AVMEDIA_TYPE_SUBTITLE) {
+			continue;
+		}
+		// 附带的封面图等不直通
+		if (in_stream->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+			continue;
+		}
+
+		// 只有明确返回0才是容器不支持；负值表示容器未声明，与ffmpeg一样按可直通处理
+		bool copy = avformat_query_codec(out->oformat, par->codec_id, FF_COMPLIANCE_NORMAL) != 0;
+		std::unique_ptr<AudioTranscoder> transcoder;
+		AVCodecParameters* ref = nullptr;
+		if (!copy) {
+			if (par->codec_type != AVMEDIA_TYPE_AUDIO || out->oformat->audio_codec == AV_CODEC_ID_NONE) {
+				std::cerr << "[warn] stream " << i << " codec " << avcodec_get_name(par->codec_id)
+					<< " not supported by " << out->oformat->name << ", dropped" << std::endl;
+				continue;
+			}
+			ref = avcodec_parameters_alloc();
+			transcoder.reset(new AudioTranscoder());
+			if (!ref || !target_audio_params(par, out->oformat->audio_codec, ref) ||
+				!transcoder->open(in_stream, ref, global_header)) {
+				std::cerr << "[warn] fair to transcode audio stream " << i << ", dropped" << std::endl;
+				avcodec_parameters_free(&ref);
+				continue;
+			}
+			avcodec_parameters_free(&ref);
+		}
+
+		AVStream* out_stream = avformat_new_stream(out, nullptr);
+		if (!out_stream) {
+			continue;
+		}
+		if (copy) {
+			if (avcodec_parameters_copy(out_stream->codecpar, par) < 0) {
+				continue;
+			}
+			out_stream->codecpar->codec_tag = 0;
+			out_stream->time_base = in_stream->time_base;
+			m_copied++;
+		}
+		else {
+			if (avcodec_parameters_from_context(out_stream->codecpar, transcoder->enc) < 0) {
+				continue;
+			}
+			out_stream->time_base = transcoder->enc->time_base;
+			m_routes[i].transcoder = std::move(transcoder);
+			m_transcoded++;
+		}
+		out_stream->disposition = in_stream->disposition;
+		av_dict_copy(&out_stream->metadata, in_stream->metadata, 0);
+		m_routes[i].out_index = out_stream->index;
+		m_routes[i].in_tb_num = in_stream->time_base.num;
+		m_routes[i].in_tb_den = in_stream->time_base.den;
+		added++;
+	}
+	return added;
+}
+
+bool StreamPassthrough::handles(int in_index) const
+{
+	return in_index >= 0 && in_index < static_cast<int>(m_routes.size()) && m_routes[in_index].out_index >= 0;
+}
+
+int StreamPassthrough::writeLocked(AVPacket* pkt, int in_index)
+{
+	Route& route = m_routes[in_index];
+	AVStream* out_stream = m_out->streams[route.out_index];
+	AVRational in_tb = route.transcoder ? route.transcoder->enc->time_base : av_make_q(route.in_tb_num, route.in_tb_den);
+	int64_t offset = av_rescale_q(m_offset, AV_TIME_BASE_Q, in_tb);
+
+	if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= offset;
+	if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= offset;
+	// 视频从0计时时，起点之前的音频丢弃
+	if (pkt->dts != AV_NOPTS_VALUE && pkt->dts < 0 && m_offset > 0) {
+		av_packet_unref(pkt);
+		return 0;
+	}
+	av_packet_rescale_ts(pkt, in_tb, out_stream->time_base);
+	pkt->stream_index = route.out_index;
+	pkt->pos = -1;
+	return av_interleaved_write_frame(m_out, pkt);
+}
+
+int StreamPassthrough::write(AVPacket* pkt)
+{
+	int in_index = pkt->stream_index;
+	if (!handles(in_index)) {
+		av_packet_unref(pkt);
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mtx);
+	Route& route = m_routes[in_index];
+	if (!route.transcoder) {
+		int ret = writeLocked(pkt, in_index);
+		av_packet_unref(pkt);
+		return ret;
+	}
+
+	int ret = 0;
+	route.transcoder->feed(pkt, av_make_q(route.in_tb_num, route.in_tb_den), [&](AVPacket* out, AVRational) {
+		int r = writeLocked(out, in_index);
+		if (r < 0) ret = r;
+	});
+	av_packet_unref(pkt);
+	return ret;
+}
+
+void StreamPassthrough::flush()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	for (size_t i = 0; i < m_routes.size(); ++i) {
+		if (!m_routes[i].transcoder) continue;
+		int in_index = static_cast<int>(i);
+		m_routes[i].transcoder->feed(nullptr, av_make_q(m_routes[i].in_tb_num, m_routes[i].in_tb_den), [&](AVPacket* out, AVRational) {
+			writeLocked(out, in_index);
+		});
+	}
+}
@@ -0,0 +1,75 @@
+/*****************************************************************//**
+ * \file   StreamPassthrough.h
+ * \brief  只处理视频的流水线中把音频/字幕流原样复制进同一个输出文件
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct AVFormatContext;
+struct AVPacket;
+struct AudioTranscoder;
+
+// 音频/字幕直通
+// 写文件头之前按输入建立输出流：编码被输出容器支持时直接复制数据包，
+// 音频不被支持时重编码为容器默认音频编码，字幕不被支持时丢弃。
+// 数据包经av_interleaved_write_frame写入，由封装器按dts交错
+class StreamPassthrough
+{
+public:
+	StreamPassthrough();
+	~StreamPassthrough();
+	StreamPassthrough(const StreamPassthrough&) = delete;
+	StreamPassthrough& operator=(const StreamPassthrough&) = delete;
+
+	/**
+	 * @brief 为输入中的音频/字幕流建立输出流，须在avformat_write_header之前调用.
+	 *
+	 * \param in 输入封装
+	 * \param out 输出封装
+	 * \param offset 从输入时间戳中减去的量（AV_TIME_BASE单位），视频重新从0计时时传入视频的起始时间
+	 * \return 建立的输出流个数
+	 */
+	int addStreams(AVFormatContext* in, AVFormatContext* out, int64_t offset);
+
+	// 该输入流是否直通
+	bool handles(int in_index) const;
+
+	/**
+	 * @brief 写入一个输入包（会被unref），不直通的流直接忽略.
+	 *
+	 * \param pkt 输入包
+	 * \return 成功返回0，失败返回负数
+	 */
+	int write(AVPacket* pkt);
+
+	// 写trailer之前调用，冲刷音频重编码器
+	void flush();
+
+	// 写视频包时也要持有这把锁，与write()所在线程互斥
+	std::mutex& muxMutex() { return m_mtx; }
+
+	int copiedStreams() const { return m_copied; }
+	int transcodedStreams() const { return m_transcoded; }
+
+private:
+	struct Route {
+		int out_index = -1;
+		int in_tb_num = 0;       // 输入流时间基，不保留输入封装指针（解码器可能重新打开）
+		int in_tb_den = 1;
+		std::unique_ptr<AudioTranscoder> transcoder;
+	};
+
+	int writeLocked(AVPacket* pkt, int in_index);
+
+	AVFormatContext* m_out = nullptr;
+	std::vector<Route> m_routes; // 按输入流下标
+	int64_t m_offset = 0;
+	std::mutex m_mtx;
+	int m_copied = 0;
+	int m_transcoded = 0;
+};
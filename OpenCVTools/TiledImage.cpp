@@ -0,0 +1,502 @@
+#include "pch.h"
+#include "TiledImage.h"
+#include "CvTranslator.h"
+#include "AvJob.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static std::string lower_extension(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return std::string();
+	}
+	std::string ext = path.substr(dot);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return ext;
+}
+
+static uint32_t read_le32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void write_le16(unsigned char* p, uint16_t v)
+{
+	p[0] = static_cast<unsigned char>(v);
+	p[1] = static_cast<unsigned char>(v >> 8);
+}
+
+static void write_le32(unsigned char* p, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i) {
+		p[i] = static_cast<unsigned char>(v >> (8 * i));
+	}
+}
+
+// -------------------- 按行定位的未压缩文件 --------------------
+// BMP和PNM的像素都是定长的行，块的每一行都能直接定位读写
+struct RasterLayout {
+	int width = 0;
+	int height = 0;
+	int channels = 0;     // 文件中每像素字节数
+	int64_t offset = 0;   // 像素数据起点
+	int64_t stride = 0;   // 每行字节数（含BMP行尾填充）
+	bool bottomUp = false;
+	bool rgb = false;     // PPM为RGB顺序，需要与BGR互换
+
+	int64_t rowOffset(int y) const
+	{
+		return offset + static_cast<int64_t>(bottomUp ? height - 1 - y : y) * stride;
+	}
+};
+
+class RasterTileSource : public TileSource
+{
+public:
+	RasterTileSource(std::ifstream&& in, const RasterLayout& layout)
+		: m_in(std::move(in))
+		, m_layout(layout)
+	{
+	}
+
+	// 与cvtranslator_imread的IMREAD_COLOR一致，统一输出3通道BGR
+	int width() const override { return m_layout.width; }
+	int height() const override { return m_layout.height; }
+	int channels() const override { return 3; }
+	bool streaming() const override { return true; }
+
+	bool read(const cv::Rect& rect, cv::Mat& out) override
+	{
+		const int cn = m_layout.channels;
+		cv::Mat raw(rect.height, rect.width, CV_MAKETYPE(CV_8U, cn));
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			for (int y = 0; y < rect.height; ++y) {
+				m_in.seekg(m_layout.rowOffset(rect.y + y) + static_cast<int64_t>(rect.x) * cn);
+				if (!m_in.read(reinterpret_cast<char*>(raw.ptr<uchar>(y)), static_cast<std::streamsize>(rect.width) * cn)) {
+					m_in.clear();
+					return false;
+				}
+			}
+		}
+		if (cn == 1) {
+			cv::cvtColor(raw, out, cv::COLOR_GRAY2BGR);
+		}
+		else if (cn == 4) {
+			cv::cvtColor(raw, out, cv::COLOR_BGRA2BGR);
+		}
+		else if (m_layout.rgb) {
+			cv::cvtColor(raw, out, cv::COLOR_RGB2BGR);
+		}
+		else {
+			out = raw;
+		}
+		return true;
+	}
+
+private:
+	std::ifstream m_in;
+	RasterLayout m_layout;
+	std::mutex m_mtx;
+};
+
+class RasterTileSink : public TileSink
+{
+public:
+	explicit RasterTileSink(const std::string& path)
+		: m_path(path)
+		, m_pnm(lower_extension(path) != ".bmp")
+	{
+	}
+
+	bool streaming() const override { return true; }
+
+	bool create(int width, int height, int channels) override
+	{
+		if (width <= 0 || height <= 0 || (channels != 1 && channels != 3 && channels != 4) || (m_pnm && channels == 4)) {
+			std::cerr << "tile sink unsupported channels " << channels << " for " << m_path << std::endl;
+			return false;
+		}
+		std::vector<unsigned char> header;
+		m_layout.width = width;
+		m_layout.height = height;
+		m_layout.channels = channels;
+		if (m_pnm) {
+			std::string text = std::string(channels == 1 ? "P5" : "P6") + "\n" +
+				std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+			header.assign(text.begin(), text.end());
+			m_layout.stride = static_cast<int64_t>(width) * channels;
+			m_layout.rgb = true;
+		}
+		else {
+			// 高度写成负数表示自上而下存储，行序与块的行序一致
+			const int paletteSize = channels == 1 ? 256 * 4 : 0;
+			m_layout.stride = (static_cast<int64_t>(width) * channels + 3) & ~3LL;
+			const int64_t dataSize = m_layout.stride * height;
+			const int64_t fileSize = 54 + paletteSize + dataSize;
+			if (fileSize > 0xFFFFFFFFLL) {
+				std::cerr << "bmp larger than 4GB, use .ppm instead" << std::endl;
+				return false;
+			}
+			header.assign(54 + paletteSize, 0);
+			header[0] = 'B';
+			header[1] = 'M';
+			write_le32(&header[2], static_cast<uint32_t>(fileSize));
+			write_le32(&header[10], static_cast<uint32_t>(54 + paletteSize));
+			write_le32(&header[14], 40);
+			write_le32(&header[18], static_cast<uint32_t>(width));
+			write_le32(&header[22], static_cast<uint32_t>(-height));
+			write_le16(&header[26], 1);
+			write_le16(&header[28], static_cast<uint16_t>(channels * 8));
+			write_le32(&header[34], static_cast<uint32_t>(dataSize));
+			for (int i = 0; i < paletteSize / 4; ++i) {
+				header[54 + i * 4] = header[55 + i * 4] = header[56 + i * 4] = static_cast<unsigned char>(i);
+			}
+		}
+		m_layout.offset = static_cast<int64_t>(header.size());
+
+		m_out.open(m_path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+		if (!m_out) {
+			return false;
+		}
+		m_out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		// 先把文件扩到最终大小，各块再定位写入
+		m_out.seekp(m_layout.offset + m_layout.stride * height - 1);
+		m_out.put('\0');
+		return static_cast<bool>(m_out);
+	}
+
+	bool write(const cv::Point& at, const cv::Mat& tile) override
+	{
+		const int cn = m_layout.channels;
+		cv::Mat data = tile;
+		if (m_layout.rgb && cn == 3) {
+			cv::cvtColor(tile, data, cv::COLOR_BGR2RGB);
+		}
+		std::lock_guard<std::mutex> lock(m_mtx);
+		for (int y = 0; y < data.rows; ++y) {
+			m_out.seekp(m_layout.rowOffset(at.y + y) + static_cast<int64_t>(at.x) * cn);
+			m_out.write(reinterpret_cast<const char*>(data.ptr<uchar>(y)), static_cast<std::streamsize>(data.cols) * cn);
+		}
+		return static_cast<bool>(m_out);
+	}
+
+	bool close() override
+	{
+		m_out.close();
+		return !m_out.fail();
+	}
+
+private:
+	std::string m_path;
+	bool m_pnm;
+	RasterLayout m_layout;
+	std::fstream m_out;
+	std::mutex m_mtx;
+};
+
+// -------------------- 整图在内存中的回退实现 --------------------
+class MatTileSource : public TileSource
+{
+public:
+	explicit MatTileSource(const cv::Mat& image) : m_image(image) {}
+
+	int width() const override { return m_image.cols; }
+	int height() const override { return m_image.rows; }
+	int channels() const override { return m_image.channels(); }
+	bool streaming() const override { return false; }
+
+	bool read(const cv::Rect& rect, cv::Mat& out) override
+	{
+		// 只读共享，不拷贝；各特效在块上clone的只是块大小
+		out = m_image(rect);
+		return true;
+	}
+
+private:
+	cv::Mat m_image;
+};
+
+class MatTileSink : public TileSink
+{
+public:
+	explicit MatTileSink(const std::string& path) : m_path(path) {}
+
+	bool streaming() const override { return false; }
+
+	bool create(int width, int height, int channels) override
+	{
+		m_image.create(height, width, CV_MAKETYPE(CV_8U, channels));
+		return true;
+	}
+
+	bool write(const cv::Point& at, const cv::Mat& tile) override
+	{
+		// 块互不重叠，各线程写不同区域，无需加锁
+		tile.copyTo(m_image(cv::Rect(at.x, at.y, tile.cols, tile.rows)));
+		return true;
+	}
+
+	bool close() override
+	{
+		return cv::imwrite(m_path, m_image);
+	}
+
+private:
+	std::string m_path;
+	cv::Mat m_image;
+};
+
+// 解析PNM头中的一个数，跳过空白和#注释
+static bool pnm_read_int(std::istream& in, int& value)
+{
+	int c = in.get();
+	while (c != EOF) {
+		if (c == '#') {
+			while (c != EOF && c != '\n') c = in.get();
+		}
+		else if (!std::isspace(c)) {
+			break;
+		}
+		c = in.get();
+	}
+	if (c == EOF || !std::isdigit(c)) {
+		return false;
+	}
+	value = 0;
+	while (c != EOF && std::isdigit(c)) {
+		value = value * 10 + (c - '0');
+		c = in.get();
+	}
+	// 数字后紧跟的一个空白属于头部
+	return true;
+}
+
+static bool parse_bmp(std::ifstream& in, RasterLayout& layout)
+{
+	unsigned char header[54];
+	if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 'B' || header[1] != 'M') {
+		return false;
+	}
+	const int bpp = header[28] | (header[29] << 8);
+	const uint32_t compression = read_le32(&header[30]);
+	int32_t height = static_cast<int32_t>(read_le32(&header[22]));
+	layout.width = static_cast<int32_t>(read_le32(&header[18]));
+	layout.height = height < 0 ? -height : height;
+	layout.bottomUp = height > 0;
+	layout.offset = read_le32(&header[10]);
+	if (compression != 0 || (bpp != 24 && bpp != 32) || layout.width <= 0 || layout.height <= 0) {
+		return false; // 调色板/压缩格式走整图解码
+	}
+	layout.channels = bpp / 8;
+	layout.stride = (static_cast<int64_t>(layout.width) * layout.channels + 3) & ~3LL;
+	return true;
+}
+
+static bool parse_pnm(std::ifstream& in, RasterLayout& layout)
+{
+	char magic[2];
+	if (!in.read(magic, 2) || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+		return false;
+	}
+	int maxval = 0;
+	if (!pnm_read_int(in, layout.width) || !pnm_read_int(in, layout.height) || !pnm_read_int(in, maxval) || maxval != 255) {
+		return false; // 16位PNM走整图解码
+	}
+	layout.channels = magic[1] == '5' ? 1 : 3;
+	layout.offset = static_cast<int64_t>(in.tellg());
+	layout.stride = static_cast<int64_t>(layout.width) * layout.channels;
+	layout.rgb = true;
+	return layout.width > 0 && layout.height > 0;
+}
+
+std::unique_ptr<TileSource> open_tile_source(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		return nullptr;
+	}
+	RasterLayout layout;
+	std::string ext = lower_extension(path);
+	bool ok = false;
+	if (ext == ".bmp" || ext == ".dib") {
+		ok = parse_bmp(in, layout);
+	}
+	else if (ext == ".pgm" || ext == ".ppm" || ext == ".pnm") {
+		ok = parse_pnm(in, layout);
+	}
+	if (ok) {
+		in.clear();
+		return std::unique_ptr<TileSource>(new RasterTileSource(std::move(in), layout));
+	}
+
+	in.close();
+	std::cout << "[warn] " << path << " can not be read by tile, decode whole image" << std::endl;
+	cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+	if (image.empty()) {
+		return nullptr;
+	}
+	return std::unique_ptr<TileSource>(new MatTileSource(image));
+}
+
+std::unique_ptr<TileSink> create_tile_sink(const std::string& path)
+{
+	std::string ext = lower_extension(path);
+	if (ext == ".bmp" || ext == ".pgm" || ext == ".ppm" || ext == ".pnm") {
+		return std::unique_ptr<TileSink>(new RasterTileSink(path));
+	}
+	return std::unique_ptr<TileSink>(new MatTileSink(path));
+}
+
+// -------------------- TiledProcessor --------------------
+TiledProcessor::TiledProcessor(const EffectChain& chain, int tileSize, int threads)
+	: m_chain(chain)
+	, m_tileSize(tileSize > 0 ? (tileSize + 1) & ~1 : 512)
+	, m_threads(threads)
+{
+	if (m_threads <= 0) {
+		m_threads = avjob_threads();
+		if (m_threads <= 0) {
+			m_threads = static_cast<int>(std::thread::hardware_concurrency());
+		}
+		if (m_threads <= 0) {
+			m_threads = 1;
+		}
+	}
+}
+
+int TiledProcessor::outputChannels(int inputChannels)
+{
+	CvTranslator translator;
+	cv::Mat probe(32, 32, CV_MAKETYPE(CV_8U, inputChannels), cv::Scalar::all(128));
+	cv::Mat result = m_chain.apply(translator, probe);
+	return result.empty() ? 0 : result.channels();
+}
+
+int TiledProcessor::run(const std::string& input, const std::string& output)
+{
+	if (input.empty() || output.empty() || input == output) {
+		return -1;
+	}
+	std::unique_ptr<TileSource> source = open_tile_source(input);
+	if (!source) {
+		std::cerr << "open tile source fair: " << input << std::endl;
+		return -2;
+	}
+	const int width = source->width();
+	const int height = source->height();
+	int outChannels = 0;
+	try {
+		outChannels = outputChannels(source->channels());
+	}
+	catch (const std::exception& e) {
+		std::cerr << "tiled effect fair: " << e.what() << std::endl;
+	}
+	std::unique_ptr<TileSink> sink = create_tile_sink(output);
+	if (outChannels <= 0 || !sink->create(width, height, outChannels)) {
+		std::cerr << "create tile sink fair: " << output << std::endl;
+		return -3;
+	}
+
+	const int halo = m_chain.haloRadius();
+	const int tilesX = (width + m_tileSize - 1) / m_tileSize;
+	const int tilesY = (height + m_tileSize - 1) / m_tileSize;
+	const int tileCount = tilesX * tilesY;
+	const int workerCount = std::min(m_threads, tileCount);
+	std::atomic<int> nextTile(0);
+	std::atomic<int> doneTiles(0);
+	std::atomic<int> error(0);
+	auto beginTime = std::chrono::steady_clock::now();
+
+	// 作业上下文是线程局部的，进度和取消由当前线程汇总
+	std::vector<std::thread> workers;
+	for (int t = 0; t < workerCount; ++t) {
+		workers.emplace_back([&]() {
+			CvTranslator translator;
+			EffectChain chain = m_chain;
+			cv::Mat buffer;
+			int index;
+			while (error.load() == 0 && (index = nextTile.fetch_add(1)) < tileCount) {
+				// 按行优先取块，写出大致自上而下推进
+				const cv::Rect core((index % tilesX) * m_tileSize, (index / tilesX) * m_tileSize,
+					std::min(m_tileSize, width - (index % tilesX) * m_tileSize),
+					std::min(m_tileSize, height - (index / tilesX) * m_tileSize));
+				const int x0 = std::max(0, core.x - halo);
+				const int y0 = std::max(0, core.y - halo);
+				const int x1 = std::min(width, core.x + core.width + halo);
+				const int y1 = std::min(height, core.y + core.height + halo);
+				const cv::Rect outer(x0, y0, x1 - x0, y1 - y0);
+
+				if (!source->read(outer, buffer)) {
+					error.store(-5);
+					break;
+				}
+				cv::Mat result;
+				try {
+					// 整图源返回的是共享视图；applyTile只在原地处理的特效前复制，不改写它
+					result = chain.applyTile(translator, buffer, outer.tl(), cv::Size(width, height));
+				}
+				catch (const std::exception& e) {
+					std::cerr << "tiled effect fair: " << e.what() << std::endl;
+				}
+				if (result.empty() || result.size() != outer.size() || result.channels() != outChannels) {
+					error.store(-4);
+					break;
+				}
+				cv::Mat coreResult = result(cv::Rect(core.x - x0, core.y - y0, core.width, core.height));
+				if (!sink->write(core.tl(), coreResult)) {
+					error.store(-5);
+					break;
+				}
+				doneTiles.fetch_add(1);
+			}
+		});
+	}
+
+	while (doneTiles.load() < tileCount && error.load() == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		avjob_report(doneTiles.load(), 0);
+		if (avjob_cancelled()) {
+			error.store(-6);
+		}
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	bool closed = sink->close();
+	int ret = error.load();
+	if (ret == 0 && !closed) {
+		ret = -5;
+	}
+	if (ret != 0) {
+		std::remove(output.c_str());
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+	const int64_t bufferSide = m_tileSize + 2 * halo;
+	std::cout << "[info] tiled " << width << "x" << height << " tile:" << m_tileSize << " halo:" << halo
+		<< " tiles:" << tileCount << " threads:" << workerCount
+		<< " streaming in/out:" << source->streaming() << "/" << sink->streaming()
+		<< " tile buffer MB:" << (bufferSide * bufferSide * source->channels() * workerCount) / (1024.0 * 1024.0)
+		<< " seconds:" << seconds << " ret:" << ret << std::endl;
+	return ret;
+}
+
+// -------------------- 分块处理 C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API int CvTranslator_ProcessTiled(const char* input_path, const char* output_path,
+	void* chain, int tile_size, int threads)
+{
+	if (!input_path || !output_path || !chain) return -1;
+	TiledProcessor processor(*static_cast<EffectChain*>(chain), tile_size, threads);
+	return processor.run(input_path, output_path);
+}
@@ -0,0 +1,80 @@
+/*****************************************************************//**
+ * \file   TiledImage.h
+ * \brief  超大图片分块处理：按块随机读写文件，多线程处理带重叠边的块
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+
+#include "EffectChain.h"
+
+// 可按矩形读取的图片源，read可被多个线程同时调用
+class TileSource
+{
+public:
+	virtual ~TileSource() {}
+	virtual int width() const = 0;
+	virtual int height() const = 0;
+	virtual int channels() const = 0;
+	// rect须在图片范围内，out为rect大小的CV_8UC(channels)
+	virtual bool read(const cv::Rect& rect, cv::Mat& out) = 0;
+	// 是否真正按块从文件读取（否则整图已在内存中）
+	virtual bool streaming() const = 0;
+};
+
+// 可按块写入的图片输出，write可被多个线程同时调用，块之间不重叠
+class TileSink
+{
+public:
+	virtual ~TileSink() {}
+	virtual bool create(int width, int height, int channels) = 0;
+	virtual bool write(const cv::Point& at, const cv::Mat& tile) = 0;
+	virtual bool close() = 0;
+	virtual bool streaming() const = 0;
+};
+
+/**
+ * @brief 打开输入.
+ *
+ * 未压缩的24/32位BMP和P5/P6格式的PGM/PPM按块读取；其它格式整图解码后按块提供
+ * \return 打开失败返回空
+ */
+std::unique_ptr<TileSource> open_tile_source(const std::string& path);
+/**
+ * @brief 按扩展名创建输出.
+ *
+ * .bmp/.pgm/.ppm/.pnm按块写入预先分配好大小的文件；其它格式在内存中拼整图，close时编码
+ */
+std::unique_ptr<TileSink> create_tile_sink(const std::string& path);
+
+class TiledProcessor
+{
+public:
+	/**
+	 * \param chain 特效链，每个线程各拷贝一份
+	 * \param tileSize 块边长（不含重叠边），<=0取512
+	 * \param threads 处理线程数，<=0时取调度器分到的线程数或CPU核数
+	 */
+	TiledProcessor(const EffectChain& chain, int tileSize, int threads);
+
+	/**
+	 * @brief 分块处理一个文件.
+	 *
+	 * 每块四周按特效链的haloRadius()外扩读取，处理后只写回块本身。
+	 * 输入输出都按块读写时，峰值内存约为 线程数 x (tileSize + 2 x halo)^2 个像素
+	 * \return 0成功；-1参数错误，-2打开输入失败，-3创建输出失败，-4处理失败，-5读写失败，-6已取消
+	 */
+	int run(const std::string& input, const std::string& output);
+
+private:
+	// 用小图试跑一次特效链，得到输出通道数
+	int outputChannels(int inputChannels);
+
+	EffectChain m_chain;
+	int m_tileSize;
+	int m_threads;
+};
@@ -0,0 +1,240 @@
+#include "pch.h"
+#include "Watermark.h"
+#include "OpenCVFFMpegTools.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+
+WatermarkEngine::WatermarkEngine()
+{
+}
+
+void WatermarkEngine::premultiply(const cv::Mat& bgr, const cv::Mat& alpha, Sprite& sprite)
+{
+	sprite.premul.create(bgr.size(), CV_8UC3);
+	sprite.inverse.create(bgr.size(), CV_8UC3);
+	for (int y = 0; y < bgr.rows; ++y) {
+		const uchar* src = bgr.ptr<uchar>(y);
+		const uchar* a = alpha.ptr<uchar>(y);
+		uchar* pre = sprite.premul.ptr<uchar>(y);
+		uchar* inv = sprite.inverse.ptr<uchar>(y);
+		for (int x = 0; x < bgr.cols; ++x) {
+			for (int c = 0; c < 3; ++c) {
+				pre[x * 3 + c] = static_cast<uchar>((src[x * 3 + c] * a[x] + 127) / 255);
+				inv[x * 3 + c] = static_cast<uchar>(255 - a[x]);
+			}
+		}
+	}
+}
+
+int WatermarkEngine::addText(const std::string& text, double fontScale, const cv::Scalar& color, int thickness, double opacity)
+{
+	if (text.empty() || fontScale <= 0) {
+		return -1;
+	}
+	const int fontFace = cv::FONT_HERSHEY_SIMPLEX;
+	int baseline = 0;
+	cv::Size textSize = cv::getTextSize(text, fontFace, fontScale, thickness, &baseline);
+	const int pad = thickness + 1;
+
+	// 白字画在黑底上，抗锯齿后的灰度即覆盖率
+	Sprite sprite;
+	sprite.anchor = cv::Point(pad, pad + textSize.height);
+	cv::Mat coverage = cv::Mat::zeros(textSize.height + baseline + 2 * pad, textSize.width + 2 * pad, CV_8UC1);
+	cv::putText(coverage, text, sprite.anchor, fontFace, fontScale, cv::Scalar(255), thickness, cv::LINE_AA);
+	if (opacity < 1.0) {
+		coverage.convertTo(coverage, CV_8U, std::max(0.0, opacity));
+	}
+
+	cv::Mat bgr(coverage.size(), CV_8UC3, color);
+	premultiply(bgr, coverage, sprite);
+	// 与原putText默认位置一致
+	sprite.position = cv::Point2d(50, 50);
+	m_marks.push_back(sprite);
+	return static_cast<int>(m_marks.size()) - 1;
+}
+
+int WatermarkEngine::addImage(const cv::Mat& image, double scale, double opacity)
+{
+	if (image.empty() || image.depth() != CV_8U || (image.channels() != 3 && image.channels() != 4) || scale <= 0) {
+		return -1;
+	}
+	cv::Mat src = image;
+	if (scale != 1.0) {
+		cv::resize(image, src, cv::Size(), scale, scale, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+		if (src.empty()) {
+			return -1;
+		}
+	}
+
+	cv::Mat bgr, alpha;
+	if (src.channels() == 4) {
+		cv::cvtColor(src, bgr, cv::COLOR_BGRA2BGR);
+		cv::extractChannel(src, alpha, 3);
+	}
+	else {
+		bgr = src;
+		alpha = cv::Mat(src.size(), CV_8UC1, cv::Scalar(255));
+	}
+	if (opacity < 1.0) {
+		alpha.convertTo(alpha, CV_8U, std::max(0.0, opacity));
+	}
+
+	Sprite sprite;
+	premultiply(bgr, alpha, sprite);
+	m_marks.push_back(sprite);
+	return static_cast<int>(m_marks.size()) - 1;
+}
+
+bool WatermarkEngine::setPosition(int id, int x, int y)
+{
+	if (id < 0 || id >= static_cast<int>(m_marks.size())) {
+		return false;
+	}
+	m_marks[id].position = cv::Point2d(x, y);
+	return true;
+}
+
+bool WatermarkEngine::setMotion(int id, double vx, double vy, bool bounce)
+{
+	if (id < 0 || id >= static_cast<int>(m_marks.size())) {
+		return false;
+	}
+	m_marks[id].velocity = cv::Point2d(vx, vy);
+	m_marks[id].bounce = bounce;
+	return true;
+}
+
+// 一维运动：bounce时在[0,range]内往返，否则在[-size,frame]内循环
+static int move_axis(double start, double velocity, double seconds, int range, int size, bool bounce)
+{
+	double p = start + velocity * seconds;
+	if (velocity == 0) {
+		return static_cast<int>(std::lround(p));
+	}
+	if (bounce) {
+		if (range <= 0) {
+			return 0;
+		}
+		double m = std::fmod(p, 2.0 * range);
+		if (m < 0) m += 2.0 * range;
+		return static_cast<int>(std::lround(m <= range ? m : 2.0 * range - m));
+	}
+	const double span = range + 2.0 * size; // 从完全移出一侧到完全移出另一侧
+	double m = std::fmod(p + size, span);
+	if (m < 0) m += span;
+	return static_cast<int>(std::lround(m)) - size;
+}
+
+cv::Point WatermarkEngine::placement(const Sprite& sprite, double seconds, const cv::Size& fullSize)
+{
+	const int w = sprite.premul.cols;
+	const int h = sprite.premul.rows;
+	// 负坐标表示距右/下边缘，换算为左上角坐标
+	double x0 = sprite.position.x < 0 ? fullSize.width - w + sprite.position.x : sprite.position.x - sprite.anchor.x;
+	double y0 = sprite.position.y < 0 ? fullSize.height - h + sprite.position.y : sprite.position.y - sprite.anchor.y;
+	return cv::Point(move_axis(x0, sprite.velocity.x, seconds, fullSize.width - w, w, sprite.bounce),
+		move_axis(y0, sprite.velocity.y, seconds, fullSize.height - h, h, sprite.bounce));
+}
+
+// dst = premul + dst * inverse / 255，三个数组逐字节对应
+static void blend_row(uchar* dst, const uchar* pre, const uchar* inv, int n)
+{
+	int i = 0;
+#if CV_SIMD128
+	const cv::v_uint16x8 round = cv::v_setall_u16(128);
+	for (; i <= n - 16; i += 16) {
+		cv::v_uint16x8 d0, d1, k0, k1;
+		cv::v_expand(cv::v_load(dst + i), d0, d1);
+		cv::v_expand(cv::v_load(inv + i), k0, k1);
+		// x/255 取整：(x + 128 + ((x + 128) >> 8)) >> 8，255*255+128+255仍在16位内
+		cv::v_uint16x8 m0 = d0 * k0 + round;
+		cv::v_uint16x8 m1 = d1 * k1 + round;
+		m0 = (m0 + (m0 >> 8)) >> 8;
+		m1 = (m1 + (m1 >> 8)) >> 8;
+		cv::v_store(dst + i, cv::v_pack(m0, m1) + cv::v_load(pre + i));
+	}
+#endif
+	for (; i < n; ++i) {
+		int m = dst[i] * inv[i] + 128;
+		m = (m + (m >> 8)) >> 8;
+		dst[i] = static_cast<uchar>(std::min(255, pre[i] + m));
+	}
+}
+
+void WatermarkEngine::apply(cv::Mat& frame, double seconds, const cv::Point& origin, const cv::Size& fullSize) const
+{
+	if (frame.empty() || frame.type() != CV_8UC3) {
+		return;
+	}
+	const cv::Size full = fullSize.area() > 0 ? fullSize : frame.size();
+	const cv::Rect frameRect(origin, frame.size());
+	for (const Sprite& sprite : m_marks) {
+		cv::Point tl = placement(sprite, seconds, full);
+		cv::Rect covered = cv::Rect(tl, sprite.premul.size()) & frameRect;
+		if (covered.empty()) {
+			continue;
+		}
+		// 只遍历小图与帧相交的部分
+		const int sx = covered.x - tl.x;
+		const int sy = covered.y - tl.y;
+		const int dx = covered.x - origin.x;
+		const int dy = covered.y - origin.y;
+		const int bytes = covered.width * 3;
+		for (int y = 0; y < covered.height; ++y) {
+			blend_row(frame.ptr<uchar>(dy + y) + dx * 3,
+				sprite.premul.ptr<uchar>(sy + y) + sx * 3,
+				sprite.inverse.ptr<uchar>(sy + y) + sx * 3, bytes);
+		}
+	}
+}
+
+// -------------------- 水印 C API --------------------
+extern "C" OPENCVFFMPEGTOOLS_API void* Watermark_Create()
+{
+	return new WatermarkEngine();
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void Watermark_Destroy(void* watermark)
+{
+	delete static_cast<WatermarkEngine*>(watermark);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int Watermark_AddText(void* watermark, const char* text, double font_scale,
+	int b, int g, int r, int thickness, double opacity)
+{
+	if (!watermark || !text) return -1;
+	return static_cast<WatermarkEngine*>(watermark)->addText(text, font_scale, cv::Scalar(b, g, r), thickness, opacity);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int Watermark_AddImage(void* watermark, const char* image_path, double scale, double opacity)
+{
+	if (!watermark || !image_path || !*image_path) return -1;
+	try {
+		// 保留alpha通道；读取失败返回空图
+		cv::Mat image = cv::imread(image_path, cv::IMREAD_UNCHANGED);
+		if (image.empty()) {
+			std::cerr << "Watermark_AddImage imread fair: " << image_path << std::endl;
+			return -1;
+		}
+		if (image.channels() == 1) {
+			cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+		}
+		return static_cast<WatermarkEngine*>(watermark)->addImage(image, scale, opacity);
+	}
+	catch (...) {
+		return -1;
+	}
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool Watermark_SetPosition(void* watermark, int id, int x, int y)
+{
+	if (!watermark) return false;
+	return static_cast<WatermarkEngine*>(watermark)->setPosition(id, x, y);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API bool Watermark_SetMotion(void* watermark, int id, double vx, double vy, bool bounce)
+{
+	if (!watermark) return false;
+	return static_cast<WatermarkEngine*>(watermark)->setMotion(id, vx, vy, bounce);
+}
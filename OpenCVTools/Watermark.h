@@ -0,0 +1,79 @@
+/*****************************************************************//**
+ * \file   Watermark.h
+ * \brief  水印引擎：文字/台标预先栅格化为预乘alpha的小图，逐帧只混合覆盖区域
+ *
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+class WatermarkEngine
+{
+public:
+	WatermarkEngine();
+
+	/**
+	 * @brief 添加文字水印，参数与CvTranslator::addTextWatermark一致.
+	 *
+	 * 文字只在这里用cv::putText栅格化一次，抗锯齿的覆盖率作为alpha
+	 * \param opacity 不透明度 0~1
+	 * \return 水印id，文字为空返回-1
+	 */
+	int addText(const std::string& text, double fontScale = 1.0, const cv::Scalar& color = cv::Scalar(0, 0, 255),
+		int thickness = 2, double opacity = 1.0);
+	/**
+	 * @brief 添加图片水印（台标）.
+	 *
+	 * \param image 8位BGRA（带alpha）或BGR（不透明）
+	 * \param scale 缩放比例
+	 * \param opacity 不透明度 0~1，与图片自身的alpha相乘
+	 * \return 水印id，图片无效返回-1
+	 */
+	int addImage(const cv::Mat& image, double scale = 1.0, double opacity = 1.0);
+
+	/**
+	 * @brief 设置位置.
+	 *
+	 * 文字为基线左端（同cv::putText的org），图片为左上角；负数表示距右/下边缘
+	 */
+	bool setPosition(int id, int x, int y);
+	/**
+	 * @brief 设置移动速度（像素/秒），bounce为true时碰到边缘反弹，否则移出后从另一侧进入.
+	 */
+	bool setMotion(int id, double vx, double vy, bool bounce);
+
+	size_t size() const { return m_marks.size(); }
+	bool empty() const { return m_marks.empty(); }
+
+	/**
+	 * @brief 在BGR帧上原地混合所有水印.
+	 *
+	 * 只处理水印覆盖的区域，耗时与帧尺寸无关
+	 * \param frame 8位BGR
+	 * \param seconds 帧时间，用于计算移动中的水印位置
+	 * \param origin frame左上角在整幅画面中的坐标（分块处理时非0）
+	 * \param fullSize 整幅画面尺寸，为空时取frame尺寸
+	 */
+	void apply(cv::Mat& frame, double seconds, const cv::Point& origin = cv::Point(0, 0),
+		const cv::Size& fullSize = cv::Size()) const;
+
+private:
+	struct Sprite {
+		cv::Mat premul;   // 预乘alpha后的BGR
+		cv::Mat inverse;  // 255-alpha，按BGR三通道展开，与premul逐字节对应
+		cv::Point anchor; // 定位点在小图中的坐标
+		cv::Point2d position;
+		cv::Point2d velocity;
+		bool bounce = true;
+	};
+
+	// 由BGR颜色和alpha生成预乘小图
+	static void premultiply(const cv::Mat& bgr, const cv::Mat& alpha, Sprite& sprite);
+	// seconds时小图左上角在整幅画面中的位置
+	static cv::Point placement(const Sprite& sprite, double seconds, const cv::Size& fullSize);
+
+	std::vector<Sprite> m_marks;
+};
@@ -2,6 +2,16 @@
 #include "videoTrans.h"
 #include "CvTranslator.h"
 #include "COpenCVTools.h"
+#include "EffectChain.h"
+#include "BoundedQueue.h"
+#include "MediaIndex.h"
+#include "AvWorker.h"
+#include "AvJob.h"
+#include "MediaBuffer.h"
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
 #include <string>
 
 videoTrans::videoTrans()
@@ -10,7 +20,9 @@ videoTrans::videoTrans()
 	, m_width(0)
 	, m_height(0)
 	, m_fps(30) // 默认帧率
+	, m_frameRate(av_make_q(30, 1))
 	, m_duration(0)
+	, m_yuvFastPath(true)
 {
 	decoder = new FFmpegDecoder();
 	encoder = new FFmpegEncoder();
@@ -42,6 +54,7 @@ int videoTrans::initialize(const std::string& inputPath, const std::string& outp
 	m_width = decoder->getWidth();
 	m_height = decoder->getHeight();
 	m_fps = decoder->getFPS();
+	m_frameRate = decoder->getFrameRate();
 	m_duration = decoder->getDuration();
 	
 	printf("输入视频属性: %dx%d, %dfps, 时长: %lldms\n", m_width, m_height, m_fps, (long long)m_duration);
@@ -52,10 +65,16 @@ int videoTrans::initialize(const std::string& inputPath, const std::string& outp
 		return -3; // 无法获取视频尺寸
 	}
 	
-	if (encoder->video_muxer_create(outputPath.c_str(), m_width, m_height, m_fps) != 0) {
+	// 视频按解码帧时间戳（相对视频起点）计时，音频/字幕减去视频起始时间后直通，两者同一时间轴
+	if (encoder->video_muxer_create(outputPath.c_str(), m_width, m_height, m_frameRate,
+		decoder->getFormatContext(), decoder->getVideoStartTime()) != 0) {
 		decoder->ffplayer_close();
 		return -4; // 创建编码器失败
 	}
+	FFmpegEncoder* muxer = encoder;
+	decoder->setPacketSink([muxer](AVPacket* pkt) {
+		muxer->video_muxer_write_input_packet(pkt);
+	});
 	
 	m_inputPath = inputPath;
 	m_outputPath = outputPath;
@@ -85,6 +104,11 @@ int64_t videoTrans::getDuration() const
 	return m_duration;
 }
 
+void videoTrans::setYuvFastPath(bool enable)
+{
+	m_yuvFastPath = enable;
+}
+
 int videoTrans::reset()
 {
 	if (!m_initialized) {
@@ -116,10 +140,27 @@ void videoTrans::cleanup()
 	m_width = 0;
 	m_height = 0;
 	m_fps = 30;
+	m_frameRate = av_make_q(30, 1);
 	m_duration = 0;
 }
 
 int videoTrans::process(func fun, param mParem)
+{
+	EffectChain chain;
+	chain.add(fun, mParem);
+	return process(chain);
+}
+
+// 特效链使用的帧时间（秒）：取解码帧自身的时间戳，缺失时按有理数帧率由序号推算
+static double frame_seconds(int64_t frameTime, int64_t frameIdx, AVRational frameRate)
+{
+	if (frameTime != AV_NOPTS_VALUE) {
+		return static_cast<double>(frameTime) / AV_TIME_BASE;
+	}
+	return frameIdx * av_q2d(av_inv_q(frameRate));
+}
+
+int videoTrans::process(const EffectChain& effects)
 {
 	// 检查初始化状态
 	if (!m_initialized) {
@@ -129,12 +170,16 @@ int videoTrans::process(func fun, param mParem)
 	// 创建工具实例
 	CvTranslator translator;
 	COpenCVTools cvTools;
+	EffectChain chain = effects;
+	cv::Mat mat; // 跨帧复用，避免每帧重新分配
+	const bool useYuv = m_yuvFastPath && chain.supportsYUV();
 	
 	// 逐帧处理
 	int frameIdx = 0;
-	const int maxFrames = 100000; // 限制最大帧数，避免无限循环
+	auto beginTime = std::chrono::steady_clock::now();
+	AllocSteadyCheck allocCheck("videoTrans::process");
 	
-	while (frameIdx < maxFrames) {
+	while (true) {
 		int readRet = decoder->read_frame_for_trans();
 		if (readRet == 0) {
 			// EOF
@@ -153,81 +198,47 @@ int videoTrans::process(func fun, param mParem)
 		
 		// 检查帧是否有效
 		if (currentFrame->width > 0 && currentFrame->height > 0) {
+			const int64_t frameTime = decoder->getFrameTime(currentFrame);
+			
+			// YUV直通：原地改写解码帧后直接编码
+			if (useYuv && currentFrame->format == AV_PIX_FMT_YUV420P &&
+				av_frame_make_writable(currentFrame) >= 0 &&
+				chain.applyYUV(translator, currentFrame)) {
+				int ret = encoder->video_muxer_write_frame_at(currentFrame, frameTime);
+				if (ret != 0) {
+					printf("写入帧失败，帧索引: %d, 错误代码: %d\n", frameIdx, ret);
+					break;
+				}
+				allocCheck.frameDone();
+				frameIdx++;
+				continue;
+			}
 			
 			// 使用COpenCVTools将AVFrame转换为cv::Mat
-			cv::Mat mat = cvTools.AVFrameToCVMat(currentFrame);
-			if (mat.empty()) {
+			if (!cvTools.AVFrameToCVMat(currentFrame, mat)) {
 				frameIdx++;
 				continue; // 转换失败，跳过此帧
 			}
 			
-			// 根据func参数应用不同的图像处理
-			cv::Mat processedFrame;
-			switch (fun) {
-				case grayImage:
-					processedFrame = translator.grayImage(mat);
-					break;
-					
-				case customOilPaintApprox:
-					processedFrame = translator.customOilPaintApprox(mat, mParem.iparam1, mParem.dparam1);
-					break;
-					
-				case applyOilPainting:
-					processedFrame = translator.applyOilPainting(mat, mParem.iparam1, mParem.dparam1);
-					break;
-					
-				case applyMosaic:
-					{
-						cv::Rect mosaicRegion(mParem.iparam1, mParem.iparam2, mParem.iparam3, mParem.iparam4); // 示例区域
-						processedFrame = translator.applyMosaic(mat, mosaicRegion, mParem.iparam5);
-					}
-					break;
-					
-				case FrostedGlass:
-					processedFrame = translator.FrostedGlass(mat);
-					break;
-					
-				case simpleSkinSmoothing:
-					processedFrame = translator.simpleSkinSmoothing(mat);
-					break;
-					
-				case Whitening:
-					processedFrame = translator.Whitening(mat);
-					break;
-					
-				case Whitening2:
-					processedFrame = translator.Whitening2(mat);
-					break;
-					
-				case addTextWatermark:
-					processedFrame = translator.addTextWatermark(mat, mParem.arr, cv::Point(mParem.iparam1, mParem.iparam2));
-					break;
-					
-				case invertImage:
-					processedFrame = translator.invertImage(mat);
-					break;
-					
-				default:
-					processedFrame = mat.clone(); // 不处理，直接复制
-					break;
-			}
+			// 按顺序执行特效链，帧时间供移动水印定位；BGR24输入时mat包装的是解码帧内存，不能原地改写
+			chain.setTime(frame_seconds(frameTime, frameIdx, m_frameRate));
+			cv::Mat processedFrame = currentFrame->format == AV_PIX_FMT_BGR24 ?
+				chain.apply(translator, mat) : chain.applyInPlace(translator, mat);
 			
 			// 使用COpenCVTools将处理后的cv::Mat转换回AVFrame
 			AVFrame* outputFrame = cvTools.CVMatToAVFrame(processedFrame);
 			if (outputFrame) {
-				// 设置时间戳
-				outputFrame->pts = frameIdx;
+				// 按解码帧时间写入编码器
+				int ret = encoder->video_muxer_write_frame_at(outputFrame, frameTime);
 				
-				// 写入编码器
-				int ret = encoder->video_muxer_write_frame(outputFrame, frameIdx);
-				
-				// 释放AVFrame
-				av_frame_free(&outputFrame);
+				// 归还AVFrame供下一帧复用
+				cvTools.recycleFrame(outputFrame);
 				
 				if (ret != 0) {
 					printf("写入帧失败，帧索引: %d, 错误代码: %d\n", frameIdx, ret);
 					break; // 写入失败，退出循环
 				}
+				allocCheck.frameDone();
 			} else {
 				printf("转换AVFrame失败，帧索引: %d - 跳过该帧\n", frameIdx);
 				frameIdx++;
@@ -238,7 +249,11 @@ int videoTrans::process(func fun, param mParem)
 		}
 	}
 	
-	printf("总共处理了 %d 帧\n", frameIdx);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+	m_lastFps = seconds > 0 ? frameIdx / seconds : 0.0;
+	printf("总共处理了 %d 帧（%s路径），耗时 %.2fs，%.2f fps\n", frameIdx, useYuv ? "YUV" : "BGR",
+		seconds, m_lastFps);
+	allocCheck.report();
 	
 	// 完成编码
 	encoder->video_muxer_flush();
@@ -246,6 +261,628 @@ int videoTrans::process(func fun, param mParem)
 	return 0; // 成功
 }
 
+// 流水线中传递的帧：seq为解码顺序号，frame为空表示该帧处理失败需跳过
+struct PipelineFrame {
+	int64_t seq;
+	AVFrame* frame;
+	bool eos; // 结束标记
+	COpenCVTools* owner; // 输出帧所属的转换器，写完后归还
+	int64_t time; // 解码帧时间（相对视频起点，AV_TIME_BASE单位）
+};
+
+int videoTrans::processParallel(func fun, param mParem, int threads)
+{
+	EffectChain chain;
+	chain.add(fun, mParem);
+	return processParallel(chain, threads);
+}
+
+int videoTrans::processParallel(const EffectChain& effects, int threads)
+{
+	if (!m_initialized) {
+		return -1; // 未初始化
+	}
+
+	if (threads <= 0) {
+		// 在调度器作业中按分到的线程数，否则取CPU核数
+		threads = avjob_threads();
+		if (threads <= 0) {
+			threads = static_cast<int>(std::thread::hardware_concurrency());
+		}
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	// 队列容量与在途帧窗口，限制内存占用
+	const size_t queueCapacity = static_cast<size_t>(threads) * 2;
+	const int64_t maxInFlight = static_cast<int64_t>(threads) * 4;
+
+	BoundedQueue<PipelineFrame> decodedQueue(queueCapacity);
+	BoundedQueue<PipelineFrame> processedQueue(queueCapacity);
+	std::atomic<bool> abort(false);
+	std::atomic<int64_t> written(0);
+	int64_t decodedCount = 0;
+	const bool useYuv = m_yuvFastPath && effects.supportsYUV();
+	auto beginTime = std::chrono::steady_clock::now();
+	// 解码帧的引用结构体取自池，替代逐帧av_frame_clone；owner为空的帧都归还到这里
+	FramePool refPool;
+	AllocSteadyCheck allocCheck("videoTrans::processParallel");
+
+	// 解码线程：读取帧并引用一份交给特效线程（解码器内部帧会被复用）
+	std::thread decodeThread([&]() {
+		while (!abort.load()) {
+			// 在途帧过多时等待编码线程追上
+			while (decodedCount - written.load() >= maxInFlight && !abort.load()) {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+
+			int readRet = decoder->read_frame_for_trans();
+			if (readRet == 0) {
+				break; // EOF
+			}
+			if (readRet < 0) {
+				printf("读取帧失败，错误代码: %d\n", readRet);
+				break;
+			}
+
+			AVFrame* currentFrame = decoder->getCurrentAVFrame();
+			if (!currentFrame) {
+				break;
+			}
+			if (currentFrame->width <= 0 || currentFrame->height <= 0) {
+				continue;
+			}
+
+			const int64_t frameTime = decoder->getFrameTime(currentFrame);
+			AVFrame* ref = refPool.ref(currentFrame);
+			if (!ref) {
+				printf("引用解码帧失败\n");
+				abort.store(true);
+				break;
+			}
+
+			PipelineFrame item = { decodedCount, ref, false, nullptr, frameTime };
+			if (!decodedQueue.push(item, abort)) {
+				refPool.recycle(ref);
+				break;
+			}
+			decodedCount++;
+		}
+
+		// 每个特效线程一个结束标记
+		for (int i = 0; i < threads; ++i) {
+			PipelineFrame eos = { -1, nullptr, true, nullptr, AV_NOPTS_VALUE };
+			if (!decodedQueue.push(eos, abort)) {
+				break;
+			}
+		}
+	});
+
+	// 每个特效线程独立的COpenCVTools；生命周期覆盖编码线程，输出帧写完后归还给它
+	std::vector<std::unique_ptr<COpenCVTools>> converters;
+	for (int i = 0; i < threads; ++i) {
+		converters.emplace_back(new COpenCVTools());
+	}
+
+	// 特效线程：每个线程独立的CvTranslator/COpenCVTools，互不共享状态
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; ++i) {
+		COpenCVTools* tools = converters[i].get();
+		workers.emplace_back([&, tools]() {
+			CvTranslator translator;
+			COpenCVTools& cvTools = *tools;
+			EffectChain chain = effects;
+			cv::Mat mat;
+			PipelineFrame item;
+			while (decodedQueue.pop(item, abort)) {
+				if (item.eos) {
+					processedQueue.push(item, abort);
+					return;
+				}
+
+				// YUV直通：clone出的帧原地改写后直接交给编码线程，owner为空表示由编码线程释放
+				if (useYuv && item.frame->format == AV_PIX_FMT_YUV420P &&
+					av_frame_make_writable(item.frame) >= 0 &&
+					chain.applyYUV(translator, item.frame)) {
+					PipelineFrame result = { item.seq, item.frame, false, nullptr, item.time };
+					if (!processedQueue.push(result, abort)) {
+						refPool.recycle(item.frame);
+						return;
+					}
+					continue;
+				}
+
+				AVFrame* outputFrame = nullptr;
+				try {
+					if (cvTools.AVFrameToCVMat(item.frame, mat)) {
+						chain.setTime(frame_seconds(item.time, item.seq, m_frameRate));
+						cv::Mat processedFrame = item.frame->format == AV_PIX_FMT_BGR24 ?
+							chain.apply(translator, mat) : chain.applyInPlace(translator, mat);
+						outputFrame = cvTools.CVMatToAVFrame(processedFrame);
+					}
+				}
+				catch (const std::exception& e) {
+					printf("特效处理异常，帧索引: %lld - %s\n", (long long)item.seq, e.what());
+				}
+				refPool.recycle(item.frame);
+
+				PipelineFrame result = { item.seq, outputFrame, false, tools, item.time };
+				if (!processedQueue.push(result, abort)) {
+					av_frame_free(&outputFrame);
+					return;
+				}
+			}
+		});
+	}
+
+	// 当前线程作为编码线程：按seq重排后写入
+	std::map<int64_t, PipelineFrame> pending;
+	int finishedWorkers = 0;
+	int ret = 0;
+	PipelineFrame item;
+	while (finishedWorkers < threads && processedQueue.pop(item, abort)) {
+		if (item.eos) {
+			finishedWorkers++;
+			continue;
+		}
+		pending[item.seq] = item;
+
+		while (!pending.empty() && pending.begin()->first == written.load()) {
+			int64_t frameIdx = pending.begin()->first;
+			AVFrame* outputFrame = pending.begin()->second.frame;
+			COpenCVTools* owner = pending.begin()->second.owner;
+			const int64_t frameTime = pending.begin()->second.time;
+			pending.erase(pending.begin());
+
+			if (outputFrame) {
+				int writeRet = encoder->video_muxer_write_frame_at(outputFrame, frameTime);
+				if (owner) {
+					owner->recycleFrame(outputFrame);
+				}
+				else {
+					refPool.recycle(outputFrame);
+				}
+				if (writeRet != 0) {
+					printf("写入帧失败，帧索引: %lld, 错误代码: %d\n", (long long)frameIdx, writeRet);
+					ret = -5;
+					abort.store(true);
+				}
+				else {
+					allocCheck.frameDone();
+				}
+			}
+			else {
+				printf("转换AVFrame失败，帧索引: %lld - 跳过该帧\n", (long long)frameIdx);
+			}
+			written.fetch_add(1);
+		}
+	}
+
+	abort.store(true);
+	decodeThread.join();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// 释放中止时残留在队列中的帧：解码引用和YUV路径的帧归还refPool，转换器输出直接释放
+	while (decodedQueue.tryPop(item)) {
+		refPool.recycle(item.frame);
+	}
+	auto release = [&](PipelineFrame& f) {
+		if (f.owner) {
+			av_frame_free(&f.frame);
+		}
+		else {
+			refPool.recycle(f.frame);
+		}
+	};
+	while (processedQueue.tryPop(item)) {
+		release(item);
+	}
+	for (auto& kv : pending) {
+		release(kv.second);
+	}
+
+	int64_t frames = written.load();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+	m_lastFps = seconds > 0 ? frames / seconds : 0.0;
+	printf("流水线处理完成: %d 线程（%s路径）, %lld 帧，耗时 %.2fs，%.2f fps\n",
+		threads, useYuv ? "YUV" : "BGR", (long long)frames, seconds, m_lastFps);
+	allocCheck.report();
+
+	encoder->video_muxer_flush();
+
+	return ret;
+}
+
+int videoTrans::benchmarkThreads(const EffectChain& effects, const int* threadCounts, int count, double* fps)
+{
+	if (!m_initialized || !threadCounts || count <= 0) {
+		return -1;
+	}
+	const std::string inputPath = m_inputPath;
+	const std::string outputPath = m_outputPath;
+	std::vector<double> results(count, 0.0);
+	int ret = 0;
+	for (int i = 0; i < count && ret == 0; ++i) {
+		// 每轮从头解码、重建封装器，各轮条件相同
+		ret = initialize(inputPath, outputPath);
+		if (ret != 0) {
+			break;
+		}
+		m_lastFps = 0;
+		ret = threadCounts[i] == 1 ? process(effects) : processParallel(effects, threadCounts[i]);
+		results[i] = m_lastFps;
+	}
+
+	printf("线程数扫描（%dx%d）:\n", m_width, m_height);
+	for (int i = 0; i < count; ++i) {
+		printf("  %d 线程: %.2f fps（相对首项 %.2fx）\n", threadCounts[i], results[i],
+			results[0] > 0 ? results[i] / results[0] : 0.0);
+		if (fps) {
+			fps[i] = results[i];
+		}
+	}
+	return ret;
+}
+
+// 分段文件名：out.mp4 -> out.part00003.mp4
+static std::string segment_path(const std::string& output, int index)
+{
+	size_t slash = output.find_last_of("/\\");
+	size_t dot = output.find_last_of('.');
+	std::string base = output;
+	std::string ext;
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+		base = output.substr(0, dot);
+		ext = output.substr(dot);
+	}
+	char buf[32];
+	snprintf(buf, sizeof(buf), ".part%05d", index);
+	return base + buf + ext;
+}
+
+// 已完成的一个分段：累计帧数和该段最后一帧的时间（AV_TIME_BASE单位，相对视频起始）
+struct ResumeSegment {
+	long long frames;
+	long long lastTime;
+};
+
+// 检查点文件：首行 "ckpt 1 <输入大小> <输入修改时间> <每段帧数>"，
+// 之后每完成一段追加一行 "<段号> <累计帧数> <最后一帧时间>"；写到一半的行在读取时被忽略
+static bool load_checkpoint(const std::string& path, int64_t size, int64_t mtime, int segmentFrames,
+	std::vector<ResumeSegment>& segments)
+{
+	std::ifstream in(path);
+	if (!in) {
+		return false;
+	}
+	std::string tag;
+	int version = 0, frames = 0;
+	long long fileSize = 0, fileMtime = 0;
+	if (!(in >> tag >> version >> fileSize >> fileMtime >> frames) || tag != "ckpt" || version != 1 ||
+		fileSize != size || fileMtime != mtime || frames != segmentFrames) {
+		return false; // 输入或分段长度变了，检查点作废
+	}
+	int index = 0;
+	ResumeSegment seg;
+	while (in >> index >> seg.frames >> seg.lastTime) {
+		if (index != static_cast<int>(segments.size())) {
+			break;
+		}
+		segments.push_back(seg);
+	}
+	return true;
+}
+
+static bool save_checkpoint(const std::string& path, int64_t size, int64_t mtime, int segmentFrames,
+	const std::vector<ResumeSegment>& segments)
+{
+	std::ofstream out(path, std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+	out << "ckpt 1 " << size << " " << mtime << " " << segmentFrames << "\n";
+	for (size_t i = 0; i < segments.size(); ++i) {
+		out << i << " " << segments[i].frames << " " << segments[i].lastTime << "\n";
+	}
+	return static_cast<bool>(out.flush());
+}
+
+int videoTrans::processResumable(const EffectChain& effects, int segmentSeconds)
+{
+	if (!m_initialized) {
+		return -1; // 未初始化
+	}
+	if (segmentSeconds <= 0) {
+		segmentSeconds = 10;
+	}
+	// 按有理数帧率换算，29.97fps时每段帧数/帧间隔不因取整漂移
+	const int segmentFrames = std::max(1, static_cast<int>(std::lround(segmentSeconds * av_q2d(m_frameRate))));
+	const int64_t frameDuration = av_rescale_q(1, av_inv_q(m_frameRate), AV_TIME_BASE_Q);
+	const std::string ckptPath = m_outputPath + ".ckpt";
+
+	// 输出改为最后由分段拼接，initialize创建的整体封装器不再使用
+	encoder->video_muxer_destroy();
+
+	int64_t inSize = 0, inMtime = 0;
+	MediaIndex::statFile(m_inputPath, inSize, inMtime);
+
+	// 读取检查点，分段文件缺失时只保留它之前的段
+	std::vector<ResumeSegment> done;
+	if (load_checkpoint(ckptPath, inSize, inMtime, segmentFrames, done)) {
+		for (size_t i = 0; i < done.size(); ++i) {
+			int64_t partSize = 0, partMtime = 0;
+			if (!MediaIndex::statFile(segment_path(m_outputPath, static_cast<int>(i)), partSize, partMtime) || partSize <= 0) {
+				done.resize(i);
+				break;
+			}
+		}
+	}
+	if (!save_checkpoint(ckptPath, inSize, inMtime, segmentFrames, done)) {
+		printf("写入检查点失败: %s\n", ckptPath.c_str());
+		return -4;
+	}
+
+	int segIndex = static_cast<int>(done.size());
+	int64_t totalFrames = done.empty() ? 0 : done.back().frames;
+	int64_t lastTime = done.empty() ? AV_NOPTS_VALUE : done.back().lastTime;
+	if (!done.empty()) {
+		printf("从检查点继续：已完成 %d 段，%lld 帧\n", segIndex, (long long)totalFrames);
+		decoder->seek(lastTime / 1000);
+	}
+
+	CvTranslator translator;
+	COpenCVTools cvTools;
+	EffectChain chain = effects;
+	cv::Mat mat;
+	const bool useYuv = m_yuvFastPath && chain.supportsYUV();
+	auto beginTime = std::chrono::steady_clock::now();
+
+	// 一个分段：视频时间[start, end)，end在下一段首帧到来时确定
+	struct OpenSegment {
+		std::unique_ptr<FFmpegEncoder> muxer;
+		int64_t start = 0;
+		int64_t end = AV_NOPTS_VALUE;
+		int64_t lastTime = AV_NOPTS_VALUE; // 该段最后一帧的时间
+		int frames = 0;
+	};
+	std::unique_ptr<OpenSegment> segment; // 正在写视频的段
+	std::unique_ptr<OpenSegment> closing; // 视频已写完、仍在等音频的上一段
+	const int firstSegIndex = segIndex;
+
+	// 音频/字幕包按时间戳分给所在的段。解码器输出某帧时，交错在其后的音频可能还没读到，
+	// 所以上一段在新段写过kInterleaveMargin之后才关闭；还不能确定归属的包留在队列里
+	const int64_t kInterleaveMargin = AV_TIME_BASE;
+	AVFormatContext* inFmt = decoder->getFormatContext();
+	const int64_t videoStart = decoder->getVideoStartTime();
+	std::deque<AVPacket*> pendingPackets;
+	decoder->setPacketSink([&pendingPackets](AVPacket* pkt) {
+		pendingPackets.push_back(av_packet_clone(pkt));
+	});
+	auto packetTime = [&](const AVPacket* pkt) -> int64_t {
+		int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+		if (ts == AV_NOPTS_VALUE) {
+			return AV_NOPTS_VALUE;
+		}
+		return av_rescale_q(ts, inFmt->streams[pkt->stream_index]->time_base, AV_TIME_BASE_Q) - videoStart;
+	};
+	// eof为true时剩下的包全部归入最后一段
+	auto routePackets = [&](bool eof) {
+		while (!pendingPackets.empty()) {
+			AVPacket* pkt = pendingPackets.front();
+			int64_t ts = packetTime(pkt);
+			OpenSegment* target = nullptr;
+			bool drop = false;
+			if (closing && (ts == AV_NOPTS_VALUE || ts < closing->end)) {
+				target = closing.get();
+			}
+			else if (segment && ts != AV_NOPTS_VALUE && ts < segment->start && !closing) {
+				// 续跑时属于已完成分段的包丢弃；第0段的起点之前的包交给第0段（由直通按起点裁掉）
+				if (firstSegIndex == 0 && segIndex == 1) {
+					target = segment.get();
+				}
+				else {
+					drop = true;
+				}
+			}
+			else if (segment && (eof || ts == AV_NOPTS_VALUE ||
+				(segment->lastTime != AV_NOPTS_VALUE && ts <= segment->lastTime))) {
+				target = segment.get();
+			}
+			else if (!segment && !closing && eof) {
+				drop = true;
+			}
+			if (!target && !drop) {
+				break; // 归属未定，等后面的视频帧
+			}
+			pendingPackets.pop_front();
+			if (target) {
+				target->muxer->video_muxer_write_input_packet(pkt);
+			}
+			av_packet_free(&pkt);
+		}
+	};
+
+	int64_t processed = 0;
+	// 关闭段并记入检查点
+	auto finishSegment = [&](std::unique_ptr<OpenSegment>& seg) -> bool {
+		int flushRet = seg->muxer->video_muxer_flush();
+		seg->muxer->video_muxer_destroy();
+		int frames = seg->frames;
+		int64_t segLast = seg->lastTime;
+		seg.reset();
+		if (flushRet != 0) {
+			return false;
+		}
+		totalFrames += frames;
+		done.push_back({ static_cast<long long>(totalFrames), static_cast<long long>(segLast) });
+		return save_checkpoint(ckptPath, inSize, inMtime, segmentFrames, done);
+	};
+
+	int ret = 0;
+	while (true) {
+		int readRet = decoder->read_frame_for_trans();
+		if (readRet == 0) {
+			break; // EOF
+		}
+		if (readRet < 0) {
+			printf("读取帧失败，错误代码: %d\n", readRet);
+			ret = -5;
+			break;
+		}
+		AVFrame* currentFrame = decoder->getCurrentAVFrame();
+		if (!currentFrame) {
+			break;
+		}
+		if (currentFrame->width <= 0 || currentFrame->height <= 0) {
+			continue;
+		}
+
+		int64_t t = decoder->getFrameTime(currentFrame);
+		if (t == AV_NOPTS_VALUE) {
+			t = lastTime == AV_NOPTS_VALUE ? 0 : lastTime + frameDuration;
+		}
+		// 跳转落在目标之前的关键帧上，已写入分段的帧不再处理
+		if (lastTime != AV_NOPTS_VALUE && t <= lastTime) {
+			continue;
+		}
+
+		// 当前段帧数已满：它的结束时间就是本帧时间，转为等待音频的状态
+		if (segment && segment->frames >= segmentFrames) {
+			if (closing) {
+				routePackets(false);
+				if (!finishSegment(closing)) {
+					printf("分段收尾失败: %d\n", segIndex - 1);
+					ret = -5;
+					break;
+				}
+			}
+			segment->end = t;
+			closing = std::move(segment);
+		}
+
+		// 每段新建编码器，从关键帧开始，可独立解码；音频按段首帧时间对齐
+		if (!segment) {
+			std::string path = segment_path(m_outputPath, segIndex);
+			segment.reset(new OpenSegment());
+			segment->muxer.reset(new FFmpegEncoder());
+			segment->start = t;
+			if (segment->muxer->video_muxer_create(path.c_str(), m_width, m_height, m_frameRate,
+				inFmt, videoStart + t) != 0) {
+				printf("创建分段失败: %s\n", path.c_str());
+				segment.reset();
+				ret = -4;
+				break;
+			}
+			segIndex++;
+		}
+
+		AVFrame* outputFrame = nullptr;
+		bool fromConverter = false;
+		if (useYuv && currentFrame->format == AV_PIX_FMT_YUV420P &&
+			av_frame_make_writable(currentFrame) >= 0 &&
+			chain.applyYUV(translator, currentFrame)) {
+			outputFrame = currentFrame;
+		}
+		else if (cvTools.AVFrameToCVMat(currentFrame, mat)) {
+			chain.setTime(static_cast<double>(t) / AV_TIME_BASE);
+			cv::Mat processedFrame = currentFrame->format == AV_PIX_FMT_BGR24 ?
+				chain.apply(translator, mat) : chain.applyInPlace(translator, mat);
+			outputFrame = cvTools.CVMatToAVFrame(processedFrame);
+			fromConverter = true;
+		}
+
+		lastTime = t;
+		segment->lastTime = t;
+		if (outputFrame) {
+			// 分段各自从0计时，与按段首帧时间对齐的音频一致
+			int writeRet = segment->muxer->video_muxer_write_frame_at(outputFrame, t - segment->start);
+			if (fromConverter) {
+				cvTools.recycleFrame(outputFrame);
+			}
+			if (writeRet != 0) {
+				printf("写入帧失败，分段: %d, 帧索引: %d, 错误代码: %d\n", segIndex - 1, segment->frames, writeRet);
+				ret = -5;
+				break;
+			}
+		}
+		else {
+			printf("转换AVFrame失败，分段: %d, 帧索引: %d - 跳过该帧\n", segIndex - 1, segment->frames);
+		}
+		segment->frames++;
+		processed++;
+
+		routePackets(false);
+		// 新段已写过一段时间，上一段的音频都已读到
+		if (closing && t >= closing->end + kInterleaveMargin && !finishSegment(closing)) {
+			printf("分段收尾失败: %d\n", segIndex - 2);
+			ret = -5;
+			break;
+		}
+	}
+
+	if (ret == 0) {
+		routePackets(true);
+		if (closing && !finishSegment(closing)) {
+			ret = -5;
+		}
+		if (ret == 0 && segment && !finishSegment(segment)) {
+			ret = -5;
+		}
+	}
+	// 未完成的分段丢弃，续跑时从上一个检查点重做
+	for (std::unique_ptr<OpenSegment>* seg : { &closing, &segment }) {
+		if (*seg) {
+			(*seg)->muxer->video_muxer_destroy();
+			seg->reset();
+		}
+	}
+	for (AVPacket* pkt : pendingPackets) {
+		av_packet_free(&pkt);
+	}
+	pendingPackets.clear();
+	segIndex = static_cast<int>(done.size());
+	decoder->setPacketSink(nullptr);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+	printf("分段处理%s: 本次 %lld 帧，累计 %lld 帧，%d 段，耗时 %.2fs，%.2f fps\n",
+		ret == 0 ? "完成" : "中断", (long long)processed, (long long)totalFrames, segIndex,
+		seconds, seconds > 0 ? processed / seconds : 0.0);
+	if (ret != 0) {
+		return ret;
+	}
+	if (done.empty()) {
+		return -5; // 没有任何视频帧
+	}
+
+	// 拼接：各段参数一致，SpliceAVMulti直接复制数据包
+	std::vector<std::string> parts;
+	for (size_t i = 0; i < done.size(); ++i) {
+		parts.push_back(segment_path(m_outputPath, static_cast<int>(i)));
+	}
+	bool concatOk = false;
+	if (parts.size() == 1) {
+		std::remove(m_outputPath.c_str());
+		concatOk = std::rename(parts[0].c_str(), m_outputPath.c_str()) == 0;
+	}
+	else {
+		AvWorker worker;
+		concatOk = worker.SpliceAVMulti(parts, m_outputPath, false);
+	}
+	if (!concatOk) {
+		printf("分段拼接失败，分段和检查点保留: %s\n", ckptPath.c_str());
+		return -6;
+	}
+
+	for (const std::string& part : parts) {
+		std::remove(part.c_str());
+	}
+	std::remove(ckptPath.c_str());
+	return 0;
+}
+
 int videoTrans::trans(const std::string& inputPath, const std::string& outputPath, func fun , param m)
 {
 	// 使用新的初始化和process方法
@@ -314,6 +951,42 @@ extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_Process(void* trans, int effect_
 	return static_cast<videoTrans*>(trans)->process(effect,m);
 }
 
+extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessParallel(void* trans, int effect_type, param m, int threads)
+{
+	if (!trans) return -1;
+	func effect = static_cast<func>(effect_type);
+	return static_cast<videoTrans*>(trans)->processParallel(effect, m, threads);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessChain(void* trans, void* chain, int threads)
+{
+	if (!trans || !chain) return -1;
+	const EffectChain& effects = *static_cast<EffectChain*>(chain);
+	if (threads == 1) {
+		return static_cast<videoTrans*>(trans)->process(effects);
+	}
+	return static_cast<videoTrans*>(trans)->processParallel(effects, threads);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_ProcessResumable(void* trans, void* chain, int segment_seconds)
+{
+	if (!trans || !chain) return -1;
+	const EffectChain& effects = *static_cast<EffectChain*>(chain);
+	return static_cast<videoTrans*>(trans)->processResumable(effects, segment_seconds);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_BenchmarkThreads(void* trans, void* chain, const int* thread_counts, int count, double* fps)
+{
+	if (!trans || !chain) return -1;
+	return static_cast<videoTrans*>(trans)->benchmarkThreads(*static_cast<EffectChain*>(chain), thread_counts, count, fps);
+}
+
+extern "C" OPENCVFFMPEGTOOLS_API void VideoTrans_SetYuvFastPath(void* trans, bool enable)
+{
+	if (!trans) return;
+	static_cast<videoTrans*>(trans)->setYuvFastPath(enable);
+}
+
 extern "C" OPENCVFFMPEGTOOLS_API int VideoTrans_Reset(void* trans)
 {
 	if (!trans) return -1;
@@ -3,6 +3,7 @@
 #include "CvTranslator.h"
 #include "FFmpegDecoder.h"
 #include "FFmpegEncoder.h"
+#include "EffectChain.h"
 class videoTrans
 {
 public:
@@ -20,6 +21,33 @@ public:
 	
 	// 处理函数 - 使用已初始化的解码器
 	int process(func fun, param mParem);
+	// 特效链版本：一次解码/编码内按顺序执行链上所有特效
+	int process(const EffectChain& effects);
+
+	// 多线程流水线处理：解码 -> threads个特效线程 -> 编码，按帧序号保持输出顺序
+	// threads<=0 时使用CPU核数
+	int processParallel(func fun, param mParem, int threads);
+	int processParallel(const EffectChain& effects, int threads);
+
+	// 可续跑处理：每segmentSeconds秒输出一个可独立播放的分段，完成一段就记入检查点文件（输出路径+".ckpt"）；
+	// 中断后用相同输入/输出和相同特效重新调用，从最后完成的分段之后继续，全部完成后无重编码拼接为输出文件。
+	// 返回后initialize创建的封装器已关闭，再次处理需重新initialize
+	int processResumable(const EffectChain& effects, int segmentSeconds);
+
+	/**
+	 * @brief 线程数扫描：对每个threadCounts[i]重新initialize并完整处理一遍，报告各自的fps.
+	 *
+	 * 须先initialize（取其输入/输出路径）；1走process，其余走processParallel。
+	 * 输出文件为最后一次的结果，返回后封装器已收尾，再次处理需重新initialize
+	 * \param fps 可为nullptr，否则写入count个fps
+	 * \return 成功返回0，任一轮失败返回该轮的错误码
+	 */
+	int benchmarkThreads(const EffectChain& effects, const int* threadCounts, int count, double* fps);
+	// 最近一次process/processParallel的处理帧率
+	double getLastFps() const { return m_lastFps; }
+
+	// 灰度/反色/美白类特效是否直接在YUV平面上处理（默认开启），关闭后可与BGR路径对比fps
+	void setYuvFastPath(bool enable);
 	
 	// 重置解码器到开始位置
 	int reset();
@@ -44,8 +72,12 @@ private:
 	int m_width;
 	int m_height;
 	int m_fps;
+	AVRational m_frameRate; // 有理数帧率，计算时长/时间用它，m_fps只是取整后的显示值
 	int64_t m_duration;
 
+	bool m_yuvFastPath;
+	double m_lastFps = 0;
+
 	
 };
 
@@ -19,7 +19,9 @@ CONFIG += c++11
 DESTDIR = ../bin
 
 SOURCES += \
+    src/framepool.cpp \
     src/ipcmgrbase.cpp \
+    src/keyframeindex.cpp \
     src/main.cpp \
     src/mdevice.cpp \
     src/mglwidget.cpp \
@@ -29,7 +31,9 @@ SOURCES += \
 
 HEADERS += \
     src/ffmpeg_util.h \
+    src/framepool.h \
     src/ipcmgrbase.h \
+    src/keyframeindex.h \
     src/lan_util.h \
     src/mdevice.h \
     src/mframe.h \
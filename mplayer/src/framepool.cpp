@@ -0,0 +1,84 @@
+#include "framepool.h"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+static std::atomic<int64_t> g_alloc_count(0);
+
+FramePool::~FramePool()
+{
+    for (AVFrame *frame : m_free) {
+        av_frame_free(&frame);
+    }
+    av_buffer_pool_uninit(&m_pool);
+}
+
+int64_t FramePool::allocCount()
+{
+    return g_alloc_count.load();
+}
+
+AVBufferRef *FramePool::countedAlloc(int size)
+{
+    g_alloc_count++;
+    return av_buffer_alloc(size);
+}
+
+AVFrame *FramePool::video(int width, int height, AVPixelFormat pix_fmt)
+{
+    int size = av_image_get_buffer_size(pix_fmt, width, height, 32);
+    if (size < 0) {
+        return nullptr;
+    }
+    // 末尾留余量，sws的SIMD写行尾时不越界
+    size += 64;
+
+    AVFrame *frame = nullptr;
+    AVBufferRef *buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (!m_free.empty()) {
+            frame = m_free.back();
+            m_free.pop_back();
+        }
+        if (!m_pool || m_poolSize != size) {
+            // 尺寸变化：旧池等缓冲区全部归还后自行释放
+            av_buffer_pool_uninit(&m_pool);
+            m_pool = av_buffer_pool_init(size, countedAlloc);
+            m_poolSize = size;
+        }
+        buf = m_pool ? av_buffer_pool_get(m_pool) : nullptr;
+    }
+    if (!frame) {
+        g_alloc_count++;
+        frame = av_frame_alloc();
+    }
+    if (!frame || !buf) {
+        av_buffer_unref(&buf);
+        recycle(frame);
+        return nullptr;
+    }
+
+    frame->buf[0] = buf;
+    if (av_image_fill_arrays(frame->data, frame->linesize, buf->data, pix_fmt, width, height, 32) < 0) {
+        recycle(frame);
+        return nullptr;
+    }
+    frame->extended_data = frame->data;
+    frame->format = pix_fmt;
+    frame->width = width;
+    frame->height = height;
+    return frame;
+}
+
+void FramePool::recycle(AVFrame *&frame)
+{
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_free.push_back(frame);
+    frame = nullptr;
+}
@@ -0,0 +1,42 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+// AVFrame池（与OpenCVTools/MediaBuffer中的FramePool相同的做法）
+// 帧结构体回收复用，图像缓冲区取自av_buffer_pool；编码器仍持有的缓冲区在其释放后自动回到池中。
+// 分辨率/格式不变时稳态零分配，allocCount()用于核对
+class FramePool
+{
+public:
+    FramePool() {}
+    ~FramePool();
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // 替代av_frame_alloc + av_frame_get_buffer（行对齐32字节）
+    AVFrame *video(int width, int height, AVPixelFormat pix_fmt);
+    // unref后放回池中，frame置空
+    void recycle(AVFrame *&frame);
+
+    // 所有FramePool累计的实际分配次数（帧结构体和图像缓冲区）
+    static int64_t allocCount();
+
+private:
+    static AVBufferRef *countedAlloc(int size);
+
+    std::mutex m_mtx;
+    std::vector<AVFrame *> m_free;
+    AVBufferPool *m_pool = nullptr;
+    int m_poolSize = 0;
+};
+
+#endif // FRAMEPOOL_H
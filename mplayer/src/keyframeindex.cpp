@@ -0,0 +1,207 @@
+#include "keyframeindex.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <utility>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+static const quint32 kSidecarMagic = 0x5849464B; // "KFIX"
+static const quint32 kSidecarVersion = 1;
+
+KeyframeIndex::KeyframeIndex()
+    : m_abort(false)
+{
+}
+
+KeyframeIndex::~KeyframeIndex()
+{
+    cancel();
+}
+
+void KeyframeIndex::build(const QString &mediaPath)
+{
+    cancel();
+
+    QFileInfo info(mediaPath);
+    if (!info.isFile()) {
+        return;
+    }
+    m_abort = false;
+    m_thread = std::thread(&KeyframeIndex::run, this, mediaPath,
+                           info.size(), info.lastModified().toMSecsSinceEpoch());
+}
+
+void KeyframeIndex::cancel()
+{
+    m_abort = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_ready = false;
+    m_ts.clear();
+    m_pos.clear();
+}
+
+bool KeyframeIndex::isReady() const
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_ready;
+}
+
+bool KeyframeIndex::keyframeBefore(int64_t ts, int64_t &keyTs, int64_t &keyPos) const
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (!m_ready) {
+        return false;
+    }
+    auto it = std::upper_bound(m_ts.begin(), m_ts.end(), ts);
+    if (it == m_ts.begin()) {
+        return false;
+    }
+    size_t k = static_cast<size_t>(it - m_ts.begin()) - 1;
+    keyTs = m_ts[k];
+    keyPos = m_pos[k];
+    return true;
+}
+
+void KeyframeIndex::run(const QString &mediaPath, qint64 size, qint64 mtime)
+{
+    std::vector<int64_t> ts, pos;
+    if (!load(mediaPath, size, mtime, ts, pos)) {
+        qint64 begin = QDateTime::currentMSecsSinceEpoch();
+        if (!scan(mediaPath, ts, pos)) {
+            return;
+        }
+        qDebug() << "[KeyframeIndex]" << mediaPath << ts.size() << "keyframes,"
+                 << (QDateTime::currentMSecsSinceEpoch() - begin) << "ms";
+        save(mediaPath, size, mtime, ts, pos);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_ts.swap(ts);
+    m_pos.swap(pos);
+    m_ready = true;
+}
+
+// 关闭播放时中断还在进行的扫描
+static int scan_interrupt(void *opaque)
+{
+    return static_cast<std::atomic<bool> *>(opaque)->load() ? 1 : 0;
+}
+
+bool KeyframeIndex::scan(const QString &mediaPath, std::vector<int64_t> &ts, std::vector<int64_t> &pos)
+{
+    AVFormatContext *fmt_ctx = avformat_alloc_context();
+    if (!fmt_ctx) {
+        return false;
+    }
+    fmt_ctx->interrupt_callback.callback = scan_interrupt;
+    fmt_ctx->interrupt_callback.opaque = &m_abort;
+    if (avformat_open_input(&fmt_ctx, mediaPath.toUtf8().data(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 与player一致，取第一个视频流
+    int video_index = -1;
+    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+        if (video_index == -1 && fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            video_index = i;
+        } else {
+            fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    if (video_index == -1) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> keys;
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = nullptr;
+    pkt.size = 0;
+    while (!m_abort && av_read_frame(fmt_ctx, &pkt) >= 0) {
+        if (pkt.stream_index == video_index && (pkt.flags & AV_PKT_FLAG_KEY)) {
+            int64_t t = pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+            if (t != AV_NOPTS_VALUE) {
+                keys.push_back(std::make_pair(t, pkt.pos));
+            }
+        }
+        av_packet_unref(&pkt);
+    }
+    avformat_close_input(&fmt_ctx);
+    if (m_abort) {
+        return false;
+    }
+
+    std::sort(keys.begin(), keys.end());
+    ts.clear();
+    pos.clear();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ts.push_back(keys[i].first);
+        pos.push_back(keys[i].second);
+    }
+    return true;
+}
+
+QString KeyframeIndex::sidecarPath(const QString &mediaPath)
+{
+    return mediaPath + ".kfidx";
+}
+
+bool KeyframeIndex::load(const QString &mediaPath, qint64 size, qint64 mtime,
+                         std::vector<int64_t> &ts, std::vector<int64_t> &pos)
+{
+    QFile file(sidecarPath(mediaPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0, count = 0;
+    qint64 fileSize = 0, fileMtime = 0;
+    in >> magic >> version >> fileSize >> fileMtime >> count;
+    // 媒体文件已变化，索引作废
+    if (in.status() != QDataStream::Ok || magic != kSidecarMagic || version != kSidecarVersion ||
+        fileSize != size || fileMtime != mtime) {
+        return false;
+    }
+    ts.resize(count);
+    pos.resize(count);
+    for (quint32 i = 0; i < count; ++i) {
+        qint64 t = 0, p = 0;
+        in >> t >> p;
+        ts[i] = t;
+        pos[i] = p;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+void KeyframeIndex::save(const QString &mediaPath, qint64 size, qint64 mtime,
+                         const std::vector<int64_t> &ts, const std::vector<int64_t> &pos)
+{
+    // 媒体所在目录不可写时只在内存里用，不影响跳转
+    QSaveFile file(sidecarPath(mediaPath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "[KeyframeIndex] can not write" << sidecarPath(mediaPath);
+        return;
+    }
+    QDataStream out(&file);
+    out << kSidecarMagic << kSidecarVersion << size << mtime << static_cast<quint32>(ts.size());
+    for (size_t i = 0; i < ts.size(); ++i) {
+        out << static_cast<qint64>(ts[i]) << static_cast<qint64>(pos[i]);
+    }
+    file.commit();
+}
@@ -0,0 +1,48 @@
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 视频关键帧索引
+// 打开文件时在后台线程只读包、不解码地扫描一遍，记录每个关键帧的时间戳和字节位置；
+// 结果保存在媒体文件旁边的 "<文件名>.kfidx"，文件大小/修改时间不变时直接载入。
+// 跳转时据此直接定位到目标前的关键帧，只需解码该GOP内目标之前的帧
+class KeyframeIndex
+{
+public:
+    KeyframeIndex();
+    ~KeyframeIndex();
+
+    // 为文件建立索引（会先取消上一次未完成的构建），立即返回
+    void build(const QString &mediaPath);
+    void cancel();
+    bool isReady() const;
+
+    // 查找不晚于ts的最后一个关键帧，时间戳均为所索引视频流的时间基
+    // 索引未就绪或ts早于第一个关键帧时返回false
+    bool keyframeBefore(int64_t ts, int64_t &keyTs, int64_t &keyPos) const;
+
+private:
+    void run(const QString &mediaPath, qint64 size, qint64 mtime);
+    bool scan(const QString &mediaPath, std::vector<int64_t> &ts, std::vector<int64_t> &pos);
+    static QString sidecarPath(const QString &mediaPath);
+    static bool load(const QString &mediaPath, qint64 size, qint64 mtime,
+                     std::vector<int64_t> &ts, std::vector<int64_t> &pos);
+    static void save(const QString &mediaPath, qint64 size, qint64 mtime,
+                     const std::vector<int64_t> &ts, const std::vector<int64_t> &pos);
+
+    std::thread m_thread;
+    std::atomic<bool> m_abort;
+
+    mutable std::mutex m_mtx;
+    bool m_ready = false;
+    std::vector<int64_t> m_ts;   // 按时间戳升序
+    std::vector<int64_t> m_pos;  // 与m_ts一一对应，未知为-1
+};
+
+#endif // KEYFRAMEINDEX_H
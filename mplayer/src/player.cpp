@@ -1,6 +1,9 @@
 #include "player.h"
 #include <QDebug>
 
+// 录制开始后用于池预热的帧数，之后逐帧应零分配
+static const int64_t kRecordWarmupFrames = 30;
+
 player::player(QObject *parent) : QObject(parent)
 {
     avdevice_register_all();
@@ -10,6 +13,7 @@ player::player(QObject *parent) : QObject(parent)
 player::~player()
 {
     stop();
+    m_kfIndex.cancel();
     if (ctx->sws_ctx) sws_freeContext(ctx->sws_ctx);
     if (ctx->video_decode_ctx) avcodec_free_context(&ctx->video_decode_ctx);
     if (ctx->fmt_ctx) avformat_close_input(&ctx->fmt_ctx);
@@ -83,9 +87,41 @@ int player::ffplayer_open(const QString& inputPath, bool isDevice)
     if (avcodec_open2(ctx->video_decode_ctx, codec, nullptr) < 0) return -1;
 
     ctx->frame = av_frame_alloc();
+
+    // 本地文件在后台建立关键帧索引，供跳转使用
+    if (!isDevice) {
+        m_kfIndex.build(path);
+    }
     return 0;
 }
 
+void player::doSeek()
+{
+    AVStream *st = ctx->fmt_ctx->streams[ctx->video_index];
+    int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+    int64_t target = start + av_rescale_q(m_seek_target, {1, 1000}, st->time_base);
+
+    // 有索引时直接落到目标前的关键帧；TS这类没有内建索引的格式按字节位置跳
+    bool done = false;
+    int64_t key_ts = 0, key_pos = -1;
+    if (m_kfIndex.keyframeBefore(target, key_ts, key_pos)) {
+        const AVInputFormat *ifmt = ctx->fmt_ctx->iformat;
+        if (key_pos >= 0 && (ifmt->flags & AVFMT_TS_DISCONT) && !(ifmt->flags & AVFMT_NO_BYTE_SEEK)) {
+            done = av_seek_frame(ctx->fmt_ctx, ctx->video_index, key_pos, AVSEEK_FLAG_BYTE) >= 0;
+        }
+        if (!done) {
+            done = av_seek_frame(ctx->fmt_ctx, ctx->video_index, key_ts, AVSEEK_FLAG_BACKWARD) >= 0;
+        }
+    }
+    if (!done) {
+        done = av_seek_frame(ctx->fmt_ctx, ctx->video_index, target, AVSEEK_FLAG_BACKWARD) >= 0;
+    }
+    if (done) {
+        avcodec_flush_buffers(ctx->video_decode_ctx);
+        m_skip_until = target;
+    }
+}
+
 void player::ffplayer_read_frame()
 {
     if (m_paused && !m_seek_req) {
@@ -95,10 +131,7 @@ void player::ffplayer_read_frame()
     {
         std::lock_guard<std::mutex> lock(m_ctrl_mtx);
         if (m_seek_req) {
-            int64_t seek_target = av_rescale_q(m_seek_target * 1000, {1, AV_TIME_BASE}, ctx->fmt_ctx->streams[ctx->video_index]->time_base);
-            if (av_seek_frame(ctx->fmt_ctx, ctx->video_index, seek_target, AVSEEK_FLAG_BACKWARD) >= 0) {
-                avcodec_flush_buffers(ctx->video_decode_ctx);
-            }
+            doSeek();
             m_seek_req = false;
         }
     }
@@ -109,7 +142,16 @@ void player::ffplayer_read_frame()
         if (pkt.stream_index == ctx->video_index) {
             if (avcodec_send_packet(ctx->video_decode_ctx, &pkt) == 0) {
                 while (avcodec_receive_frame(ctx->video_decode_ctx, ctx->frame) == 0) {
-                    
+                    // 跳转后未到目标的帧不转换、不显示
+                    if (m_skip_until != AV_NOPTS_VALUE) {
+                        int64_t pts = ctx->frame->best_effort_timestamp;
+                        if (pts == AV_NOPTS_VALUE) pts = ctx->frame->pts;
+                        if (pts != AV_NOPTS_VALUE && pts < m_skip_until) {
+                            continue;
+                        }
+                        m_skip_until = AV_NOPTS_VALUE;
+                    }
+
                     int dw = ctx->video_decode_ctx->width;
                     int dh = ctx->video_decode_ctx->height;
 
@@ -159,11 +201,8 @@ void player::ffplayer_read_frame()
                     }
 
                     if (is_rec && out_codec && out_fmt) {
-                        AVFrame* outFrame = av_frame_alloc();
-                        outFrame->format = AV_PIX_FMT_YUV420P;
-                        outFrame->width = dw;
-                        outFrame->height = dh;
-                        if (av_frame_get_buffer(outFrame, 32) == 0) {
+                        AVFrame* outFrame = m_recordPool.video(dw, dh, AV_PIX_FMT_YUV420P);
+                        if (outFrame) {
                             static struct SwsContext* record_sws = nullptr;
                             record_sws = sws_getCachedContext(record_sws, dw, dh, AV_PIX_FMT_RGBA,
                                                               dw, dh, AV_PIX_FMT_YUV420P,
@@ -177,6 +216,9 @@ void player::ffplayer_read_frame()
                                 std::lock_guard<std::mutex> lock(m_record_mtx);
                                 if (m_recording) { // 再次检查确保没被停止
                                     outFrame->pts = m_frame_count++;
+                                    if (m_frame_count == kRecordWarmupFrames) {
+                                        m_recordSteadyBase = FramePool::allocCount();
+                                    }
                                     if (avcodec_send_frame(out_codec, outFrame) == 0) {
                                         AVPacket outPkt;
                                         av_init_packet(&outPkt);
@@ -190,7 +232,7 @@ void player::ffplayer_read_frame()
                                 }
                             }
                         }
-                        av_frame_free(&outFrame);
+                        m_recordPool.recycle(outFrame);
                     }
                     // --- 录制逻辑结束 ---
 
@@ -366,6 +408,8 @@ int player::startRecord(const QString &outputPath)
 
     m_recording = true;
     m_frame_count = 0;
+    m_recordAllocBase = FramePool::allocCount();
+    m_recordSteadyBase = -1;
     return 0;
 }
 
@@ -376,6 +420,17 @@ void player::stopRecord()
 
     m_recording = false;
     av_write_trailer(m_outFmtCtx);
+    qDebug() << "[record] frames:" << m_frame_count
+             << "buffer allocs:" << (FramePool::allocCount() - m_recordAllocBase);
+    // 稳态零分配自检：预热后仍有分配说明帧池失效（录制是FramePool唯一的使用者，计数不受干扰）。
+    // 只告警不断言：录制中设备分辨率变化时帧池按新尺寸重建，这种分配是正常的
+    if (m_recordSteadyBase >= 0) {
+        int64_t steadyAllocs = FramePool::allocCount() - m_recordSteadyBase;
+        if (steadyAllocs != 0) {
+            qWarning() << "[record] steady-state buffer allocs:" << steadyAllocs
+                       << "over" << (m_frame_count - kRecordWarmupFrames) << "frames, frame pool fair";
+        }
+    }
     
     if (m_outCodecCtx) {
         avcodec_free_context(&m_outCodecCtx);
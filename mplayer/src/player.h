@@ -5,6 +5,8 @@
 #include <vector>
 #include <mutex>
 #include "mdevice.h"
+#include "keyframeindex.h"
+#include "framepool.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -61,11 +63,16 @@ signals:
 
 
 private:
+    // 处理跳转请求，调用时持有m_ctrl_mtx
+    void doSeek();
+
     FFPlayerContext *ctx;
     bool m_paused = false;
     bool m_seek_req = false;
     int64_t m_seek_target = 0;
     std::mutex m_ctrl_mtx;
+    KeyframeIndex m_kfIndex;
+    int64_t m_skip_until = AV_NOPTS_VALUE; // 跳转目标（视频流时间基），之前的帧只解码不显示
 
     // 录制相关
     AVFormatContext* m_outFmtCtx = nullptr;
@@ -75,6 +82,9 @@ private:
 
     int64_t m_frame_count = 0;
     std::mutex m_record_mtx;
+    FramePool m_recordPool;           // 录制帧复用，不再每帧分配
+    int64_t m_recordAllocBase = 0;    // 开始录制时的分配计数
+    int64_t m_recordSteadyBase = -1;  // 预热kRecordWarmupFrames帧后的分配计数，之后应不再增长
 };
 
 